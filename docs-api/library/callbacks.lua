@@ -3,11 +3,11 @@
 --- Callback, called once at the start of the program.
 --- @alias smgf.init fun()
 
---- Callback, called every frame before `smgf.draw`. "dt" represents the seconds since the last call to `smgf.update`. All game updates should be done there.
+--- Callback, called every frame before `smgf.draw`. "dt" represents the seconds since the last call to `smgf.update`. All game updates should be done there. If an update rate is set (see `smgf.system.set_update_rate`), it is instead called zero or more times per frame, with a fixed "dt".
 --- @alias smgf.update fun(dt: number)
 
---- Callback, called every frame after `smgf.update`. All drawing operations should be done here.
---- @alias smgf.draw fun()
+--- Callback, called every frame after `smgf.update`. All drawing operations should be done here. If an update rate is set, "alpha" (between 0 and 1) is the fraction of an update that has elapsed since the last call to `smgf.update`, which can be used to interpolate positions between the last two updates. Otherwise, it is always 1.
+--- @alias smgf.draw fun(alpha: number)
 
 --- Callback, called on mouse release. The button number can be either 1 (left button), 2 (middle button) or 3 (right button).
 --- @see smgf.mouse_down
@@ -113,6 +113,37 @@
 --- parameter is in the range [-1;1].
 --- @alias smgf.gamepad_axismotion fun(player_index: SMGFPlayerIndex, axis: SMGFGamepadAxis, value: number)
 
+--- An input event given to `smgf.events`. "type" is the name of the callback
+--- that would otherwise be called, and the other fields are its arguments:
+--- - "key_down", "key_up": key, mod (a bitmask, see `smgf.keyboard.mods`)
+--- - "text_input": text
+--- - "mouse_down", "mouse_up": x, y, button
+--- - "mouse_moved": x, y, dx, dy
+--- - "mouse_wheel": x, y
+--- - "gamepad_down", "gamepad_up": player, button
+--- - "gamepad_axismotion": player, axis, value
+--- @class SMGFEvent
+--- @field type string
+--- @field key string?
+--- @field mod integer?
+--- @field text string?
+--- @field x number?
+--- @field y number?
+--- @field dx number?
+--- @field dy number?
+--- @field button number|SMGFGamepadButton?
+--- @field player SMGFPlayerIndex?
+--- @field axis SMGFGamepadAxis?
+--- @field value number?
+
+--- Callback, called once per frame (before `smgf.update`) with the input
+--- events of the frame, when defined. The callbacks of these events
+--- (`smgf.key_down`, `smgf.mouse_moved`...) are then not called. Consecutive
+--- mouse motions, and motions of the same gamepad axis, are merged into one
+--- event. The list and the event tables are reused by the next frames, so they
+--- must not be kept.
+--- @alias smgf.events fun(events: SMGFEvent[])
+
 --- Callback, called on SDL_RENDER_TARGETS_RESET event.
 --- @alias smgf.targets_reset fun()
 
@@ -10,6 +10,15 @@ smgf = {}
 --- @field height number? Window height in pixels
 --- @field window_title string? Window title name
 --- @field fps number? FPS limiting of the game (set to 0 to disable FPS limiting)
+--- @field update_rate number? Fixed updates per second (set to 0 to call `smgf.update` once per frame)
+--- @field stats_overlay boolean? Whether the frame time overlay is shown at startup (toggled with F3)
+--- @field lua_allocator "pool" | "system" | nil Memory allocator of Lua: pools of small blocks (default), or the system allocator
+--- @field gc_mode "incremental" | "generational" | nil Mode of the Lua garbage collector (defaults to "incremental")
+--- @field gc_pause number? Garbage collector pause, in % (see the Lua manual)
+--- @field gc_stepmul number? Garbage collector step multiplier, in % (see the Lua manual)
+--- @field gc_budget number? Max time (in seconds) of the garbage collection made by SMGF at the end of each frame, in the time left before the next frame. The Lua collector is then stopped (`collectgarbage("isrunning")` is false), and only restarted while the idle time is too short to keep up (defaults to 0.001, 0 to let Lua collect only while allocating)
+--- @field preload boolean? Whether to load the game archive (a `.smgf` file) in memory at startup, so that its files are read without accessing the disk (it is memory-mapped when the system allows it). Defaults to false, also enabled by the `--preload` option
+--- @field read_ahead boolean? Whether to read the files of the game in the background at startup, so that they are loaded faster when the game needs them. Defaults to false, also enabled by the `--read-ahead` option
 --- @field zoom number? Zoom of the game
 --- @field cursor_visible boolean? Whether mouse cursor is visible when hovering game window
 --- @field organisation string? Your organisation name
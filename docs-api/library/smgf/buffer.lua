@@ -0,0 +1,83 @@
+--- @meta
+--- @class smgf.buffer
+smgf.buffer = {}
+
+--- The type of the elements of a buffer: unsigned 8-bit integers, signed 16
+--- or 32-bit integers, 32 or 64-bit floating point numbers.
+--- @alias SMGFBufferType
+--- | "u8"
+--- | "i16"
+--- | "i32"
+--- | "f32"
+--- | "f64"
+
+--- A contiguous array of numbers of the same type, which can be passed to
+--- SMGF functions (bulk draw functions, meshes, tilemaps, file writes) without
+--- creating a Lua value per element. Elements are read and written with
+--- `buffer[i]` (starting at 1, nil out of range, so that `ipairs` can be
+--- used), and `#buffer` is the number of elements.
+--- Values written to integer buffers are clamped to the range of the type and
+--- truncated.
+--- @class SMGFBuffer
+local Buffer = {}
+
+--- Returns the element number `i` (starting at 1).
+--- @param i number
+--- @return number value
+function Buffer:get(i) end
+
+--- Sets the element number `i` (starting at 1).
+--- @param i number
+--- @param value number
+function Buffer:set(i, value) end
+
+--- Returns the type of the elements.
+--- @return SMGFBufferType type
+function Buffer:get_type() end
+
+--- Returns the number of elements (same as `#buffer`).
+--- @return number length
+function Buffer:get_length() end
+
+--- Returns the size of the data, in bytes.
+--- @return number size
+function Buffer:get_size() end
+
+--- Returns a view of `count` elements starting at element `first`: a buffer
+--- that shares the data of this buffer (and keeps it alive).
+--- @param first? number The first element, defaults to 1
+--- @param count? number The number of elements, defaults to the rest of the buffer
+--- @return SMGFBuffer view
+function Buffer:slice(first, count) end
+
+--- Sets `count` elements starting at element `first` to `value`.
+--- @param value number
+--- @param first? number The first element, defaults to 1
+--- @param count? number The number of elements, defaults to the rest of the buffer
+function Buffer:fill(value, first, count) end
+
+--- Copies all the elements of `source` into this buffer, starting at element
+--- `first`. Elements are converted if the types of the buffers differ.
+--- @param source SMGFBuffer
+--- @param first? number The first element to write, defaults to 1
+function Buffer:copy(source, first) end
+
+--- Returns the bytes of `count` elements starting at element `first`.
+--- @param first? number The first element, defaults to 1
+--- @param count? number The number of elements, defaults to the rest of the buffer
+--- @return string bytes
+function Buffer:to_string(first, count) end
+
+--- Returns a table of `count` elements starting at element `first`.
+--- @param first? number The first element, defaults to 1
+--- @param count? number The number of elements, defaults to the rest of the buffer
+--- @return number[] elements
+function Buffer:to_table(first, count) end
+
+--- Creates a buffer of `length` elements set to 0, or filled from a table of
+--- numbers, or from the bytes of a string (whose size must be a multiple of
+--- the element size).
+--- @param type SMGFBufferType
+--- @param init number | number[] | string
+--- @return SMGFBuffer buffer
+function smgf.buffer.new(type, init) end
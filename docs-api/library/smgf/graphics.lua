@@ -53,6 +53,105 @@ end
 --- @param filename string The filename (must end with ".bmp")
 function Texture:save(filename) end
 
+--- A batch of sprites sharing the same texture, drawn all at once.
+--- Each call to `add` takes the same parameters as `smgf.graphics.draw` and
+--- captures the current color and translation. The sprites stay in the batch
+--- until `clear` is called, so static batches can be drawn every frame.
+--- @class SMGFBatch
+local Batch = {}
+
+--- Adds a sprite to the batch. The batch grows automatically when full.
+--- @see smgf.graphics.draw For the list of all parameters
+--- @overload fun(self: SMGFBatch, quad: SMGFQuad, x?: number, y?: number, scale_x?: number, scale_y?: number, rotation?: number, origin_x?: number, origin_y?: number, flip?: SMGFFlip): number
+--- @param x? number The position to draw to (X), defaults to 0
+--- @param y? number The position to draw to (Y), defaults to 0
+--- @param scale_x? number Scale value (X), defaults to 1
+--- @param scale_y? number Scale value (Y), defaults to 1
+--- @param rotation? number The rotation in degrees, defaults to 0
+--- @param origin_x? number The origin of the rotation (X), defaults to 0
+--- @param origin_y? number The origin of the rotation (Y), defaults to 0
+--- @param flip? SMGFFlip To flip the texture when drawing, defaults to "none"
+--- @return number count The number of sprites in the batch
+function Batch:add(x, y, scale_x, scale_y, rotation, origin_x, origin_y, flip)
+end
+
+--- Removes all sprites from the batch (its memory is kept for reuse).
+function Batch:clear() end
+
+--- Draws all the sprites of the batch, in a single draw call.
+function Batch:draw() end
+
+--- Returns the number of sprites in the batch.
+--- @return number count
+function Batch:get_count() end
+
+--- Returns the number of sprites the batch can hold before growing.
+--- @return number capacity
+function Batch:get_capacity() end
+
+--- A mesh: a fixed number of vertices (and optionally indices) stored by
+--- smgf, drawn as triangles. Vertices can be updated individually or by range,
+--- so a mesh can be built once and drawn every frame without any allocation.
+--- Texture coordinates ("u" and "v") are normalised between 0 and 1.
+--- @class SMGFMesh
+local Mesh = {}
+
+--- A vertex: x, y, u, v, r, g, b, a. Only x and y are mandatory: texture
+--- coordinates default to 0 and color defaults to the current color.
+--- @alias SMGFVertex number[]
+
+--- Sets the vertex number `i` (starting at 1).
+--- @param i number The vertex number
+--- @param x number Position (X)
+--- @param y number Position (Y)
+--- @param u? number Texture coordinate (X) between 0 and 1, defaults to 0
+--- @param v? number Texture coordinate (Y) between 0 and 1, defaults to 0
+--- @param r? number Red component (0 - 255), defaults to current color
+--- @param g? number Green component (0 - 255), defaults to current color
+--- @param b? number Blue component (0 - 255), defaults to current color
+--- @param a? number Alpha component (0 - 255), defaults to current color
+function Mesh:set_vertex(i, x, y, u, v, r, g, b, a) end
+
+--- Returns the vertex number `i` (starting at 1).
+--- @param i number The vertex number
+--- @return number x, number y, number u, number v, number r, number g, number b, number a
+function Mesh:get_vertex(i) end
+
+--- Sets several vertices at once, starting at vertex number `start`. The
+--- vertices can also be given as a buffer of 8 numbers per vertex (x, y, u,
+--- v, r, g, b, a).
+--- @param vertices SMGFVertex[] | SMGFBuffer The vertices
+--- @param start? number The first vertex to update, defaults to 1
+function Mesh:set_vertices(vertices, start) end
+
+--- Sets several indices at once, starting at index number `start`. Each
+--- index is a vertex number (starting at 1); every three indices form a
+--- triangle. If the mesh has no indices, every three vertices form a triangle.
+--- @param indices number[] | SMGFBuffer The indices
+--- @param start? number The first index to update, defaults to 1
+function Mesh:set_indices(indices, start) end
+
+--- Sets the texture used to draw the mesh, or nil to draw plain triangles.
+--- @param texture SMGFTexture | nil
+function Mesh:set_texture(texture) end
+
+--- Returns the texture used to draw the mesh.
+--- @return SMGFTexture | nil texture
+function Mesh:get_texture() end
+
+--- Returns the number of vertices of the mesh.
+--- @return number count
+function Mesh:get_vertex_count() end
+
+--- Returns the number of indices of the mesh.
+--- @return number count
+function Mesh:get_index_count() end
+
+--- Draws the mesh, offset by `(x, y)`.
+--- @param x? number Offset (X), defaults to 0
+--- @param y? number Offset (Y), defaults to 0
+function Mesh:draw(x, y) end
+
 -- @MARK: graphics module
 
 --- Loads an image into memory, and returns a texture. Note that smgf
@@ -131,6 +230,65 @@ function smgf.graphics.reset_state() end
 --- @param y number
 function smgf.graphics.translate(x, y) end
 
+--- A grid of tiles drawn from a tileset. The map is split into chunks of
+--- 16x16 tiles, each rendered once in an offscreen texture and only rendered
+--- again when one of its tiles changes. Drawing the tilemap only draws the
+--- chunks that are visible, so large maps cost a few draw calls per frame.
+--- @class SMGFTilemap
+local Tilemap = {}
+
+--- Sets the tile at position `(x, y)` (starting at 1).
+--- @param x number Position in the map (X)
+--- @param y number Position in the map (Y)
+--- @param tile? number The tile number in the tileset (0 or nil for no tile)
+function Tilemap:set_tile(x, y, tile) end
+
+--- Returns the tile at position `(x, y)` (starting at 1).
+--- @param x number Position in the map (X)
+--- @param y number Position in the map (Y)
+--- @return number tile The tile number in the tileset (0 if no tile)
+function Tilemap:get_tile(x, y) end
+
+--- Sets a rectangle of tiles, from a table of tile numbers given row by row.
+--- @param tiles number[] | SMGFBuffer The tile numbers
+--- @param x? number Position of the rectangle in the map (X), defaults to 1
+--- @param y? number Position of the rectangle in the map (Y), defaults to 1
+--- @param width? number Width of the rectangle, defaults to the rest of the row
+function Tilemap:set_tiles(tiles, x, y, width) end
+
+--- Returns the dimensions of the map, in tiles.
+--- @return number width
+--- @return number height
+function Tilemap:get_dimensions() end
+
+--- Returns the dimensions of a tile, in pixels.
+--- @return number width
+--- @return number height
+function Tilemap:get_tile_size() end
+
+--- Draws the tilemap at `(x, y)`, using the current color.
+--- @param x? number The position to draw to (X), defaults to 0
+--- @param y? number The position to draw to (Y), defaults to 0
+function Tilemap:draw(x, y) end
+
+--- A static text, rendered once with the internal debug font.
+--- @class SMGFText
+local Text = {}
+
+--- Returns the dimensions of the text, in pixels.
+--- @return number width
+--- @return number height
+function Text:get_dimensions() end
+
+--- Returns the string of the text.
+--- @return string
+function Text:get_text() end
+
+--- Draws the text at `(x, y)`, using the current color.
+--- @param x? number The position to draw to (X), defaults to 0
+--- @param y? number The position to draw to (Y), defaults to 0
+function Text:draw(x, y) end
+
 --- Returns the current drawing origin.
 --- @return number x
 --- @return number y
@@ -146,6 +304,13 @@ function smgf.graphics.set_translation(x, y) end
 --- @param filename string The filename (must end with ".bmp")
 function smgf.graphics.screenshot(filename) end
 
+--- Returns the number of renderer state changes (draw color, blend mode,
+--- texture color/alpha mod, render target) sent to the GPU driver since
+--- startup, and the number of redundant state changes that were skipped.
+--- @return number issued Number of state changes sent to the renderer
+--- @return number skipped Number of redundant state changes skipped
+function smgf.graphics.get_state_changes() end
+
 --- @alias SMGFFlip
 --- | "none"
 --- | "horizontal"
@@ -172,6 +337,40 @@ function smgf.graphics.screenshot(filename) end
 function smgf.graphics.draw(texture, x, y, scale_x, scale_y, rotation,
     origin_x, origin_y, flip) end
 
+--- Creates a new sprite batch, to draw many parts of the same texture in a
+--- single draw call.
+--- @param texture SMGFTexture The texture used by all sprites of the batch
+--- @param capacity? number The number of sprites to preallocate, defaults to 128
+--- @return SMGFBatch
+function smgf.graphics.new_batch(texture, capacity) end
+
+--- Creates a new mesh with a fixed number of vertices and indices.
+--- @see SMGFMesh
+--- @param nb_vertices number The number of vertices
+--- @param nb_indices? number The number of indices, defaults to 0 (no indices)
+--- @return SMGFMesh
+function smgf.graphics.new_mesh(nb_vertices, nb_indices) end
+
+--- Creates a new tilemap of `map_width` x `map_height` tiles, taken from a
+--- tileset texture. Tiles are numbered from 1, left to right then top to
+--- bottom in the tileset; 0 means "no tile".
+--- @see SMGFTilemap
+--- @param tileset SMGFTexture The texture containing the tiles
+--- @param tile_width number The width of a tile in pixels
+--- @param tile_height number The height of a tile in pixels
+--- @param map_width number The width of the map, in tiles
+--- @param map_height number The height of the map, in tiles
+--- @return SMGFTilemap
+function smgf.graphics.new_tilemap(tileset, tile_width, tile_height, map_width,
+    map_height) end
+
+--- Creates a text drawn with the internal debug font. The text is rendered
+--- once in a texture, and is then as cheap to draw as a texture.
+--- @see SMGFText
+--- @param text string The text (encoded in ISO-8859-1)
+--- @return SMGFText
+function smgf.graphics.new_text(text) end
+
 --- Returns the color a single point on texture (or screen).
 --- **WARNING**: for testing uses only, do not use this function.
 --- @param x number
@@ -207,8 +406,43 @@ function smgf.graphics.draw_rect(x, y, width, height) end
 --- @param height number The height of the rectangle
 function smgf.graphics.draw_rectfill(x, y, width, height) end
 
+--- Draws many points at once. Points are passed as a flat array of
+--- coordinates: `{x1, y1, x2, y2, ...}`. Optionally, a color can be given for
+--- each point as a flat array of RGBA components: `{r1, g1, b1, a1, ...}`.
+--- Otherwise the current color is used. The arrays of this function and of
+--- the other bulk draw functions can also be buffers: "f32" coordinates and
+--- "u8" colors are then used without being copied.
+--- @param points number[] | SMGFBuffer The coordinates of the points
+--- @param colors? number[] | SMGFBuffer The colors of the points (4 components per point)
+function smgf.graphics.draw_points(points, colors) end
+
+--- Draws connected lines going through all points, passed as a flat array of
+--- coordinates: `{x1, y1, x2, y2, ...}`. Optionally, a color can be given for
+--- each point as a flat array of RGBA components: each segment is drawn with
+--- the color of its first point.
+--- @param points number[] | SMGFBuffer The coordinates of the points
+--- @param colors? number[] | SMGFBuffer The colors of the points (4 components per point)
+function smgf.graphics.draw_lines(points, colors) end
+
+--- Draws many rectangles at once. Rectangles are passed as a flat array:
+--- `{x1, y1, width1, height1, x2, y2, ...}`. Optionally, a color can be given
+--- for each rectangle as a flat array of RGBA components.
+--- @param rects number[] | SMGFBuffer The positions and sizes of the rectangles
+--- @param colors? number[] | SMGFBuffer The colors of the rectangles (4 components each)
+function smgf.graphics.draw_rects(rects, colors) end
+
+--- Draws many filled rectangles at once, in a single draw call. Rectangles are
+--- passed as a flat array: `{x1, y1, width1, height1, x2, y2, ...}`.
+--- Optionally, a color can be given for each rectangle as a flat array of RGBA
+--- components.
+--- @param rects number[] | SMGFBuffer The positions and sizes of the rectangles
+--- @param colors? number[] | SMGFBuffer The colors of the rectangles (4 components each)
+function smgf.graphics.draw_rectfills(rects, colors) end
+
 --- Draws text using an internal debug font.
---- Meant as a quick way to display debug info on screen.
+--- Meant as a quick way to display debug info on screen. Strings drawn on
+--- several frames are cached in textures, see `smgf.graphics.new_text` for
+--- strings known to be static.
 --- @param x number The position to draw to (X)
 --- @param y number The position to draw to (Y)
 --- @param color number Expects a number between 0-15 (CGA 16-color palette). Pass `0x0F` to draw text in white with transparent background.
@@ -216,7 +450,9 @@ function smgf.graphics.draw_rectfill(x, y, width, height) end
 function smgf.graphics.print_color(x, y, color, text) end
 
 --- Draws text using an internal debug font, using SMGF current color.
---- Meant as a quick way to display debug info on screen.
+--- Meant as a quick way to display debug info on screen. Strings drawn on
+--- several frames are cached in textures, see `smgf.graphics.new_text` for
+--- strings known to be static.
 --- @param x number The position to draw to (X)
 --- @param y number The position to draw to (Y)
 --- @param text string The text to draw (encoded in ISO-8859-1)
@@ -23,6 +23,13 @@ function smgf.keyboard.set_textinput(enabled) end
 --- @return boolean enabled
 function smgf.keyboard.get_textinput() end
 
+--- Bits of the key modifiers of the "key_down" and "key_up" events given to
+--- `smgf.events`, e.g. `ev.mod & smgf.keyboard.mods.ctrl ~= 0`. "shift",
+--- "ctrl", "alt" and "gui" are set when either the left or the right key is
+--- pressed.
+--- @type table<SMGFKeyMod|"shift"|"ctrl"|"alt"|"gui", integer>
+smgf.keyboard.mods = {}
+
 --- @class smgf.mouse
 smgf.mouse = {}
 
@@ -27,16 +27,41 @@ function File:rewind() end
 function File:tell() end
 
 --- Reads from a file. Pass "all" to read all file at once, "line" to read
---- the current line, or a number to read an arbitrary number of bytes from file.
+--- the current line (with its end of line), "number" to read a number (as
+--- `io.read("n")` in Lua, it returns nil if the next characters are not a
+--- number), or a number to read an arbitrary number of bytes from file.
+--- Files are read by blocks, so small reads are fast.
 --- Make sure the file was opened with "r" flag or it will trigger an error.
---- @overload fun(file: SMGFFile, nb_bytes: number)
+--- @overload fun(file: SMGFFile, nb_bytes: number): string
+--- @overload fun(file: SMGFFile, mode: "number"): number?
 --- @param mode "all" | "line" Whether to read the current line in file, or the whole file.
 --- @return string
 function File:read(mode) end
 
---- Writes a string to a file.
+--- Returns an iterator on the remaining lines of a file, without their end of
+--- line, for use in a `for` loop:
+--- ```lua
+--- for line in file:lines() do
+---   print(line)
+--- end
+--- ```
+--- Make sure the file was opened with "r" flag or it will trigger an error.
+--- @return fun(): string?
+function File:lines() end
+
+--- Reads bytes from a file directly into a buffer, without creating a string:
+--- up to `count` elements starting at element `first`. Only whole elements are
+--- read. Make sure the file was opened with "r" flag or it will trigger an
+--- error.
+--- @param buffer SMGFBuffer
+--- @param first? number The first element to write, defaults to 1
+--- @param count? number The number of elements, defaults to the rest of the buffer
+--- @return number count The number of elements read (less than requested at the end of the file)
+function File:read_into(buffer, first, count) end
+
+--- Writes a string, or the bytes of a buffer, to a file.
 --- Make sure the file was opened with "w" flag or it will trigger an error.
---- @param data string The data to write to file
+--- @param data string | SMGFBuffer The data to write to file
 function File:write(data) end
 
 --- Flushs a buffered file.
@@ -51,6 +76,40 @@ function File:flush() end
 --- @return SMGFFile
 function smgf.io.open(filename, mode) end
 
+--- Loads a whole file in a "u8" buffer, without creating a string. Large files
+--- which are not in an archive or in the write directory are mapped in memory,
+--- so they are loaded lazily by the system (modifying the buffer does not
+--- change the file).
+--- @param filename string The filename to load
+--- @return SMGFBuffer buffer
+function smgf.io.load(filename) end
+
+--- Reads a whole file in a "u8" buffer on a worker thread, so that the game
+--- does not wait for the disk. The callback is called at the start of a next
+--- frame (after the input events), with the buffer, or nil and an error
+--- message. At most 64 requests can wait for their callback.
+--- @param filename string The filename to read
+--- @param callback fun(buffer: SMGFBuffer?, error: string?)
+--- @return number id The request, which can be cancelled with `smgf.io.cancel`
+function smgf.io.read_async(filename, callback) end
+
+--- Writes a string, or the bytes of a buffer, to a file on a worker thread.
+--- The data is copied, so it can be changed after the call. The callback is
+--- called at the start of a next frame (after the input events), with true,
+--- or nil and an error message. At most 64 requests can wait for their
+--- callback.
+--- @param filename string The filename to write
+--- @param data string | SMGFBuffer The data to write to file
+--- @param callback? fun(ok: boolean?, error: string?)
+--- @return number id The request, which can be cancelled with `smgf.io.cancel`
+function smgf.io.write_async(filename, data, callback) end
+
+--- Cancels an asynchronous request: its callback will not be called. A request
+--- which is already running completes (a file may be partially written).
+--- @param id number The request returned by `smgf.io.read_async` or `smgf.io.write_async`
+--- @return boolean cancelled false if the callback was already called or the request was cancelled
+function smgf.io.cancel(id) end
+
 --- Creates a directory.
 --- @param dirname string The directory to create
 function smgf.io.mkdir(dirname) end
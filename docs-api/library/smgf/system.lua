@@ -14,9 +14,82 @@ function smgf.system.get_platform() end
 function smgf.system.sleep(seconds) end
 
 --- Returns the delta time sent to the most recent call of `smgf.update`.
+--- It is measured with a nanosecond precision.
 --- @return number dt Delta time in seconds
 function smgf.system.get_dt() end
 
+--- Returns the average duration of the last frames (up to 1024) and its
+--- variance, which measures how irregular the frames are.
+--- @return number mean Average frame time in seconds
+--- @return number variance Variance of the frame time in seconds²
+function smgf.system.get_frame_time() end
+
+--- @class SMGFStats
+--- @field update_time number Time spent in `smgf.update` (in seconds)
+--- @field draw_time number Time spent in `smgf.draw` (in seconds)
+--- @field present_time number Time spent showing the frame (in seconds)
+--- @field draw_calls number Number of draw calls sent to the renderer
+--- @field texture_binds number Number of draw calls using another texture than the previous one
+--- @field target_switches number Number of times the render target changed
+--- @field state_changes number Number of renderer state changes (color, blend mode...)
+--- @field pcalls number Number of Lua calls made by SMGF (callbacks...)
+--- @field events number Number of input events delivered to `smgf.events`
+--- @field text_cache_hits number Number of strings printed from a texture of the text cache
+--- @field text_cache_misses number Number of strings printed without the text cache (seen for the first time, or rendered again)
+--- @field async_requests number Number of asynchronous file requests whose callback was called (see `smgf.io.read_async`)
+--- @field async_wait_time number Total time these requests waited for a worker thread (in seconds)
+--- @field async_io_time number Total time spent reading or writing the files of these requests (in seconds)
+--- @field async_max_time number Longest time between queuing one of these requests and its completion (in seconds)
+--- @field lua_memory number Size of the Lua heap (in bytes)
+--- @field gc_steps number Number of garbage collection steps made by SMGF
+--- @field gc_time number Time spent in the garbage collection steps made by SMGF (in seconds)
+--- @field allocs number Number of memory blocks allocated by Lua
+--- @field frees number Number of memory blocks freed by Lua
+--- @field heap_live number Bytes allocated by Lua at the end of the frame
+--- @field heap_peak number Maximum number of bytes allocated by Lua since the game started
+
+--- Returns what the last complete frame cost in the engine. The counters are
+--- always maintained, and only copied to a table when calling this function.
+--- @return SMGFStats stats
+function smgf.system.get_stats() end
+
+--- Starts recording a trace of the engine (events, update, draw, present,
+--- loading of files) and of the zones marked with `smgf.system.trace_begin`.
+--- The last 65536 events are kept.
+function smgf.system.start_trace() end
+
+--- Stops recording the trace, and saves it in the write directory, in the
+--- Chrome trace format (it can be opened with `chrome://tracing` or Perfetto).
+--- @param filename string The name of the file to write
+function smgf.system.stop_trace(filename) end
+
+--- Starts a named zone in the trace (does nothing if no trace is recorded).
+--- Names are cut to 31 characters.
+--- @param name string The name of the zone
+function smgf.system.trace_begin(name) end
+
+--- Ends the last zone started with `smgf.system.trace_begin`.
+function smgf.system.trace_end() end
+
+--- Sends an input event to the game, as if it came from the user (e.g. for
+--- tests or replays). The event has the format of those given to
+--- `smgf.events`, and is either queued for it or given to the callback of
+--- the same name. Only key, text and mouse events are supported.
+--- @param event SMGFEvent
+function smgf.system.push_event(event) end
+
+--- Starts sampling the Lua call stack at a fixed interval. Time spent in
+--- SMGF functions is counted in the Lua function that called them.
+--- @param interval? number Time between two samples, in seconds (defaults to 0.001)
+function smgf.system.profiler_start(interval) end
+
+--- Stops the profiler, and saves the samples in the write directory as
+--- "folded stacks" (one line per call stack followed by its number of
+--- samples), which can be turned into a flame graph by tools such as
+--- `flamegraph.pl` or speedscope.
+--- @param filename string The name of the file to write
+function smgf.system.profiler_stop(filename) end
+
 --- Returns whether the full screen mode is enabled.
 --- @return boolean fullscreen Delta Whether fullscreen is enabled or not
 function smgf.system.get_fullscreen() end
@@ -77,6 +150,16 @@ function smgf.system.get_fps() end
 --- @param fps number|nil The fps of the screen (or nil to reset limit)
 function smgf.system.set_fps(fps) end
 
+--- Returns the number of fixed updates per second.
+--- @return number|nil update_rate Updates per second (nil if `smgf.update` is called once per frame)
+function smgf.system.get_update_rate() end
+
+--- Sets the number of fixed updates per second: `smgf.update` is then called
+--- at this rate with a fixed "dt", independently of the frame rate (at most
+--- 5 times per frame, to catch up with slow frames).
+--- @param update_rate number|nil Updates per second (or nil to call `smgf.update` once per frame)
+function smgf.system.set_update_rate(update_rate) end
+
 --- Returns the zoom of the game.
 --- @return number zoom Zoom of the game
 function smgf.system.get_zoom() end
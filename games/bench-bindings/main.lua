@@ -0,0 +1,35 @@
+-- microbenchmark of the cost of calling smgf functions from Lua. Prints the
+-- time per call of a few cheap bindings, minus the time of a call to an empty
+-- Lua function (the cost of the call itself), then quits. Run with:
+--   smgf --headless --frames 1 games/bench-bindings
+
+local NB_CALLS = 1000000
+
+local function empty() end
+
+-- returns the time of one call to f(arg), in nanoseconds
+local function time_per_call(f, arg)
+  local start = os.clock()
+  for _ = 1, NB_CALLS do
+    f(arg)
+  end
+  return (os.clock() - start) * 1e9 / NB_CALLS
+end
+
+---@type smgf.init
+function smgf.init()
+  local tex = smgf.graphics.new(16, 16)
+  local benchmarks = {
+    {"empty Lua function", empty},
+    {"smgf.system.get_width()", smgf.system.get_width},
+    {"texture:get_width()", tex.get_width, tex},
+  }
+
+  local base = time_per_call(empty)
+  for _, b in ipairs(benchmarks) do
+    local t = time_per_call(b[2], b[3])
+    print(string.format("%-28s %7.1f ns/call (%+.1f ns)", b[1], t, t - base))
+  end
+
+  smgf.system.quit()
+end
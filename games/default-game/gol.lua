@@ -4,6 +4,8 @@
 ---@field height number Height (in cells) of the board
 ---@field cells number[] The grid
 ---@field nb_steps number The number of steps
+---@field rects number[] Rectangles of the alive cells, reused by each draw
+---@field nb_rects number Number of values used in rects
 local GameOfLife = {}
 
 ---Creates a new instance
@@ -23,6 +25,8 @@ function GameOfLife:init(width, height)
   self.height = height / self.size
   self.cells = {}
   self.nb_steps = 0
+  self.rects = {}
+  self.nb_rects = 0
 
   self:randomize_cells()
   return self
@@ -30,19 +34,30 @@ end
 
 ---Draws the grid
 function GameOfLife:draw()
-  for i = 0, self.width * self.height do
-    local y = math.floor(i / self.width)
-    local x = i % self.width
+  -- dead cells are the background, alive cells are drawn in a single call
+  smgf.graphics.set_color(0x50, 0x45, 0x9b)
+  smgf.graphics.draw_rectfill(0, 0, self.width * self.size,
+      self.height * self.size)
 
+  -- the table is overwritten in place, so drawing creates no garbage
+  local rects = self.rects
+  local n = 0
+  for i = 0, self.width * self.height - 1 do
     if self.cells[i] == 1 then
-      smgf.graphics.set_color(0x88, 0x7e, 0xcb)
-    else
-      smgf.graphics.set_color(0x50, 0x45, 0x9b)
+      rects[n + 1] = (i % self.width) * self.size
+      rects[n + 2] = math.floor(i / self.width) * self.size
+      rects[n + 3] = self.size
+      rects[n + 4] = self.size
+      n = n + 4
     end
-
-    smgf.graphics.draw_rectfill(x * self.size, y * self.size, self.size,
-        self.size)
   end
+  for i = n + 1, self.nb_rects do
+    rects[i] = nil
+  end
+  self.nb_rects = n
+
+  smgf.graphics.set_color(0x88, 0x7e, 0xcb)
+  smgf.graphics.draw_rectfills(rects)
 end
 
 ---Randomises every cell in the grid
@@ -14,13 +14,103 @@ local run_tests = function()
   end
 end
 
+-- asynchronous requests on a file run in queue order: the second write wins,
+-- and the read queued after them sees it (checked when its callback is
+-- called, during a next frame)
+local check_async_order = function()
+  smgf.system.set_identity("smgf", "smgftestgame")
+  smgf.io.write_async("async_order.txt", "first")
+  smgf.io.write_async("async_order.txt", "second")
+  smgf.io.read_async("async_order.txt", function(b)
+    local ok = b ~= nil and b:to_string() == "second"
+    print("asynchronous requests in queue order: " .. (ok and "ok" or "FAIL"))
+    success = success and ok
+    smgf.io.delete("async_order.txt")
+  end)
+end
+
+-- the game can set a metatable on the smgf table: its callbacks are then
+-- moved back to it, and read from it each frame. Checked by the updates of
+-- the first frames: the callbacks can still be read, and a new draw callback
+-- is called.
+local metatable_frames = 0
+local new_draw_called = false
+
+local check_callbacks_metatable = function()
+  metatable_frames = metatable_frames + 1
+  if metatable_frames == 1 then
+    local ok = rawget(smgf, "update") ~= nil and smgf.draw ~= nil
+    success = success and ok
+    local draw = smgf.draw
+    smgf.draw = function()
+      new_draw_called = true
+      draw()
+    end
+  elseif metatable_frames == 3 then
+    local result = new_draw_called and "ok" or "FAIL"
+    print("callbacks with a metatable: " .. result)
+    success = success and new_draw_called
+  end
+end
+
+-- input events pushed during a frame are given to smgf.events once, at the
+-- start of the next frame (checked by the update of the first frame)
+local nb_events_calls = 0
+local nb_events_pushed = 0
+
+local push_events = function()
+  smgf.events = function(events)
+    nb_events_calls = nb_events_calls + 1
+    for _, e in ipairs(events) do
+      if e.type == "mouse_down" and e.button == 2 then
+        nb_events_pushed = nb_events_pushed + 1
+      end
+    end
+  end
+  smgf.system.push_event({type = "mouse_down", x = 1, y = 1, button = 2})
+  smgf.system.push_event({type = "mouse_down", x = 2, y = 2, button = 2})
+end
+
+local check_events = function()
+  local ok = nb_events_calls == 1 and nb_events_pushed == 2
+  print("input events delivered once per frame: " .. (ok and "ok" or "FAIL"))
+  success = success and ok
+  smgf.events = nil
+end
+
 ---@type smgf.init
 function smgf.init()
   run_tests()
+  check_async_order()
+  push_events()
+  setmetatable(smgf, {})
 end
 
+-- GC steps made by smgf in the idle time of the first frames (vsync is on
+-- when not headless). The status line printed by smgf.draw is the same on
+-- every frame, so it is drawn from the text cache by then.
+local nb_frames, nb_gc_steps = 0, 0
+
 ---@type smgf.update
 function smgf.update(dt)
+  if metatable_frames == 0 then
+    check_events()
+  end
+  if metatable_frames < 3 then
+    check_callbacks_metatable()
+  end
+  if nb_frames < 60 then
+    nb_frames = nb_frames + 1
+    local stats = smgf.system.get_stats()
+    nb_gc_steps = nb_gc_steps + stats.gc_steps
+    if nb_frames == 60 then
+      print(("GC steps in the first 60 frames: %d"):format(nb_gc_steps))
+      success = success and nb_gc_steps > 0
+      local ok = stats.text_cache_hits > 0
+      print("text drawn from the cache: " .. (ok and "ok" or "FAIL"))
+      success = success and ok
+    end
+  end
 end
 
 ---@type smgf.draw
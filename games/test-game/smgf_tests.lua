@@ -45,6 +45,72 @@ tests.general:test("can load modules", function()
   local mod3 = require "uunit"
 end)
 
+tests.general:test("module resolution follows package.path", function()
+  local path = package.path
+  package.path = "./testfiles/?.lua"
+  package.loaded["testmodule1"] = nil
+  local mod1 = require "testmodule1"
+  assert_equal(mod1.testmoduleno, 1)
+
+  package.path = path
+  package.loaded["testmodule1"] = nil
+  assert_raises(function() require "testmodule1" end)
+end)
+
+tests.general:test("modules are cached as bytecode in the write directory", function()
+  smgf.system.set_identity("smgf", "smgftestgame")
+
+  -- compiled from source, then loaded from the cache
+  for _ = 1, 2 do
+    package.loaded["testfiles.testmodule1"] = nil
+    local mod1 = require "testfiles.testmodule1"
+    assert_equal(mod1.testmoduleno, 1)
+    assert_equal(smgf.io.type(".smgf-cache"), "directory")
+  end
+  package.loaded["testfiles.testmodule1"] = nil
+end)
+
+tests.general:test("cached bytecode is checked against the source", function()
+  smgf.system.set_identity("smgf", "smgftestgame")
+
+  -- same size, most likely the same mtime: only the contents differ
+  for v = 1, 2 do
+    local f = smgf.io.open("cachetest.lua", "w")
+    f:write("return {v = " .. v .. "}")
+    f:close()
+    package.loaded["cachetest"] = nil
+    assert_equal(require("cachetest").v, v)
+  end
+
+  smgf.io.delete("cachetest.lua")
+  package.loaded["cachetest"] = nil
+  smgf.system.set_identity()
+end)
+
+tests.general:test("modules can share directories with the write directory", function()
+  smgf.system.set_identity("smgf", "smgftestgame")
+  smgf.io.mkdir("testfiles")
+  local f = smgf.io.open("testfiles/testmodule1.lua", "w")
+  f:write("return {testmoduleno = 10}")
+  f:close()
+
+  -- the file of the write directory comes first
+  package.loaded["testfiles.testmodule1"] = nil
+  assert_equal(require("testfiles.testmodule1").testmoduleno, 10)
+  package.loaded["testfiles.testmodule2"] = nil
+  assert_equal(require("testfiles.testmodule2").testmoduleno, 2)
+
+  -- the file of the game is found again once it is deleted
+  smgf.io.delete("testfiles/testmodule1.lua")
+  package.loaded["testfiles.testmodule1"] = nil
+  assert_equal(require("testfiles.testmodule1").testmoduleno, 1)
+
+  smgf.io.delete("testfiles")
+  package.loaded["testfiles.testmodule1"] = nil
+  package.loaded["testfiles.testmodule2"] = nil
+  smgf.system.set_identity()
+end)
+
 tests.general:test("some functions from std lib are not available", function()
   -- most of these functions/librairies are removed for security
   assert_equal(io.close, nil)
@@ -71,6 +137,21 @@ tests.general:test("some functions from std lib are not available", function()
   assert_equal(loadfile, nil)
 end)
 
+tests.general:test("callbacks can be reassigned", function()
+  local focus = smgf.focus
+  local function new_focus() end
+  smgf.focus = new_focus
+  assert_equal(smgf.focus, new_focus)
+  assert_nil(rawget(smgf, "focus"))
+  smgf.focus = focus
+  assert_equal(smgf.focus, focus)
+
+  -- other fields are stored in the smgf table
+  smgf.test_field = 1
+  assert_equal(rawget(smgf, "test_field"), 1)
+  smgf.test_field = nil
+end)
+
 --
 -- GRAPHICS
 --
@@ -483,6 +564,390 @@ tests.graphics:test("can draw part of texture", function()
   assert_equal(b, 0)
 end)
 
+tests.graphics:test("can draw multiple points", function()
+  smgf.graphics.set_color(255, 0, 0)
+  smgf.graphics.draw_points({1, 1, 3, 2})
+  smgf.graphics.draw_points({5, 5, 6, 6}, {0, 255, 0, 255, 0, 0, 255, 255})
+
+  local r, g, b = smgf.graphics.get_point(3, 2)
+  assert_equal(r, 255)
+  assert_equal(g, 0)
+  assert_equal(b, 0)
+  r, g, b = smgf.graphics.get_point(5, 5)
+  assert_equal(r, 0)
+  assert_equal(g, 255)
+  assert_equal(b, 0)
+  r, g, b = smgf.graphics.get_point(6, 6)
+  assert_equal(r, 0)
+  assert_equal(g, 0)
+  assert_equal(b, 255)
+end)
+
+tests.graphics:test("can draw multiple lines", function()
+  smgf.graphics.set_color(255, 0, 0)
+  smgf.graphics.draw_lines({0, 0, 10, 0, 10, 10})
+
+  local r, g, b = smgf.graphics.get_point(5, 0)
+  assert_equal(r, 255)
+  r, g, b = smgf.graphics.get_point(10, 5)
+  assert_equal(r, 255)
+  r, g, b = smgf.graphics.get_point(5, 5)
+  assert_equal(r, 0)
+end)
+
+tests.graphics:test("can draw multiple rects", function()
+  smgf.graphics.translate(10, 0)
+  smgf.graphics.draw_rects({0, 0, 5, 5}, {0, 0, 255, 255})
+  smgf.graphics.draw_rectfills({0, 10, 5, 5, 10, 10, 5, 5},
+    {255, 0, 0, 255, 0, 255, 0, 255})
+
+  local r, g, b = smgf.graphics.get_point(10, 2)
+  assert_equal(b, 255)
+  r, g, b = smgf.graphics.get_point(12, 12)
+  assert_equal(r, 255)
+  assert_equal(g, 0)
+  r, g, b = smgf.graphics.get_point(22, 12)
+  assert_equal(r, 0)
+  assert_equal(g, 255)
+end)
+
+tests.graphics:test("can draw multiple rects from buffers", function()
+  local rects = smgf.buffer.new("f32", {0, 10, 5, 5, 10, 10, 5, 5})
+  local colors = smgf.buffer.new("u8", {255, 0, 0, 255, 0, 255, 0, 255})
+  smgf.graphics.draw_rectfills(rects, colors)
+
+  local r, g, b = smgf.graphics.get_point(2, 12)
+  assert_equal(r, 255)
+  assert_equal(g, 0)
+  r, g, b = smgf.graphics.get_point(12, 12)
+  assert_equal(r, 0)
+  assert_equal(g, 255)
+
+  -- with a translation, the buffer is left unchanged
+  smgf.graphics.translate(10, 0)
+  smgf.graphics.draw_rectfills(rects:slice(1, 4))
+  assert_equal(rects[1], 0)
+end)
+
+tests.graphics:test("bulk draw functions check their arguments", function()
+  assert_raises(function()
+    smgf.graphics.draw_points({1, 2, 3})
+  end, "must have 2 components per point (XY)")
+  assert_raises(function()
+    smgf.graphics.draw_rectfills({1, 2, 3, 4, 5})
+  end, "must have 4 components per rectangle (XYWH)")
+  assert_raises(function()
+    smgf.graphics.draw_rects({1, 2, 3, 4}, {255, 255, 255})
+  end, "must have 4 components (RGBA) per primitive")
+  assert_raises(function()
+    smgf.graphics.draw_points({1, 2}, {256, 0, 0, 0})
+  end, "RGBA values must be between 0 and 255")
+end)
+
+tests.graphics:test("can create batch", function()
+  local t = smgf.graphics.new("test.png")
+  local b = smgf.graphics.new_batch(t, 10)
+  assert_equal(b:get_count(), 0)
+  assert_equal(b:get_capacity(), 10)
+end)
+
+tests.graphics:test("new batch expects a texture", function()
+  assert_raises(function()
+    --- @diagnostic disable-next-line: param-type-mismatch
+    smgf.graphics.new_batch(nil)
+  end, "bad argument #1 to 'new_batch' (smgf.texture expected, got nil)")
+end)
+
+tests.graphics:test("batch grows when full", function()
+  local t = smgf.graphics.new("test.png")
+  local b = smgf.graphics.new_batch(t, 1)
+  assert_equal(b:add(0, 0), 1)
+  assert_equal(b:add(10, 0), 2)
+  assert_equal(b:get_count(), 2)
+  assert_true(b:get_capacity() >= 2)
+  b:clear()
+  assert_equal(b:get_count(), 0)
+end)
+
+tests.graphics:test("can draw batch", function()
+  local t = smgf.graphics.new("test.png")
+  local b = smgf.graphics.new_batch(t)
+  b:add(10, 0)
+  -- only draw orange square:
+  b:add({24, 24 * 2, 24, 24}, 100, 0)
+
+  -- nothing is drawn before calling draw:
+  local r, g, b_ = smgf.graphics.get_point(10 + 24, 0)
+  assert_equal(r, 0)
+  assert_equal(g, 0)
+  assert_equal(b_, 0)
+
+  b:draw()
+
+  r, g, b_ = smgf.graphics.get_point(10 + 24, 0)
+  assert_equal(r, 29)
+  assert_equal(g, 43)
+  assert_equal(b_, 83)
+
+  r, g, b_ = smgf.graphics.get_point(100, 0)
+  assert_equal(r, 255)
+  assert_equal(g, 163)
+  assert_equal(b_, 0)
+end)
+
+tests.graphics:test("batch uses color and translation of add", function()
+  local t = smgf.graphics.new("test.png")
+  local b = smgf.graphics.new_batch(t)
+  smgf.graphics.translate(100, 0)
+  smgf.graphics.set_color(255, 0, 255)
+  b:add({24, 24 * 2, 24, 24}, 0, 0)
+  smgf.graphics.set_translation(0, 0)
+  smgf.graphics.set_color(255, 255, 255)
+  b:draw()
+
+  -- orange square modulated by magenta:
+  local r, g, b_ = smgf.graphics.get_point(100, 0)
+  assert_equal(r, 255)
+  assert_equal(g, 0)
+  assert_equal(b_, 0)
+end)
+
+tests.graphics:test("can create mesh", function()
+  local m = smgf.graphics.new_mesh(4, 6)
+  assert_equal(m:get_vertex_count(), 4)
+  assert_equal(m:get_index_count(), 6)
+  assert_nil(m:get_texture())
+end)
+
+tests.graphics:test("mesh vertex count must be positive", function()
+  assert_raises(function()
+    smgf.graphics.new_mesh(0)
+  end, "must be positive and non-zero")
+end)
+
+tests.graphics:test("can set and get mesh vertices", function()
+  smgf.graphics.set_color(10, 20, 30, 40)
+  local m = smgf.graphics.new_mesh(3)
+  m:set_vertex(1, 1, 2, 0.5, 0.25, 255, 0, 0)
+  m:set_vertices({{10, 20}, {30, 40, 1, 1}}, 2)
+
+  local x, y, u, v, r, g, b, a = m:get_vertex(1)
+  assert_equal(x, 1)
+  assert_equal(y, 2)
+  assert_equal(u, 0.5)
+  assert_equal(v, 0.25)
+  assert_equal(r, 255)
+  assert_equal(g, 0)
+  assert_equal(b, 0)
+  assert_equal(a, 255)
+
+  -- color defaults to current color:
+  x, y, u, v, r, g, b, a = m:get_vertex(2)
+  assert_equal(x, 10)
+  assert_equal(y, 20)
+  assert_equal(r, 10)
+  assert_equal(g, 20)
+  assert_equal(b, 30)
+  assert_equal(a, 40)
+
+  assert_raises(function()
+    m:set_vertex(4, 0, 0)
+  end, "vertex out of range")
+  assert_raises(function()
+    m:set_vertices({{0, 0}, {0, 0}}, 3)
+  end, "vertices out of range")
+end)
+
+tests.graphics:test("can set mesh vertices from buffers", function()
+  local m = smgf.graphics.new_mesh(4)
+  local v = smgf.buffer.new("f32", {1, 2, 0, 1, 255, 128, 0, 255})
+  m:set_vertices(v, 4)
+  local x, y, u, _, r, g = m:get_vertex(4)
+  assert_equal(x, 1)
+  assert_equal(y, 2)
+  assert_equal(u, 0)
+  assert_equal(r, 255)
+  assert_equal(g, 128)
+
+  assert_raises(function()
+    m:set_vertices(v, 5)
+  end, "vertices out of range")
+  assert_raises(function()
+    m:set_vertices(v, 100)
+  end, "vertices out of range")
+  assert_raises(function()
+    m:set_vertices(v, 0)
+  end, "vertices out of range")
+end)
+
+tests.graphics:test("mesh indices must be valid vertex numbers", function()
+  local m = smgf.graphics.new_mesh(3, 3)
+  m:set_indices({1, 2, 3})
+  assert_raises(function()
+    m:set_indices({1, 2, 4})
+  end, "indices must be integers between 1 and the vertex count")
+  assert_raises(function()
+    m:set_indices({1}, 4)
+  end, "indices out of range")
+end)
+
+tests.graphics:test("can draw mesh", function()
+  local m = smgf.graphics.new_mesh(4, 6)
+  m:set_vertices({
+    {0, 0, 0, 0, 255, 0, 0},
+    {10, 0, 0, 0, 255, 0, 0},
+    {10, 10, 0, 0, 255, 0, 0},
+    {0, 10, 0, 0, 255, 0, 0},
+  })
+  m:set_indices({1, 2, 3, 3, 4, 1})
+  m:draw(20, 0)
+
+  local r, g, b = smgf.graphics.get_point(25, 5)
+  assert_equal(r, 255)
+  assert_equal(g, 0)
+  assert_equal(b, 0)
+
+  r, g, b = smgf.graphics.get_point(5, 5)
+  assert_equal(r, 0)
+  assert_equal(g, 0)
+  assert_equal(b, 0)
+end)
+
+tests.graphics:test("mesh drawn at an offset sees new vertices", function()
+  local m = smgf.graphics.new_mesh(4, 6)
+  m:set_vertices({{0, 0}, {10, 0}, {10, 10}, {0, 10}})
+  m:set_indices({1, 2, 3, 3, 4, 1})
+  m:draw(20, 0)
+  m:draw(20, 0)
+
+  -- moved and colored after the copy at this offset was made
+  m:set_vertices({
+    {0, 20, 0, 0, 0, 255, 0},
+    {10, 20, 0, 0, 0, 255, 0},
+    {10, 30, 0, 0, 0, 255, 0},
+    {0, 30, 0, 0, 0, 255, 0},
+  })
+  m:draw(20, 0)
+  local r, g, b = smgf.graphics.get_point(25, 25)
+  assert_equal(r, 0)
+  assert_equal(g, 255)
+  assert_equal(b, 0)
+
+  m:draw(40, 0)
+  r, g, b = smgf.graphics.get_point(45, 25)
+  assert_equal(g, 255)
+end)
+
+tests.graphics:test("can draw textured mesh", function()
+  local t = smgf.graphics.new("test.png")
+  local w, h = t:get_dimensions()
+  local m = smgf.graphics.new_mesh(4, 6)
+  m:set_texture(t)
+  assert_equal(m:get_texture(), t)
+  m:set_vertices({{0, 0, 0, 0}, {w, 0, 1, 0}, {w, h, 1, 1}, {0, h, 0, 1}})
+  m:set_indices({1, 2, 3, 3, 4, 1})
+  m:draw()
+
+  local r, g, b = smgf.graphics.get_point(24, 0)
+  assert_equal(r, 29)
+  assert_equal(g, 43)
+  assert_equal(b, 83)
+end)
+
+tests.graphics:test("redundant state changes are skipped", function()
+  smgf.graphics.set_color(1, 2, 3)
+  smgf.graphics.draw_point(0, 0)
+  local issued, skipped = smgf.graphics.get_state_changes()
+
+  smgf.graphics.draw_point(1, 0)
+  smgf.graphics.draw_rectfill(2, 0, 1, 1)
+  local issued2, skipped2 = smgf.graphics.get_state_changes()
+  assert_equal(issued2, issued)
+  assert_equal(skipped2, skipped + 2)
+
+  smgf.graphics.set_color(4, 5, 6)
+  smgf.graphics.draw_point(0, 0)
+  local issued3, skipped3 = smgf.graphics.get_state_changes()
+  assert_equal(issued3, issued2 + 1)
+  assert_equal(skipped3, skipped2)
+end)
+
+tests.graphics:test("texture color mod is only set when it changes", function()
+  local t = smgf.graphics.new("test.png")
+  smgf.graphics.set_color(255, 0, 255)
+  t:draw(0, 0)
+  local issued, skipped = smgf.graphics.get_state_changes()
+  t:draw(0, 0)
+  local issued2, skipped2 = smgf.graphics.get_state_changes()
+  assert_equal(issued2, issued)
+  assert_equal(skipped2, skipped + 2) -- color mod + alpha mod
+
+  -- tinted texture is still drawn with the right color:
+  local r, g, b = smgf.graphics.get_point(24, 0)
+  assert_equal(r, 29)
+  assert_equal(g, 0)
+  assert_equal(b, 83)
+end)
+
+tests.graphics:test("can create tilemap", function()
+  local t = smgf.graphics.new("test.png")
+  local m = smgf.graphics.new_tilemap(t, 24, 24, 100, 50)
+  local w, h = m:get_dimensions()
+  assert_equal(w, 100)
+  assert_equal(h, 50)
+  w, h = m:get_tile_size()
+  assert_equal(w, 24)
+  assert_equal(h, 24)
+  assert_equal(m:get_tile(100, 50), 0)
+end)
+
+tests.graphics:test("can set tilemap tiles", function()
+  local t = smgf.graphics.new("test.png")
+  local m = smgf.graphics.new_tilemap(t, 24, 24, 10, 10)
+  m:set_tile(2, 3, 5)
+  assert_equal(m:get_tile(2, 3), 5)
+  m:set_tiles({1, 2, 3, 4}, 5, 5, 2)
+  assert_equal(m:get_tile(5, 5), 1)
+  assert_equal(m:get_tile(6, 5), 2)
+  assert_equal(m:get_tile(5, 6), 3)
+  assert_equal(m:get_tile(6, 6), 4)
+
+  assert_raises(function()
+    m:set_tile(11, 1, 1)
+  end, "position out of tilemap")
+  assert_raises(function()
+    m:set_tile(1, 1, 16 * 16 + 1)
+  end, "tile not in tileset")
+  assert_raises(function()
+    m:set_tiles({1, 2, 3}, 1, 10, 2)
+  end, "tiles out of tilemap")
+end)
+
+tests.graphics:test("can draw tilemap", function()
+  local t = smgf.graphics.new("test.png")
+  local m = smgf.graphics.new_tilemap(t, 24, 24, 40, 40)
+  m:set_tile(1, 1, 16 * 2 + 2) -- orange square
+  m:draw(10, 0)
+
+  local r, g, b = smgf.graphics.get_point(10, 0)
+  assert_equal(r, 255)
+  assert_equal(g, 163)
+  assert_equal(b, 0)
+  r, g, b = smgf.graphics.get_point(10 + 24, 0)
+  assert_equal(r, 0)
+  assert_equal(g, 0)
+  assert_equal(b, 0)
+
+  -- changing a tile re-renders its chunk:
+  m:set_tile(1, 1, 2)
+  m:draw(10, 0)
+  r, g, b = smgf.graphics.get_point(10, 0)
+  assert_equal(r, 29)
+  assert_equal(g, 43)
+  assert_equal(b, 83)
+  assert_nil(smgf.graphics.get_target())
+end)
+
 tests.graphics:test("default target is nil (= screen)", function()
   assert_nil(smgf.graphics.get_target())
 end)
@@ -652,6 +1117,42 @@ tests.graphics:test("can call print & print_color", function()
   smgf.graphics.print_color(0, 0, 0xf0, "Hello")
 end)
 
+tests.graphics:test("print draws the same on every frame", function()
+  smgf.graphics.clear({0, 0, 0})
+  for _ = 1, 3 do
+    -- drawn directly, then rendered in the text cache, then from the cache
+    smgf.graphics.print(0, 0, "cached", {255, 0, 0})
+    local r, g, b = smgf.graphics.get_point(0, 0)
+    assert_equal(r, 255)
+    assert_equal(g, 0)
+    assert_equal(b, 0)
+    assert_nil(smgf.graphics.get_target())
+  end
+end)
+
+tests.graphics:test("can create text", function()
+  local text = smgf.graphics.new_text("Hello")
+  assert_equal(text:get_text(), "Hello")
+  local w, h = text:get_dimensions()
+  assert_equal(w, 5 * 8)
+  assert_equal(h, 16)
+
+  w, h = smgf.graphics.new_text("ab\ncde"):get_dimensions()
+  assert_equal(w, 3 * 8)
+  assert_equal(h, 2 * 16)
+  w, h = smgf.graphics.new_text(""):get_dimensions()
+  assert_equal(w, 0)
+  assert_equal(h, 0)
+end)
+
+tests.graphics:test("can draw text", function()
+  local text = smgf.graphics.new_text("Hello")
+  text:draw(0, 0)
+  text:draw()
+  smgf.graphics.new_text(""):draw(0, 0)
+  assert_nil(smgf.graphics.get_target())
+end)
+
 --
 -- SYSTEM
 --
@@ -664,6 +1165,7 @@ tests.system.afterEach = function()
   smgf.system.set_dimensions(256, 256)
   smgf.system.set_zoom(1)
   smgf.system.set_fps(nil)
+  smgf.system.set_update_rate(nil)
 end
 
 tests.system:test("can get window width+height", function()
@@ -681,6 +1183,20 @@ tests.system:test("can set window width+height", function()
   assert_equal(smgf.system.get_height(), 310)
 end)
 
+tests.system:test("can get update rate (defaults to nil)", function()
+  assert_equal(smgf.system.get_update_rate(), nil)
+end)
+
+tests.system:test("can set update rate", function()
+  smgf.system.set_update_rate(120)
+  assert_equal(smgf.system.get_update_rate(), 120)
+  smgf.system.set_update_rate()
+  assert_equal(smgf.system.get_update_rate(), nil)
+  assert_raises(function()
+    smgf.system.set_update_rate(-1)
+  end, "must be positive")
+end)
+
 tests.system:test("can get fps limit (defaults to nil)", function()
   assert_equal(smgf.system.get_fps(), nil)
 end)
@@ -729,6 +1245,103 @@ tests.system:test("can get delta time", function()
   assert_type(smgf.system.get_dt(), "number")
 end)
 
+tests.system:test("can get frame stats", function()
+  local stats = smgf.system.get_stats()
+  for _, key in ipairs({
+    "update_time", "draw_time", "present_time", "draw_calls", "texture_binds",
+    "target_switches", "state_changes", "pcalls", "lua_memory", "gc_steps",
+    "allocs", "frees", "heap_live", "heap_peak", "gc_time",
+    "events", "text_cache_hits", "text_cache_misses",
+  }) do
+    assert_type(stats[key], "number")
+  end
+end)
+
+tests.system:test("smgf paces the garbage collector", function()
+  -- stopped: smgf runs its steps in the idle time of frames
+  assert_false(collectgarbage("isrunning"))
+  collectgarbage("step")
+  assert_false(collectgarbage("isrunning"))
+end)
+
+tests.system:test("heap stats follow Lua allocations", function()
+  local stats = smgf.system.get_stats()
+  assert_true(stats.heap_live > 0)
+  assert_true(stats.heap_peak >= stats.heap_live)
+end)
+
+tests.system:test("can record a trace", function()
+  smgf.system.set_identity("smgf", "smgftestgame")
+  smgf.system.start_trace()
+  smgf.system.trace_begin("test \"zone\"")
+  smgf.system.trace_end()
+  smgf.system.stop_trace("trace.json")
+
+  local f = smgf.io.open("trace.json", "r")
+  local contents = f:read("all")
+  f:close()
+  assert_str_in("traceEvents", contents)
+  assert_str_in('"name":"test \\"zone\\""', contents)
+  smgf.io.delete("trace.json")
+end)
+
+tests.system:test("closes the zones still open when a trace stops", function()
+  smgf.system.set_identity("smgf", "smgftestgame")
+  smgf.system.start_trace()
+  smgf.system.trace_begin("open zone")
+  smgf.system.stop_trace("trace.json")
+
+  local f = smgf.io.open("trace.json", "r")
+  local contents = f:read("all")
+  f:close()
+  assert_str_in('"name":"open zone","ph":"B"', contents)
+  assert_str_in('"ph":"E"', contents)
+  smgf.io.delete("trace.json")
+end)
+
+tests.system:test("cannot stop a trace that was not started", function()
+  assert_raises(function() smgf.system.stop_trace("trace.json") end)
+end)
+
+tests.system:test("trace zones do nothing when not tracing", function()
+  smgf.system.trace_begin("zone")
+  smgf.system.trace_end()
+end)
+
+tests.system:test("can profile Lua code", function()
+  smgf.system.set_identity("smgf", "smgftestgame")
+  smgf.system.profiler_start(0.0001)
+  local function busy_function()
+    local x = 0
+    for i = 1, 1000000 do
+      x = x + i % 7
+    end
+    return x
+  end
+  for _ = 1, 5 do
+    busy_function()
+  end
+  smgf.system.profiler_stop("profile.folded")
+
+  local f = smgf.io.open("profile.folded", "r")
+  local contents = f:read("all")
+  f:close()
+  assert_str_in("busy_function", contents)
+  smgf.io.delete("profile.folded")
+end)
+
+tests.system:test("cannot stop the profiler when it is not running", function()
+  assert_raises(function() smgf.system.profiler_stop("profile.folded") end)
+end)
+
+tests.system:test("can get frame time", function()
+  local mean, variance = smgf.system.get_frame_time()
+  assert_type(mean, "number")
+  assert_type(variance, "number")
+  assert_true(mean >= 0)
+  assert_true(variance >= 0)
+end)
+
 tests.system:test("can get and set fullscreen mode", function()
   assert_equal(smgf.system.get_fullscreen(), false)
 end)
@@ -1041,6 +1654,118 @@ tests.input:test("is_down/up on invalid key name", function()
   end, "key 'invalid_key' does not exist")
 end)
 
+tests.input:test("key modifiers bitmask", function()
+  local mods = smgf.keyboard.mods
+  assert_type(mods.lshift, "number")
+  assert_equal(mods.shift, mods.lshift | mods.rshift)
+  assert_equal(mods.ctrl, mods.lctrl | mods.rctrl)
+  assert_equal(mods.lalt & mods.ralt, 0)
+end)
+
+-- pushes events while smgf.events is defined, then wheel events until the
+-- queue is full and delivered at once. Returns the list given to
+-- smgf.events, a copy of it, and the copy without the wheel events added
+-- (here or by a previous call, which leaves one in the queue).
+local function deliver_events(events)
+  local list, copy, nb_calls = nil, {}, 0
+  smgf.events = function(l)
+    list = l
+    nb_calls = nb_calls + 1
+    for i, e in ipairs(l) do
+      copy[i] = e
+    end
+  end
+  for _, e in ipairs(events) do
+    smgf.system.push_event(e)
+  end
+  assert_equal(nb_calls, 0)
+  while nb_calls == 0 do
+    smgf.system.push_event({type = "mouse_wheel", x = 0, y = 0})
+  end
+  smgf.events = nil
+
+  local pushed = {}
+  for _, e in ipairs(copy) do
+    if e.type ~= "mouse_wheel" or e.x ~= 0 or e.y ~= 0 then
+      pushed[#pushed + 1] = e
+    end
+  end
+  return list, copy, pushed
+end
+
+tests.input:test("a full event queue is delivered at once", function()
+  local list, copy = deliver_events({})
+  assert_equal(#list, 256)
+  assert_equal(#copy, 256)
+end)
+
+tests.input:test("queued events are given to smgf.events in order", function()
+  local mods = smgf.keyboard.mods
+  local _, _, events = deliver_events({
+    {type = "key_down", key = "A", mod = mods.lshift},
+    {type = "text_input", text = "é"},
+    {type = "mouse_down", x = 1, y = 2, button = 3},
+    {type = "mouse_wheel", x = 0, y = -1},
+    {type = "key_up", key = "A"},
+  })
+  assert_equal(#events, 5)
+  assert_equal(events[1].type, "key_down")
+  assert_equal(events[1].key, "A")
+  assert_true(events[1].mod & mods.shift ~= 0)
+  assert_equal(events[2].type, "text_input")
+  assert_equal(events[2].text, "é")
+  assert_equal(events[3].type, "mouse_down")
+  assert_equal(events[3].x, 1)
+  assert_equal(events[3].y, 2)
+  assert_equal(events[3].button, 3)
+  assert_equal(events[4].type, "mouse_wheel")
+  assert_equal(events[4].y, -1)
+  assert_equal(events[5].type, "key_up")
+  assert_equal(events[5].mod, 0)
+end)
+
+tests.input:test("consecutive mouse motions are merged", function()
+  local _, _, events = deliver_events({
+    {type = "mouse_moved", x = 1, y = 1, dx = 1, dy = 1},
+    {type = "mouse_moved", x = 2, y = 3, dx = 1, dy = 2},
+    {type = "mouse_moved", x = 5, y = 5, dx = 3, dy = 2},
+    {type = "mouse_down", x = 5, y = 5, button = 1},
+    {type = "mouse_moved", x = 6, y = 6, dx = 1, dy = 1},
+  })
+  assert_equal(#events, 3)
+  assert_equal(events[1].type, "mouse_moved")
+  assert_equal(events[1].x, 5)
+  assert_equal(events[1].y, 5)
+  assert_equal(events[1].dx, 5)
+  assert_equal(events[1].dy, 5)
+  assert_equal(events[2].type, "mouse_down")
+  assert_equal(events[3].type, "mouse_moved")
+  assert_equal(events[3].dx, 1)
+end)
+
+tests.input:test("event tables are reused", function()
+  local list1, _, events1 = deliver_events({
+    {type = "mouse_down", x = 1, y = 1, button = 1},
+  })
+  local down = events1[1]
+  local list2, _, events2 = deliver_events({
+    {type = "mouse_down", x = 2, y = 2, button = 2},
+  })
+  assert_equal(list1, list2)
+  assert_equal(events2[1], down)
+  assert_equal(down.x, 2)
+  assert_equal(down.button, 2)
+end)
+
+tests.input:test("only input events can be pushed", function()
+  assert_raises(function()
+    smgf.system.push_event({type = "draw"})
+  end, "unsupported event type")
+  assert_raises(function()
+    smgf.system.push_event({type = "key_down", key = "not a key"})
+  end, "unknown key")
+end)
+
 tests.input:test("mouse get_x/y", function()
   assert_not_equal(smgf.mouse.get_x(), nil)
   assert_not_equal(smgf.mouse.get_y(), nil)
@@ -1058,6 +1783,111 @@ tests.input:test("mouse is_down", function()
   assert_equal(smgf.mouse.is_down(3), false)
 end)
 
+--
+-- BUFFER
+--
+
+tests.buffer = uunit.newSuite("buffer module")
+
+tests.buffer:test("can create buffers", function()
+  local b = smgf.buffer.new("i16", 4)
+  assert_equal(#b, 4)
+  assert_equal(b:get_type(), "i16")
+  assert_equal(b:get_size(), 8)
+  assert_equal(b[1], 0)
+
+  b = smgf.buffer.new("f64", {1.5, 2, 3})
+  assert_equal(b:get_length(), 3)
+  assert_equal(b[1], 1.5)
+
+  b = smgf.buffer.new("u8", "abc")
+  assert_equal(b[2], string.byte("b"))
+  assert_equal(b:to_string(), "abc")
+
+  assert_raises(function()
+    smgf.buffer.new("u16", 4)
+  end, "invalid option 'u16'")
+  assert_raises(function()
+    smgf.buffer.new("i32", "abc")
+  end, "size must be a multiple of the element size")
+end)
+
+tests.buffer:test("can get and set elements", function()
+  local b = smgf.buffer.new("u8", 3)
+  b[1] = 10
+  b:set(2, 300) -- clamped
+  b[3] = -5
+  assert_equal(b:get(1), 10)
+  assert_equal(b[2], 255)
+  assert_equal(b[3], 0)
+
+  local f = smgf.buffer.new("f32", 1)
+  f[1] = 0.5
+  assert_equal(f[1], 0.5)
+
+  assert_nil(b[4])
+  assert_nil(b[0])
+  assert_raises(function()
+    return b:get(4)
+  end, "index out of range")
+  assert_raises(function()
+    b[0] = 1
+  end, "index out of range")
+end)
+
+tests.buffer:test("can iterate over elements with ipairs", function()
+  local b = smgf.buffer.new("i16", {3, -1, 7})
+  local values = {}
+  for i, v in ipairs(b) do
+    values[i] = v
+  end
+  assert_equal(#values, 3)
+  assert_equal(values[1], 3)
+  assert_equal(values[2], -1)
+  assert_equal(values[3], 7)
+end)
+
+tests.buffer:test("slices share the data of the buffer", function()
+  local b = smgf.buffer.new("i32", {1, 2, 3, 4, 5})
+  local s = b:slice(2, 3)
+  assert_equal(#s, 3)
+  assert_equal(s[1], 2)
+  s[1] = 20
+  assert_equal(b[2], 20)
+
+  -- the buffer is kept alive by the slice
+  b = nil
+  collectgarbage()
+  assert_equal(s[3], 4)
+
+  assert_raises(function()
+    s:slice(2, 3)
+  end, "count out of range")
+end)
+
+tests.buffer:test("can fill and copy buffers", function()
+  local b = smgf.buffer.new("f32", 6)
+  b:fill(1.5)
+  b:fill(2, 5)
+  local t = b:to_table()
+  assert_equal(#t, 6)
+  assert_equal(t[4], 1.5)
+  assert_equal(t[5], 2)
+
+  local src = smgf.buffer.new("f64", {7, 8})
+  b:copy(src, 2)
+  assert_equal(b[2], 7)
+  assert_equal(b[3], 8)
+
+  -- overlapping copy
+  b:copy(b:slice(1, 3), 4)
+  assert_equal(b[5], 7)
+
+  assert_raises(function()
+    b:copy(src, 6)
+  end, "does not fit in the buffer")
+end)
+
 --
 -- FILE IO
 --
@@ -1227,6 +2057,64 @@ tests.io:test("can read a file line by line", function()
   assert_equal(file:read("line"), "this is smgf")
 end)
 
+tests.io:test("can iterate on the lines of a file", function()
+  create_test_file()
+  local file = smgf.io.open("file.txt", "r")
+
+  local lines = {}
+  for line in file:lines() do
+    lines[#lines + 1] = line
+  end
+  assert_equal(#lines, 2)
+  assert_equal(lines[1], "hello world")
+  assert_equal(lines[2], "this is smgf")
+end)
+
+tests.io:test("can read lines larger than the read-ahead", function()
+  smgf.system.set_identity("smgf", "smgftestgame")
+  local long_line = string.rep("0123456789", 5000)
+  local file = smgf.io.open("file.txt", "w")
+  file:write("a\n" .. long_line .. "\nb")
+  file:close()
+
+  file = smgf.io.open("file.txt", "r")
+  assert_equal(file:read("line"), "a\n")
+  assert_equal(file:read("line"), long_line .. "\n")
+  assert_equal(file:tell(), 2 + #long_line + 1)
+  assert_equal(file:read("line"), "b")
+  assert_equal(file:read("line"), nil)
+end)
+
+tests.io:test("can read numbers", function()
+  smgf.system.set_identity("smgf", "smgftestgame")
+  local file = smgf.io.open("file.txt", "w")
+  file:write("12,-3.5 0x10\n1e3 abc")
+  file:close()
+
+  file = smgf.io.open("file.txt", "r")
+  assert_equal(file:read("number"), 12)
+  assert_equal(file:read(1), ",")
+  assert_equal(file:read("number"), -3.5)
+  assert_equal(file:read("number"), 16)
+  assert_equal(file:read("number"), 1000)
+  assert_equal(file:read("number"), nil)
+  assert_equal(file:read("all"), "abc")
+end)
+
+tests.io:test("can seek and tell between buffered reads", function()
+  create_test_file()
+  local file = smgf.io.open("file.txt", "r")
+
+  assert_equal(file:read(5), "hello")
+  assert_equal(file:tell(), 5)
+  assert_equal(file:seek(-2), 3)
+  assert_equal(file:read(2), "lo")
+  file:seek(6, "set")
+  assert_equal(file:read("line"), "world\n")
+  file:rewind()
+  assert_equal(file:read("all"), "hello world\nthis is smgf")
+end)
+
 tests.io:test("test file opened in read mode cannot be written to", function()
   create_test_file()
   local file = smgf.io.open("file.txt", "r")
@@ -1288,6 +2176,98 @@ tests.io:test("test deleting non existing file raises error", function()
   end, "unable to delete file")
 end)
 
+tests.io:test("can write buffers to files", function()
+  smgf.system.set_identity("smgf", "smgftestgame")
+  local file = smgf.io.open("buffer.bin", "w")
+  file:write(smgf.buffer.new("u8", "smgf"))
+  file:close()
+
+  file = smgf.io.open("buffer.bin", "r")
+  assert_equal(file:read("all"), "smgf")
+  file:close()
+  smgf.io.delete("buffer.bin")
+end)
+
+tests.io:test("can load files in buffers", function()
+  create_test_file()
+  local b = smgf.io.load("file.txt")
+  assert_equal(b:get_type(), "u8")
+  assert_equal(b:to_string(), "hello world\nthis is smgf")
+
+  -- large enough to be memory-mapped, and can be modified
+  local f = smgf.io.open("0.wav", "r")
+  local data = f:read("all")
+  f:close()
+  local wav = smgf.io.load("0.wav")
+  assert_equal(#wav, #data)
+  assert_equal(wav:to_string(), data)
+  wav[1] = 0
+  assert_equal(wav[1], 0)
+
+  assert_raises(function()
+    smgf.io.load("nonexistentfile.txt")
+  end, "unable to load file")
+end)
+
+tests.io:test("can read files into buffers", function()
+  create_test_file()
+  local file = smgf.io.open("file.txt", "r")
+  local b = smgf.buffer.new("u8", 8)
+
+  assert_equal(file:read_into(b, 3, 5), 5)
+  assert_equal(b:to_string(3, 5), "hello")
+  assert_equal(file:read_into(b), 8)
+  assert_equal(b:to_string(), " world\nt")
+  file:seek(-2, "end")
+  assert_equal(file:read_into(b), 2)
+  assert_equal(b:to_string(1, 2), "gf")
+
+  -- only whole elements are read
+  file:seek(-3, "end")
+  local b16 = smgf.buffer.new("i16", 4)
+  assert_equal(file:read_into(b16), 1)
+  assert_equal(file:read(1), "f")
+
+  assert_raises(function()
+    file:read_into(b, 10)
+  end, "index out of range")
+end)
+
+-- requests only read the game directory (or fail to write, without write
+-- directory), since the write directory cannot be unmounted while its files
+-- are open
+tests.io:test("can queue and cancel asynchronous requests", function()
+  local called = false
+  local id = smgf.io.read_async("0.ogg", function() called = true end)
+  assert_equal(math.type(id), "integer")
+  assert_true(smgf.io.cancel(id))
+  assert_false(smgf.io.cancel(id))
+
+  id = smgf.io.write_async("async.txt", smgf.buffer.new("u8", "smgf"))
+  assert_true(smgf.io.cancel(id))
+  assert_false(called)
+
+  assert_raises(function()
+    --- @diagnostic disable-next-line: missing-parameter
+    smgf.io.read_async("0.ogg")
+  end, "function expected")
+end)
+
+tests.io:test("asynchronous requests are limited", function()
+  local ids = {}
+  local ok, err = pcall(function()
+    for i = 1, 65 do
+      ids[i] = smgf.io.read_async("0.ogg", function() end)
+    end
+  end)
+  for _, id in ipairs(ids) do
+    smgf.io.cancel(id)
+  end
+  assert_false(ok)
+  assert_str_in("too many requests (64)", err)
+  assert_equal(#ids, 64)
+end)
+
 tests.io:test("test can call flush on files", function()
   create_test_file()
   local file = smgf.io.open("file.txt", "w")
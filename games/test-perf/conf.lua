@@ -5,4 +5,5 @@ conf.height = 600
 conf.organisation = "smgf-dev"
 conf.application = "test-perf"
 -- conf.fps = 30
+conf.stats_overlay = true
 return conf
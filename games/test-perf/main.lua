@@ -3,10 +3,14 @@ local NB_MONSTERS = 200
 local monsters = {}
 ---@type SMGFTexture
 local tex = nil
+---@type SMGFBatch
+local batch = nil
+local use_batch = false
 
 ---@type smgf.init
 function smgf.init()
   tex = smgf.graphics.new("monster1.png")
+  batch = smgf.graphics.new_batch(tex, NB_MONSTERS)
 
   for i = 1, NB_MONSTERS do
     monsters[i] = {}
@@ -35,16 +39,24 @@ end
 ---@type smgf.draw
 function smgf.draw()
   smgf.graphics.clear()
-  for i = 1, NB_MONSTERS do
-    -- smgf.graphics.draw_rectfill(monsters[i].x, monsters[i].y, 16*2,16*2)
-    smgf.graphics.draw(tex, monsters[i].x, monsters[i].y)
+  if use_batch then
+    batch:clear()
+    for i = 1, NB_MONSTERS do
+      batch:add(monsters[i].x, monsters[i].y)
+    end
+    batch:draw()
+  else
+    for i = 1, NB_MONSTERS do
+      -- smgf.graphics.draw_rectfill(monsters[i].x, monsters[i].y, 16*2,16*2)
+      smgf.graphics.draw(tex, monsters[i].x, monsters[i].y)
+    end
   end
 
   -- smgf.graphics.set_color(0, 0, 0, 140)
   -- smgf.graphics.draw_rectfill(640 - 35 - 96, 480 - 30, 35, 30)
   smgf.graphics.set_color(255, 255, 255, 255)
-  smgf.graphics.print_color(0, 0, 0x1F, "NB MONSTERS: " .. NB_MONSTERS)
-  smgf.graphics.print_color(0, 16, 0x1F, tostring(1 / smgf.system.get_dt()))
+  smgf.graphics.print_color(800 - 8 * 28, 0, 0x1F, "NB MONSTERS: " ..
+      NB_MONSTERS .. (use_batch and " (BATCH)" or ""))
 end
 
 ---@type smgf.key_down
@@ -52,6 +64,9 @@ function smgf.key_down(key, mod)
   if key == "s" then
     smgf.graphics.screenshot("screenshot.bmp")
   end
+  if key == "b" then
+    use_batch = not use_batch
+  end
 end
 
 ---@type smgf.mouse_down
@@ -0,0 +1,22 @@
+# copies a game to OUTPUT_DIR, and compiles its Lua files to bytecode with
+# LUAC (debug information is kept, so that errors still show line numbers)
+# usage: cmake -DLUAC=<luac> -DGAME_PATH=<game> -DOUTPUT_DIR=<dir> -P precompile_game.cmake
+file(REMOVE_RECURSE "${OUTPUT_DIR}")
+file(COPY "${GAME_PATH}/" DESTINATION "${OUTPUT_DIR}")
+
+file(GLOB_RECURSE LUA_FILES RELATIVE "${OUTPUT_DIR}" "${OUTPUT_DIR}/*.lua")
+foreach(LUA_FILE ${LUA_FILES})
+  # conf.lua is read as a string, before the game is started
+  if(LUA_FILE STREQUAL "conf.lua")
+    continue()
+  endif()
+
+  execute_process(
+    COMMAND "${LUAC}" -o "${LUA_FILE}" "${LUA_FILE}"
+    WORKING_DIRECTORY "${OUTPUT_DIR}"
+    RESULT_VARIABLE LUAC_RESULT
+  )
+  if(NOT LUAC_RESULT EQUAL 0)
+    message(FATAL_ERROR "cannot compile ${LUA_FILE}")
+  endif()
+endforeach()
@@ -14,6 +14,7 @@
 // - sf_au = SmgF AUdio
 // - sf_io = SmgF I/O
 // - sf_gp = SmgF GamePad
+// - sf_bf = SmgF BuFfer
 
 // graphics
 bool sf_gr_set_target(smgf* const c, stexture* const t);
@@ -29,37 +30,87 @@ int sf_gr_reset_graphics_stack(smgf* const c);
 void sf_gr_set_translation(smgf* const c, int x, int y);
 void sf_gr_get_translation(smgf* const c, int* x, int* y);
 int sf_gr_clip(smgf* const c, int x, int y, int w, int h);
+void sf_gr_invalidate_state(smgf* const c);
+void sf_gr_get_state_changes(smgf* const c, Uint64* issued, Uint64* skipped);
 
 int sf_gr_get_point(smgf* const c, SDL_Color* color, int x, int y);
 bool sf_gr_draw_point(smgf* const c, float x, float y);
 bool sf_gr_draw_line(smgf* const c, float x1, float y1, float x2, float y2);
 bool sf_gr_draw_rect(smgf* const c, float x, float y, float w, float h);
 bool sf_gr_draw_rectfill(smgf* const c, float x, float y, float w, float h);
-/* int sf_gr_draw_geometry(
-    smgf* const c, stexture* const t, SDL_Vertex* vertices, int nb_vertices,
-    const int* indices, int nb_indices); */
-int sf_gr_print_color(
+bool sf_gr_draw_points(
+    smgf* const c, SDL_FPoint* points, const SDL_Color* colors, int n);
+bool sf_gr_draw_lines(
+    smgf* const c, SDL_FPoint* points, const SDL_Color* colors, int n);
+bool sf_gr_draw_rects(
+    smgf* const c, SDL_FRect* rects, const SDL_Color* colors, int n);
+bool sf_gr_draw_rectfills(
+    smgf* const c, SDL_FRect* rects, const SDL_Color* colors, int n);
+bool sf_gr_draw_geometry(
+    smgf* const c, stexture* const t, const SDL_Vertex* vertices,
+    int nb_vertices, const int* indices, int nb_indices);
+void* sf_gr_scratch_reserve(sscratch* const s, size_t size);
+void sf_gr_scratch_del(sscratch* const s);
+bool sf_gr_print_color(
     smgf* const c, int x, int y, Uint8 color, const char* str);
-int sf_gr_print(
+bool sf_gr_print(
     smgf* const c, int x, int y, const char* str, SDL_Color bg_color);
+void sf_gr_text_cache_clear(smgf* const c);
 
 // texture functions
 int sf_gr_texture_new(smgf* const c, stexture* const t, const char* filename);
 int sf_gr_texture_new_empty(smgf* const c, stexture* const t, int w, int h);
-void sf_gr_texture_del(stexture* const t);
+void sf_gr_texture_del(smgf* const c, stexture* const t);
 bool sf_gr_texture_draw(
     smgf* const c, stexture* const t, float x, float y, int qx, int qy, int qw,
     int qh, float sx, float sy, double r, float ox, float oy, int flip);
 int sf_gr_texture_get_dimensions(stexture* const t, int* w, int* h);
-bool sf_gr_texture_set_blend_mode(stexture* const t, SDL_BlendMode b);
+bool sf_gr_texture_set_blend_mode(
+    smgf* const c, stexture* const t, SDL_BlendMode b);
 bool sf_gr_texture_get_blend_mode(stexture* const t, SDL_BlendMode* b);
 int sf_gr_texture_save(smgf* const c, stexture* const t, const char* filename);
 
+// sprite batch functions
+int sf_gr_batch_new(sbatch* const b, stexture* const t, int capacity);
+void sf_gr_batch_del(sbatch* const b);
+int sf_gr_batch_add(
+    smgf* const c, sbatch* const b, float x, float y, int qx, int qy, int qw,
+    int qh, float sx, float sy, double r, float ox, float oy, int flip);
+void sf_gr_batch_clear(sbatch* const b);
+bool sf_gr_batch_draw(smgf* const c, sbatch* const b);
+
+// mesh functions
+int sf_gr_mesh_new(smesh* const m, int nb_vertices, int nb_indices);
+void sf_gr_mesh_del(smesh* const m);
+void sf_gr_mesh_set_vertex(smesh* const m, int i, const SDL_Vertex* v);
+void sf_gr_mesh_set_index(smesh* const m, int i, int index);
+bool sf_gr_mesh_draw(smgf* const c, smesh* const m, float x, float y);
+
+// tilemap functions
+int sf_gr_tilemap_new(
+    stilemap* const m, stexture* const t, int tile_w, int tile_h, int map_w,
+    int map_h);
+void sf_gr_tilemap_del(smgf* const c, stilemap* const m);
+void sf_gr_tilemap_set_tile(stilemap* const m, int x, int y, Uint16 tile);
+Uint16 sf_gr_tilemap_get_tile(stilemap* const m, int x, int y);
+bool sf_gr_tilemap_draw(smgf* const c, stilemap* const m, float x, float y);
+
+// text functions
+int sf_gr_text_new(stext* const t, const char* str);
+void sf_gr_text_del(smgf* const c, stext* const t);
+bool sf_gr_text_draw(smgf* const c, stext* const t, float x, float y);
+
 // system
 void sf_sy_quit(smgf* const c);
 void sf_sy_get_platform(smgf* const c, char const** platform);
-void sf_sy_sleep(smgf* const c, float seconds);
-void sf_sy_get_dt(smgf* const c, float* dt);
+void sf_sy_sleep(smgf* const c, double seconds);
+void sf_sy_get_dt(smgf* const c, double* dt);
+void sf_sy_end_frame_stats(smgf* const c);
+int sf_sy_trace_start(smgf* const c);
+void sf_sy_trace_begin(smgf* const c, const char* name);
+void sf_sy_trace_end(smgf* const c);
+int sf_sy_trace_stop(smgf* const c, const char* filename);
+void sf_sy_get_frame_time(smgf* const c, double* mean, double* variance);
 void sf_sy_get_fullscreen(smgf* const c, bool* fullscreen);
 int sf_sy_set_fullscreen(smgf* const c, bool fullscreen);
 int sf_sy_open_url(smgf* const c, const char* url);
@@ -73,6 +124,8 @@ void sf_sy_get_window_size(smgf* const c, int* w, int* h);
 void sf_sy_set_window_size(smgf* const c, int w, int h);
 int sf_sy_get_fps(smgf* const c);
 void sf_sy_set_fps(smgf* const c, int fps);
+int sf_sy_get_update_rate(smgf* const c);
+void sf_sy_set_update_rate(smgf* const c, int update_rate);
 int sf_sy_get_zoom(smgf* const c);
 void sf_sy_set_zoom(smgf* const c, int zoom);
 bool sf_sy_get_cursor_visible(smgf* const c);
@@ -118,6 +171,18 @@ float sf_au_sound_get_gain(smgf* const c, ssound* const s);
 bool sf_au_sound_set_gain(smgf* const c, ssound* const s, float gain);
 bool sf_au_sound_get_loop(smgf* const c, ssound* const s);
 
+// buffer
+size_t sf_bf_element_size(sbuffer_type type);
+int sf_bf_new(sbuffer* const b, sbuffer_type type, size_t length);
+void sf_bf_del(sbuffer* const b);
+int sf_bf_map(sbuffer* const b, const char* native_path);
+void sf_bf_view(
+    sbuffer* const v, const sbuffer* const b, size_t first, size_t length);
+double sf_bf_get(const sbuffer* const b, size_t i);
+void sf_bf_set(sbuffer* const b, size_t i, double value);
+void sf_bf_fill(sbuffer* const b, size_t first, size_t count, double value);
+void sf_bf_copy(sbuffer* const dst, size_t first, const sbuffer* const src);
+
 // io
 int sf_io_new(sfile* const f);
 int sf_io_del(sfile* const f);
@@ -127,14 +192,17 @@ Sint64 sf_io_seek(sfile* const f, Sint64 offset, int whence);
 Sint64 sf_io_tell(sfile* const f);
 Sint64 sf_io_rewind(sfile* const f);
 Sint64 sf_io_size(sfile* const f);
-int sf_io_read(sfile* const f, void* ptr, size_t size);
+size_t sf_io_read(sfile* const f, void* ptr, size_t size);
+int sf_io_getc(sfile* const f, bool peek);
+const char* sf_io_read_until(sfile* const f, char needle, size_t* len);
 int sf_io_write(sfile* const f, const void* ptr, size_t size);
-int sf_io_strchr(sfile* const f, Sint64* pos, char needle);
 int sf_io_mkdir(const char* dirname);
 int sf_io_delete(const char* filename);
 PHYSFS_FileType sf_io_get_filetype(const char* filename);
 bool sf_io_exists(const char* filename);
 bool sf_io_flush(sfile* const f);
+char* sf_io_mappable_path(const char* filename);
+int sf_io_load(sbuffer* const b, const char* filename, const char* map_path);
 
 // gamepad
 bool sf_gp_is_open(int player_index);
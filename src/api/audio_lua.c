@@ -35,12 +35,15 @@ static int l_sound_new(lua_State* L) {
   }
 
   ssound* s = (ssound*) lua_newuserdata(L, sizeof(ssound));
+  sf_sy_trace_begin(c, filename);
   if (sf_au_sound_new(c, s, filename, predecoded)) {
+    sf_sy_trace_end(c);
     return luaL_error(
         L, "unable to open sound file '%s' (%s)", filename, SDL_GetError());
   }
+  sf_sy_trace_end(c);
 
-  luaL_getmetatable(L, SMGF_TYPE_SOUND);
+  l_getmetatable(L, SMGF_TYPE_SOUND);
   lua_setmetatable(L, -2);
 
   return 1;
@@ -49,7 +52,7 @@ static int l_sound_new(lua_State* L) {
 static int l_sound_del(lua_State* L) {
   smgf* const c = get_smgf(L);
 
-  ssound* s = (ssound*) luaL_checkudata(L, 1, SMGF_TYPE_SOUND);
+  ssound* s = (ssound*) l_checkudata(L, 1, SMGF_TYPE_SOUND);
   sf_au_sound_del(c, s);
   return 0;
 }
@@ -57,7 +60,7 @@ static int l_sound_del(lua_State* L) {
 static int l_sound_play(lua_State* L) {
   smgf* const c = get_smgf(L);
 
-  ssound* s = (ssound*) luaL_checkudata(L, 1, SMGF_TYPE_SOUND);
+  ssound* s = (ssound*) l_checkudata(L, 1, SMGF_TYPE_SOUND);
   if (sf_au_sound_is_playing(c, s)) {
     return 0;
   }
@@ -73,7 +76,7 @@ static int l_sound_play(lua_State* L) {
 static int l_sound_get_duration(lua_State* L) {
   smgf* const c = get_smgf(L);
 
-  ssound* s = (ssound*) luaL_checkudata(L, 1, SMGF_TYPE_SOUND);
+  ssound* s = (ssound*) l_checkudata(L, 1, SMGF_TYPE_SOUND);
   int duration = sf_au_sound_get_duration(c, s);
   if (duration == -1) {
     return luaL_error(
@@ -88,7 +91,7 @@ static int l_sound_get_duration(lua_State* L) {
 static int l_sound_pause(lua_State* L) {
   smgf* const c = get_smgf(L);
 
-  ssound* s = (ssound*) luaL_checkudata(L, 1, SMGF_TYPE_SOUND);
+  ssound* s = (ssound*) l_checkudata(L, 1, SMGF_TYPE_SOUND);
   sf_au_sound_pause(c, s);
   return 0;
 }
@@ -96,7 +99,7 @@ static int l_sound_pause(lua_State* L) {
 static int l_sound_stop(lua_State* L) {
   smgf* const c = get_smgf(L);
 
-  ssound* s = (ssound*) luaL_checkudata(L, 1, SMGF_TYPE_SOUND);
+  ssound* s = (ssound*) l_checkudata(L, 1, SMGF_TYPE_SOUND);
   int fade = luaL_optnumber(L, 2, 0);
   sf_au_sound_stop(c, s, fade);
   return 0;
@@ -105,7 +108,7 @@ static int l_sound_stop(lua_State* L) {
 static int l_sound_rewind(lua_State* L) {
   smgf* const c = get_smgf(L);
 
-  ssound* s = (ssound*) luaL_checkudata(L, 1, SMGF_TYPE_SOUND);
+  ssound* s = (ssound*) l_checkudata(L, 1, SMGF_TYPE_SOUND);
   if (!sf_au_sound_rewind(c, s)) {
     return luaL_error(L, "unable to rewind sound file (%s)", SDL_GetError());
   }
@@ -115,7 +118,7 @@ static int l_sound_rewind(lua_State* L) {
 static int l_sound_seek(lua_State* L) {
   smgf* const c = get_smgf(L);
 
-  ssound* s = (ssound*) luaL_checkudata(L, 1, SMGF_TYPE_SOUND);
+  ssound* s = (ssound*) l_checkudata(L, 1, SMGF_TYPE_SOUND);
 
   int ms = luaL_checknumber(L, 2);
   if (!sf_au_sound_seek(c, s, ms)) {
@@ -128,7 +131,7 @@ static int l_sound_seek(lua_State* L) {
 static int l_sound_is_playing(lua_State* L) {
   smgf* const c = get_smgf(L);
 
-  ssound* s = (ssound*) luaL_checkudata(L, 1, SMGF_TYPE_SOUND);
+  ssound* s = (ssound*) l_checkudata(L, 1, SMGF_TYPE_SOUND);
   lua_pushboolean(L, sf_au_sound_is_playing(c, s));
   return 1;
 }
@@ -136,7 +139,7 @@ static int l_sound_is_playing(lua_State* L) {
 static int l_sound_is_predecoded(lua_State* L) {
   smgf* const c = get_smgf(L);
 
-  ssound* s = (ssound*) luaL_checkudata(L, 1, SMGF_TYPE_SOUND);
+  ssound* s = (ssound*) l_checkudata(L, 1, SMGF_TYPE_SOUND);
   lua_pushboolean(L, sf_au_sound_is_predecoded(c, s));
   return 1;
 }
@@ -144,7 +147,7 @@ static int l_sound_is_predecoded(lua_State* L) {
 static int l_sound_get_pan(lua_State* L) {
   smgf* const c = get_smgf(L);
 
-  ssound* s = (ssound*) luaL_checkudata(L, 1, SMGF_TYPE_SOUND);
+  ssound* s = (ssound*) l_checkudata(L, 1, SMGF_TYPE_SOUND);
   float pan = 0;
   if (!sf_au_sound_get_pan(c, s, &pan)) {
     return luaL_error(
@@ -157,7 +160,7 @@ static int l_sound_get_pan(lua_State* L) {
 static int l_sound_set_pan(lua_State* L) {
   smgf* const c = get_smgf(L);
 
-  ssound* s = (ssound*) luaL_checkudata(L, 1, SMGF_TYPE_SOUND);
+  ssound* s = (ssound*) l_checkudata(L, 1, SMGF_TYPE_SOUND);
 
   float pan = luaL_checknumber(L, 2);
   luaL_argcheck(L, pan >= -1 && pan <= 1, 2, "must be between -1 and 1");
@@ -168,7 +171,7 @@ static int l_sound_set_pan(lua_State* L) {
 static int l_sound_get_gain(lua_State* L) {
   smgf* const c = get_smgf(L);
 
-  ssound* s = (ssound*) luaL_checkudata(L, 1, SMGF_TYPE_SOUND);
+  ssound* s = (ssound*) l_checkudata(L, 1, SMGF_TYPE_SOUND);
   lua_pushinteger(L, sf_au_sound_get_gain(c, s));
   return 1;
 }
@@ -176,7 +179,7 @@ static int l_sound_get_gain(lua_State* L) {
 static int l_sound_set_gain(lua_State* L) {
   smgf* const c = get_smgf(L);
 
-  ssound* s = (ssound*) luaL_checkudata(L, 1, SMGF_TYPE_SOUND);
+  ssound* s = (ssound*) l_checkudata(L, 1, SMGF_TYPE_SOUND);
 
   float gain = luaL_checknumber(L, 2);
   luaL_argcheck(L, gain >= 0 && gain <= 2, 2, "must be between 0 and 2");
@@ -187,7 +190,7 @@ static int l_sound_set_gain(lua_State* L) {
 static int l_sound_get_loop(lua_State* L) {
   smgf* const c = get_smgf(L);
 
-  ssound* s = (ssound*) luaL_checkudata(L, 1, SMGF_TYPE_SOUND);
+  ssound* s = (ssound*) l_checkudata(L, 1, SMGF_TYPE_SOUND);
   lua_pushboolean(L, sf_au_sound_get_loop(c, s));
   return 1;
 }
@@ -195,14 +198,14 @@ static int l_sound_get_loop(lua_State* L) {
 static int l_sound_clone(lua_State* L) {
   smgf* const c = get_smgf(L);
 
-  ssound* origin = (ssound*) luaL_checkudata(L, 1, SMGF_TYPE_SOUND);
+  ssound* origin = (ssound*) l_checkudata(L, 1, SMGF_TYPE_SOUND);
 
   ssound* clone = (ssound*) lua_newuserdata(L, sizeof(ssound));
   if (sf_au_sound_new(c, clone, origin->filename, origin->predecoded)) {
     return luaL_error(L, "unable to clone sound file (%s)", SDL_GetError());
   }
 
-  luaL_getmetatable(L, SMGF_TYPE_SOUND);
+  l_getmetatable(L, SMGF_TYPE_SOUND);
   lua_setmetatable(L, -2);
 
   return 1;
@@ -256,7 +259,7 @@ void init_audio(lua_State* L) {
   lua_setfield(L, -2, "audio");
 
   // add sound type
-  luaL_newmetatable(L, SMGF_TYPE_SOUND);
+  l_newmetatable(L, SMGF_TYPE_SOUND);
   lua_pushcfunction(L, l_sound_del);
   lua_setfield(L, -2, "__gc");
   lua_pushvalue(L, -1);
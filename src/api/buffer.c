@@ -0,0 +1,183 @@
+#include "../api.h"
+
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+#define SMGF_HAS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+size_t sf_bf_element_size(sbuffer_type type) {
+  switch (type) {
+  case SBUFFER_U8: return sizeof(Uint8);
+  case SBUFFER_I16: return sizeof(Sint16);
+  case SBUFFER_I32: return sizeof(Sint32);
+  case SBUFFER_F32: return sizeof(float);
+  case SBUFFER_F64: return sizeof(double);
+  default: return 0;
+  }
+}
+
+// creates a buffer of "length" elements set to 0
+int sf_bf_new(sbuffer* const b, sbuffer_type type, size_t length) {
+  b->type = type;
+  b->length = 0;
+  b->storage = SBUFFER_HEAP;
+
+  size_t element_size = sf_bf_element_size(type);
+  if (length > SDL_SIZE_MAX / element_size) {
+    SDL_SetError("buffer too large");
+    b->data = NULL;
+    return -1;
+  }
+
+  // at least one byte, so that an empty buffer has valid data
+  b->data = SDL_calloc(SDL_max(length * element_size, 1), 1);
+  if (b->data == NULL) {
+    return -1;
+  }
+  b->length = length;
+  return 0;
+}
+
+void sf_bf_del(sbuffer* const b) {
+  if (b->storage == SBUFFER_HEAP) {
+    SDL_free(b->data);
+  } else if (b->storage == SBUFFER_MAPPED) {
+#ifdef SMGF_HAS_MMAP
+    munmap(b->data, b->mapping_size);
+#endif
+  }
+  b->storage = SBUFFER_VIEW;
+  b->data = NULL;
+  b->length = 0;
+}
+
+// maps a native file in memory, as a "u8" buffer. Pages are copied on write,
+// so the buffer can be modified without changing the file. Returns -1 if the
+// platform cannot map files.
+int sf_bf_map(sbuffer* const b, const char* native_path) {
+  b->type = SBUFFER_U8;
+  b->data = NULL;
+  b->length = 0;
+  b->storage = SBUFFER_VIEW;
+
+#ifdef SMGF_HAS_MMAP
+  int fd = open(native_path, O_RDONLY);
+  if (fd == -1) {
+    SDL_SetError("cannot open %s", native_path);
+    return -1;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) == -1 || st.st_size <= 0) {
+    close(fd);
+    SDL_SetError("cannot map %s (empty or not a file)", native_path);
+    return -1;
+  }
+
+  void* data = mmap(
+      NULL, (size_t) st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd); // the mapping stays valid
+  if (data == MAP_FAILED) {
+    SDL_SetError("cannot map %s", native_path);
+    return -1;
+  }
+
+  b->data = data;
+  b->length = (size_t) st.st_size;
+  b->mapping_size = (size_t) st.st_size;
+  b->storage = SBUFFER_MAPPED;
+  return 0;
+#else
+  SDL_SetError("memory-mapped files are not supported");
+  return -1;
+#endif
+}
+
+// makes "v" a view of "length" elements of "b", starting at element "first"
+// (which must be in range)
+void sf_bf_view(
+    sbuffer* const v, const sbuffer* const b, size_t first, size_t length) {
+  v->type = b->type;
+  v->data = (Uint8*) b->data + first * sf_bf_element_size(b->type);
+  v->length = length;
+  v->storage = SBUFFER_VIEW;
+}
+
+double sf_bf_get(const sbuffer* const b, size_t i) {
+  switch (b->type) {
+  case SBUFFER_U8: return ((const Uint8*) b->data)[i];
+  case SBUFFER_I16: return ((const Sint16*) b->data)[i];
+  case SBUFFER_I32: return ((const Sint32*) b->data)[i];
+  case SBUFFER_F32: return ((const float*) b->data)[i];
+  case SBUFFER_F64: return ((const double*) b->data)[i];
+  default: return 0;
+  }
+}
+
+// integers are clamped to the range of the type (NaN becomes 0), and
+// truncated towards 0
+static inline double buffer_clamp(double value, double min, double max) {
+  if (!(value >= min)) { // also true for NaN
+    return value != value ? 0 : min;
+  }
+  return value > max ? max : value;
+}
+
+void sf_bf_set(sbuffer* const b, size_t i, double value) {
+  switch (b->type) {
+  case SBUFFER_U8:
+    ((Uint8*) b->data)[i] = (Uint8) buffer_clamp(value, 0, SDL_MAX_UINT8);
+    break;
+  case SBUFFER_I16:
+    ((Sint16*) b->data)[i] =
+        (Sint16) buffer_clamp(value, SDL_MIN_SINT16, SDL_MAX_SINT16);
+    break;
+  case SBUFFER_I32:
+    ((Sint32*) b->data)[i] =
+        (Sint32) buffer_clamp(value, SDL_MIN_SINT32, SDL_MAX_SINT32);
+    break;
+  case SBUFFER_F32: ((float*) b->data)[i] = (float) value; break;
+  case SBUFFER_F64: ((double*) b->data)[i] = value; break;
+  default: break;
+  }
+}
+
+// sets "count" elements starting at "first" (which must be in range)
+void sf_bf_fill(sbuffer* const b, size_t first, size_t count, double value) {
+  if (count == 0) {
+    return;
+  }
+  if (b->type == SBUFFER_U8) {
+    Uint8 byte = (Uint8) buffer_clamp(value, 0, SDL_MAX_UINT8);
+    SDL_memset((Uint8*) b->data + first, byte, count);
+    return;
+  }
+
+  // the first element is converted once, then copied
+  sf_bf_set(b, first, value);
+  size_t element_size = sf_bf_element_size(b->type);
+  Uint8* src = (Uint8*) b->data + first * element_size;
+  for (size_t i = 1; i < count; i++) {
+    SDL_memcpy(src + i * element_size, src, element_size);
+  }
+}
+
+// copies all the elements of "src" into "dst", starting at element "first"
+// of "dst" (the elements must fit). Elements are converted if the types
+// differ. The buffers can overlap (e.g. views of the same buffer).
+void sf_bf_copy(sbuffer* const dst, size_t first, const sbuffer* const src) {
+  if (dst->type == src->type) {
+    size_t element_size = sf_bf_element_size(dst->type);
+    SDL_memmove(
+        (Uint8*) dst->data + first * element_size, src->data,
+        src->length * element_size);
+    return;
+  }
+
+  for (size_t i = 0; i < src->length; i++) {
+    sf_bf_set(dst, first + i, sf_bf_get(src, i));
+  }
+}
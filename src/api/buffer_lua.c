@@ -0,0 +1,264 @@
+#include "../smgf.h"
+#include "../api_lua.h"
+
+static const char* const buffer_type_names[] = {
+    "u8", "i16", "i32", "f32", "f64", NULL};
+
+// pushes a new buffer userdata, whose data is not allocated yet. Its user
+// value keeps the parent of a view alive.
+sbuffer* l_newbuffer(lua_State* L) {
+  sbuffer* b = (sbuffer*) lua_newuserdatauv(L, sizeof(sbuffer), 1);
+  b->data = NULL;
+  b->length = 0;
+  b->storage = SBUFFER_VIEW;
+  l_getmetatable(L, SMGF_TYPE_BUFFER);
+  lua_setmetatable(L, -2);
+  return b;
+}
+
+// returns the 0-based index of the element whose 1-based index is at "narg"
+static size_t lua_checkelement(lua_State* L, int narg, const sbuffer* b) {
+  lua_Integer i = luaL_checkinteger(L, narg);
+  luaL_argcheck(
+      L, i >= 1 && (lua_Unsigned) i <= b->length, narg, "index out of range");
+  return i - 1;
+}
+
+// reads an optional range of elements ("first", "count") at "narg"
+static void lua_optrange(
+    lua_State* L, int narg, const sbuffer* b, size_t* first, size_t* count) {
+  lua_Integer i = luaL_optinteger(L, narg, 1);
+  luaL_argcheck(
+      L, i >= 1 && (lua_Unsigned) i <= b->length + 1, narg,
+      "index out of range");
+  lua_Integer n = luaL_optinteger(L, narg + 1, b->length - (i - 1));
+  luaL_argcheck(
+      L, n >= 0 && (lua_Unsigned) n <= b->length - (i - 1), narg + 1,
+      "count out of range");
+  *first = i - 1;
+  *count = n;
+}
+
+static void lua_pushelement(lua_State* L, const sbuffer* b, size_t i) {
+  if (b->type == SBUFFER_F32 || b->type == SBUFFER_F64) {
+    lua_pushnumber(L, sf_bf_get(b, i));
+  } else {
+    lua_pushinteger(L, (lua_Integer) sf_bf_get(b, i));
+  }
+}
+
+// creates a buffer from a length, a table of numbers or a string (whose bytes
+// are copied)
+static int l_buffer_new(lua_State* L) {
+  sbuffer_type type = luaL_checkoption(L, 1, NULL, buffer_type_names);
+  size_t element_size = sf_bf_element_size(type);
+
+  size_t length = 0;
+  const char* str = NULL;
+  size_t str_len = 0;
+  switch (lua_type(L, 2)) {
+  case LUA_TNUMBER: {
+    lua_Integer n = luaL_checkinteger(L, 2);
+    luaL_argcheck(L, n >= 0, 2, "must be positive");
+    length = n;
+    break;
+  }
+  case LUA_TTABLE: length = luaL_len(L, 2); break;
+  case LUA_TSTRING:
+    str = lua_tolstring(L, 2, &str_len);
+    luaL_argcheck(
+        L, str_len % element_size == 0, 2,
+        "size must be a multiple of the element size");
+    length = str_len / element_size;
+    break;
+  default: return luaL_typeerror(L, 2, "number, table or string");
+  }
+
+  sbuffer* b = l_newbuffer(L);
+  if (sf_bf_new(b, type, length)) {
+    return luaL_error(L, "unable to create buffer (%s)", SDL_GetError());
+  }
+
+  if (str != NULL) {
+    SDL_memcpy(b->data, str, str_len);
+  } else if (lua_istable(L, 2)) {
+    for (size_t i = 0; i < length; i++) {
+      lua_rawgeti(L, 2, i + 1);
+      int isnum = 0;
+      lua_Number v = lua_tonumberx(L, -1, &isnum);
+      lua_pop(L, 1);
+      if (!isnum) {
+        return luaL_argerror(L, 2, "must only contain numbers");
+      }
+      sf_bf_set(b, i, v);
+    }
+  }
+
+  return 1;
+}
+
+static int l_buffer_del(lua_State* L) {
+  sbuffer* b = (sbuffer*) l_checkudata(L, 1, SMGF_TYPE_BUFFER);
+  sf_bf_del(b);
+  return 0;
+}
+
+static int l_buffer_get(lua_State* L) {
+  sbuffer* b = (sbuffer*) l_checkudata(L, 1, SMGF_TYPE_BUFFER);
+  size_t i = lua_checkelement(L, 2, b);
+  lua_pushelement(L, b, i);
+  return 1;
+}
+
+static int l_buffer_set(lua_State* L) {
+  sbuffer* b = (sbuffer*) l_checkudata(L, 1, SMGF_TYPE_BUFFER);
+  size_t i = lua_checkelement(L, 2, b);
+  sf_bf_set(b, i, luaL_checknumber(L, 3));
+  return 0;
+}
+
+// b[i] reads an element (nil out of range, as for tables, so that ipairs
+// stops at the end), other keys are methods
+static int l_buffer_index(lua_State* L) {
+  if (lua_type(L, 2) == LUA_TNUMBER) {
+    sbuffer* b = (sbuffer*) l_checkudata(L, 1, SMGF_TYPE_BUFFER);
+    lua_Integer i = lua_isinteger(L, 2) ? lua_tointeger(L, 2) : 0;
+    if (i >= 1 && (lua_Unsigned) i <= b->length) {
+      lua_pushelement(L, b, i - 1);
+    } else {
+      lua_pushnil(L);
+    }
+    return 1;
+  }
+  lua_gettable(L, lua_upvalueindex(1));
+  return 1;
+}
+
+static int l_buffer_newindex(lua_State* L) {
+  if (lua_type(L, 2) != LUA_TNUMBER) {
+    return luaL_argerror(L, 2, "buffer index must be a number");
+  }
+  return l_buffer_set(L);
+}
+
+static int l_buffer_len(lua_State* L) {
+  sbuffer* b = (sbuffer*) l_checkudata(L, 1, SMGF_TYPE_BUFFER);
+  lua_pushinteger(L, b->length);
+  return 1;
+}
+
+static int l_buffer_get_type(lua_State* L) {
+  sbuffer* b = (sbuffer*) l_checkudata(L, 1, SMGF_TYPE_BUFFER);
+  lua_pushstring(L, buffer_type_names[b->type]);
+  return 1;
+}
+
+// size in bytes
+static int l_buffer_get_size(lua_State* L) {
+  sbuffer* b = (sbuffer*) l_checkudata(L, 1, SMGF_TYPE_BUFFER);
+  lua_pushinteger(L, b->length * sf_bf_element_size(b->type));
+  return 1;
+}
+
+// returns a view of "count" elements starting at "first", sharing the data
+// of the buffer
+static int l_buffer_slice(lua_State* L) {
+  sbuffer* b = (sbuffer*) l_checkudata(L, 1, SMGF_TYPE_BUFFER);
+  size_t first = 0, count = 0;
+  lua_optrange(L, 2, b, &first, &count);
+
+  sbuffer* v = l_newbuffer(L);
+  sf_bf_view(v, b, first, count);
+  lua_pushvalue(L, 1);
+  lua_setiuservalue(L, -2, 1);
+  return 1;
+}
+
+static int l_buffer_fill(lua_State* L) {
+  sbuffer* b = (sbuffer*) l_checkudata(L, 1, SMGF_TYPE_BUFFER);
+  lua_Number value = luaL_checknumber(L, 2);
+  size_t first = 0, count = 0;
+  lua_optrange(L, 3, b, &first, &count);
+
+  sf_bf_fill(b, first, count, value);
+  return 0;
+}
+
+// copies all the elements of another buffer, starting at element "first"
+static int l_buffer_copy(lua_State* L) {
+  sbuffer* dst = (sbuffer*) l_checkudata(L, 1, SMGF_TYPE_BUFFER);
+  sbuffer* src = (sbuffer*) l_checkudata(L, 2, SMGF_TYPE_BUFFER);
+  lua_Integer first = luaL_optinteger(L, 3, 1);
+  luaL_argcheck(
+      L, first >= 1 && (lua_Unsigned) first <= dst->length + 1, 3,
+      "index out of range");
+  luaL_argcheck(
+      L, src->length <= dst->length - (first - 1), 2,
+      "does not fit in the buffer");
+
+  sf_bf_copy(dst, first - 1, src);
+  return 0;
+}
+
+// returns the bytes of a range of elements
+static int l_buffer_to_string(lua_State* L) {
+  sbuffer* b = (sbuffer*) l_checkudata(L, 1, SMGF_TYPE_BUFFER);
+  size_t first = 0, count = 0;
+  lua_optrange(L, 2, b, &first, &count);
+
+  size_t element_size = sf_bf_element_size(b->type);
+  lua_pushlstring(
+      L, (const char*) b->data + first * element_size, count * element_size);
+  return 1;
+}
+
+static int l_buffer_to_table(lua_State* L) {
+  sbuffer* b = (sbuffer*) l_checkudata(L, 1, SMGF_TYPE_BUFFER);
+  size_t first = 0, count = 0;
+  lua_optrange(L, 2, b, &first, &count);
+
+  lua_createtable(L, count, 0);
+  for (size_t i = 0; i < count; i++) {
+    lua_pushelement(L, b, first + i);
+    lua_rawseti(L, -2, i + 1);
+  }
+  return 1;
+}
+
+static const struct luaL_Reg smgf_buffer[] = {
+    {"new", l_buffer_new}, {NULL, NULL}};
+
+static const struct luaL_Reg buffer_func[] = {
+    {"get", l_buffer_get},
+    {"set", l_buffer_set},
+    {"get_type", l_buffer_get_type},
+    {"get_length", l_buffer_len},
+    {"get_size", l_buffer_get_size},
+    {"slice", l_buffer_slice},
+    {"fill", l_buffer_fill},
+    {"copy", l_buffer_copy},
+    {"to_string", l_buffer_to_string},
+    {"to_table", l_buffer_to_table},
+    {NULL, NULL}};
+
+void init_buffer(lua_State* L) {
+  size_t n = SDL_arraysize(smgf_buffer);
+  lua_createtable(L, 0, n);
+  luaL_setfuncs(L, smgf_buffer, 0);
+  lua_setfield(L, -2, "buffer");
+
+  // add buffer type: its __index reads elements, or methods (upvalue)
+  l_newmetatable(L, SMGF_TYPE_BUFFER);
+  lua_pushcfunction(L, l_buffer_del);
+  lua_setfield(L, -2, "__gc");
+  lua_pushcfunction(L, l_buffer_len);
+  lua_setfield(L, -2, "__len");
+  lua_pushcfunction(L, l_buffer_newindex);
+  lua_setfield(L, -2, "__newindex");
+  n = SDL_arraysize(buffer_func);
+  lua_createtable(L, 0, n);
+  luaL_setfuncs(L, buffer_func, 0);
+  lua_pushcclosure(L, l_buffer_index, 1);
+  lua_setfield(L, -2, "__index");
+  lua_pop(L, 1);
+}
@@ -1,9 +1,112 @@
 // #include <SDL3_image/SDL_image.h>
 #include "../api.h"
 
+// The sf_gr_apply_* functions only call SDL when the requested state differs
+// from the last one applied (see smgf_render_state), and count the calls that
+// were issued or skipped.
+
+static bool sf_gr_apply_target(smgf* const c, SDL_Texture* tex) {
+  smgf_render_state* const s = &c->rstate;
+  if (s->target_valid && s->target == tex) {
+    s->nb_skipped += 1;
+    return true;
+  }
+
+  s->nb_issued += 1;
+  c->stats.nb_target_switches += 1;
+  s->target_valid = SDL_SetRenderTarget(c->renderer, tex);
+  s->target = tex;
+  return s->target_valid;
+}
+
+static bool sf_gr_apply_color(
+    smgf* const c, Uint8 r, Uint8 g, Uint8 b, Uint8 a) {
+  smgf_render_state* const s = &c->rstate;
+  if (s->color_valid && s->color.r == r && s->color.g == g && s->color.b == b &&
+      s->color.a == a) {
+    s->nb_skipped += 1;
+    return true;
+  }
+
+  s->nb_issued += 1;
+  s->color_valid = SDL_SetRenderDrawColor(c->renderer, r, g, b, a);
+  s->color.r = r;
+  s->color.g = g;
+  s->color.b = b;
+  s->color.a = a;
+  return s->color_valid;
+}
+
+static bool sf_gr_apply_blend_mode(smgf* const c, SDL_BlendMode b) {
+  smgf_render_state* const s = &c->rstate;
+  if (s->blend_mode_valid && s->blend_mode == b) {
+    s->nb_skipped += 1;
+    return true;
+  }
+
+  s->nb_issued += 1;
+  s->blend_mode_valid = SDL_SetRenderDrawBlendMode(c->renderer, b);
+  s->blend_mode = b;
+  return s->blend_mode_valid;
+}
+
+static bool sf_gr_apply_texture_mod(
+    smgf* const c, stexture* const t, Uint8 r, Uint8 g, Uint8 b, Uint8 a) {
+  smgf_render_state* const s = &c->rstate;
+  bool result = true;
+
+  if (t->mod.r != r || t->mod.g != g || t->mod.b != b) {
+    s->nb_issued += 1;
+    result = SDL_SetTextureColorMod(t->tex, r, g, b);
+    t->mod.r = r;
+    t->mod.g = g;
+    t->mod.b = b;
+  } else {
+    s->nb_skipped += 1;
+  }
+
+  if (t->mod.a != a) {
+    s->nb_issued += 1;
+    result = SDL_SetTextureAlphaMod(t->tex, a) && result;
+    t->mod.a = a;
+  } else {
+    s->nb_skipped += 1;
+  }
+
+  return result;
+}
+
+// counts a draw call, made with texture "tex" (or NULL), for the frame stats
+static inline void sf_gr_count_draw(smgf* const c, SDL_Texture* tex) {
+  c->stats.nb_draw_calls += 1;
+  if (tex != NULL && tex != c->rstate.texture) {
+    c->stats.nb_texture_binds += 1;
+    c->rstate.texture = tex;
+  }
+}
+
+static inline bool sf_gr_apply_current_color(smgf* const c) {
+  return sf_gr_apply_color(
+      c, c->curstate->r, c->curstate->g, c->curstate->b, c->curstate->a);
+}
+
+// forgets the renderer state: to be called when the renderer has been
+// modified without going through the sf_gr_* functions
+void sf_gr_invalidate_state(smgf* const c) {
+  c->rstate.texture = NULL;
+  c->rstate.target_valid = false;
+  c->rstate.color_valid = false;
+  c->rstate.blend_mode_valid = false;
+}
+
+void sf_gr_get_state_changes(smgf* const c, Uint64* issued, Uint64* skipped) {
+  *issued = c->rstate.nb_issued;
+  *skipped = c->rstate.nb_skipped;
+}
+
 bool sf_gr_set_target(smgf* const c, stexture* const t) {
   stexture* const target = t == NULL ? c->screen_texture : t;
-  bool result = SDL_SetRenderTarget(c->renderer, target->tex);
+  bool result = sf_gr_apply_target(c, target->tex);
 
   if (result) {
     c->curstate->target = t;
@@ -38,8 +141,7 @@ bool sf_gr_get_color(smgf* const c, SDL_Color* color) {
 }
 
 bool sf_gr_clear(smgf* const c, SDL_Color* color) {
-  if (!SDL_SetRenderDrawColor(
-          c->renderer, color->r, color->g, color->b, color->a)) {
+  if (!sf_gr_apply_color(c, color->r, color->g, color->b, color->a)) {
     return false;
   }
 
@@ -47,7 +149,7 @@ bool sf_gr_clear(smgf* const c, SDL_Color* color) {
 }
 
 bool sf_gr_set_blend_mode(smgf* const c, SDL_BlendMode b) {
-  return SDL_SetRenderDrawBlendMode(c->renderer, b);
+  return sf_gr_apply_blend_mode(c, b);
 }
 
 bool sf_gr_get_blend_mode(smgf* const c, SDL_BlendMode* b) {
@@ -160,67 +262,556 @@ int sf_gr_get_point(smgf* const c, SDL_Color* color, int x, int y) {
 }
 
 bool sf_gr_draw_point(smgf* const c, float x, float y) {
-  if (!SDL_SetRenderDrawColor(
-          c->renderer, c->curstate->r, c->curstate->g, c->curstate->b,
-          c->curstate->a) != 0) {
+  if (!sf_gr_apply_current_color(c)) {
     return false;
   }
 
+  sf_gr_count_draw(c, NULL);
   return SDL_RenderPoint(c->renderer, c->curstate->x + x, c->curstate->y + y);
 }
 
 bool sf_gr_draw_line(smgf* const c, float x1, float y1, float x2, float y2) {
-  if (!SDL_SetRenderDrawColor(
-          c->renderer, c->curstate->r, c->curstate->g, c->curstate->b,
-          c->curstate->a) != 0) {
+  if (!sf_gr_apply_current_color(c)) {
     return false;
   }
 
+  sf_gr_count_draw(c, NULL);
   return SDL_RenderLine(
       c->renderer, c->curstate->x + x1, c->curstate->y + y1,
       c->curstate->x + x2, c->curstate->y + y2);
 }
 
 bool sf_gr_draw_rect(smgf* const c, float x, float y, float w, float h) {
-  if (!SDL_SetRenderDrawColor(
-          c->renderer, c->curstate->r, c->curstate->g, c->curstate->b,
-          c->curstate->a) != 0) {
+  if (!sf_gr_apply_current_color(c)) {
     return false;
   }
 
   SDL_FRect r = {c->curstate->x + x, c->curstate->y + y, w, h};
+  sf_gr_count_draw(c, NULL);
   return SDL_RenderRect(c->renderer, &r);
 }
 
 bool sf_gr_draw_rectfill(smgf* const c, float x, float y, float w, float h) {
-  if (!SDL_SetRenderDrawColor(
-          c->renderer, c->curstate->r, c->curstate->g, c->curstate->b,
-          c->curstate->a) != 0) {
+  if (!sf_gr_apply_current_color(c)) {
     return false;
   }
 
   SDL_FRect r = {c->curstate->x + x, c->curstate->y + y, w, h};
+  sf_gr_count_draw(c, NULL);
   return SDL_RenderFillRect(c->renderer, &r);
 }
 
-/* int sf_gr_draw_geometry(
-    smgf* const c, stexture* const t, SDL_Vertex* vertices, int nb_vertices,
-    const int* indices, int nb_indices) {
+static inline bool sf_gr_same_color(const SDL_Color* a, const SDL_Color* b) {
+  return a->r == b->r && a->g == b->g && a->b == b->b && a->a == b->a;
+}
+
+// returns the number of consecutive primitives, starting at "start", that
+// share the same color
+static int sf_gr_color_run(const SDL_Color* colors, int start, int n) {
+  int end = start + 1;
+  while (end < n && sf_gr_same_color(&colors[start], &colors[end])) {
+    end++;
+  }
+  return end - start;
+}
+
+static void sf_gr_translate_points(smgf* const c, SDL_FPoint* points, int n) {
+  for (int i = 0; i < n; i++) {
+    points[i].x += c->curstate->x;
+    points[i].y += c->curstate->y;
+  }
+}
+
+static void sf_gr_translate_rects(smgf* const c, SDL_FRect* rects, int n) {
+  for (int i = 0; i < n; i++) {
+    rects[i].x += c->curstate->x;
+    rects[i].y += c->curstate->y;
+  }
+}
+
+// The bulk draw functions below draw "n" primitives with as few SDL calls as
+// possible. Positions are translated in place. If "colors" is NULL, all
+// primitives are drawn with the current color; otherwise there is one color
+// per primitive, and consecutive primitives of the same color are drawn in a
+// single call.
+
+bool sf_gr_draw_points(
+    smgf* const c, SDL_FPoint* points, const SDL_Color* colors, int n) {
+  sf_gr_translate_points(c, points, n);
+
+  if (colors == NULL) {
+    if (!sf_gr_apply_current_color(c)) {
+      return false;
+    }
+    sf_gr_count_draw(c, NULL);
+    return SDL_RenderPoints(c->renderer, points, n);
+  }
+
+  for (int i = 0; i < n;) {
+    int len = sf_gr_color_run(colors, i, n);
+    sf_gr_count_draw(c, NULL);
+    const SDL_Color* col = &colors[i];
+    if (!sf_gr_apply_color(c, col->r, col->g, col->b, col->a) ||
+        !SDL_RenderPoints(c->renderer, &points[i], len)) {
+      return false;
+    }
+    i += len;
+  }
+
+  return true;
+}
+
+// draws a line strip going through the "n" points. When colors are given,
+// each segment is drawn with the color of its first point.
+bool sf_gr_draw_lines(
+    smgf* const c, SDL_FPoint* points, const SDL_Color* colors, int n) {
+  if (n < 2) {
+    return true;
+  }
+
+  sf_gr_translate_points(c, points, n);
+
+  if (colors == NULL) {
+    if (!sf_gr_apply_current_color(c)) {
+      return false;
+    }
+    sf_gr_count_draw(c, NULL);
+    return SDL_RenderLines(c->renderer, points, n);
+  }
+
+  int nb_segments = n - 1;
+  for (int i = 0; i < nb_segments;) {
+    int len = sf_gr_color_run(colors, i, nb_segments);
+    sf_gr_count_draw(c, NULL);
+    const SDL_Color* col = &colors[i];
+    if (!sf_gr_apply_color(c, col->r, col->g, col->b, col->a) ||
+        !SDL_RenderLines(c->renderer, &points[i], len + 1)) {
+      return false;
+    }
+    i += len;
+  }
+
+  return true;
+}
+
+bool sf_gr_draw_rects(
+    smgf* const c, SDL_FRect* rects, const SDL_Color* colors, int n) {
+  sf_gr_translate_rects(c, rects, n);
+
+  if (colors == NULL) {
+    if (!sf_gr_apply_current_color(c)) {
+      return false;
+    }
+    sf_gr_count_draw(c, NULL);
+    return SDL_RenderRects(c->renderer, rects, n);
+  }
+
+  for (int i = 0; i < n;) {
+    int len = sf_gr_color_run(colors, i, n);
+    sf_gr_count_draw(c, NULL);
+    const SDL_Color* col = &colors[i];
+    if (!sf_gr_apply_color(c, col->r, col->g, col->b, col->a) ||
+        !SDL_RenderRects(c->renderer, &rects[i], len)) {
+      return false;
+    }
+    i += len;
+  }
+
+  return true;
+}
+
+// filled rectangles with a color each are converted to colored triangles, so
+// that they are always drawn in a single call whatever their colors
+bool sf_gr_draw_rectfills(
+    smgf* const c, SDL_FRect* rects, const SDL_Color* colors, int n) {
+  sf_gr_translate_rects(c, rects, n);
+
+  if (colors == NULL) {
+    if (!sf_gr_apply_current_color(c)) {
+      return false;
+    }
+    sf_gr_count_draw(c, NULL);
+    return SDL_RenderFillRects(c->renderer, rects, n);
+  }
+
+  if (n == 0) {
+    return true;
+  }
+
+  SDL_Vertex* vertices = sf_gr_scratch_reserve(
+      &c->geometry_buffer, (sizeof(SDL_Vertex) * 4 + sizeof(int) * 6) * n);
+  if (vertices == NULL) {
+    return false;
+  }
+  int* indices = (int*) (vertices + 4 * n);
+
+  for (int i = 0; i < n; i++) {
+    const SDL_FRect* r = &rects[i];
+    SDL_FColor color = {
+        colors[i].r / 255.f, colors[i].g / 255.f, colors[i].b / 255.f,
+        colors[i].a / 255.f};
+
+    SDL_Vertex* v = &vertices[i * 4];
+    v[0].position.x = r->x;
+    v[0].position.y = r->y;
+    v[1].position.x = r->x + r->w;
+    v[1].position.y = r->y;
+    v[2].position.x = r->x + r->w;
+    v[2].position.y = r->y + r->h;
+    v[3].position.x = r->x;
+    v[3].position.y = r->y + r->h;
+    for (int j = 0; j < 4; j++) {
+      v[j].color = color;
+      v[j].tex_coord.x = 0;
+      v[j].tex_coord.y = 0;
+    }
+
+    int* idx = &indices[i * 6];
+    idx[0] = i * 4 + 0;
+    idx[1] = i * 4 + 1;
+    idx[2] = i * 4 + 2;
+    idx[3] = i * 4 + 2;
+    idx[4] = i * 4 + 3;
+    idx[5] = i * 4 + 0;
+  }
+
+  return sf_gr_draw_geometry(c, NULL, vertices, n * 4, indices, n * 6);
+}
+
+bool sf_gr_draw_geometry(
+    smgf* const c, stexture* const t, const SDL_Vertex* vertices,
+    int nb_vertices, const int* indices, int nb_indices) {
+  if (t != NULL) {
+    // colors are stored in the vertices, so the texture itself must not be
+    // tinted by a previous call to sf_gr_texture_draw
+    sf_gr_apply_texture_mod(c, t, 255, 255, 255, 255);
+  }
+
+  sf_gr_count_draw(c, t ? t->tex : NULL);
   return SDL_RenderGeometry(
       c->renderer, t ? t->tex : NULL, vertices, nb_vertices, indices,
       nb_indices);
-} */
+}
+
+// returns a memory block of at least "size" bytes (or NULL if it cannot be
+// allocated). The block is kept between calls and only grows.
+void* sf_gr_scratch_reserve(sscratch* const s, size_t size) {
+  if (size > s->size) {
+    size_t new_size = s->size * 2 > size ? s->size * 2 : size;
+    void* data = SDL_realloc(s->data, new_size);
+    if (data == NULL) {
+      SDL_SetError("error allocating memory for drawing");
+      return NULL;
+    }
+    s->data = data;
+    s->size = new_size;
+  }
+
+  return s->data;
+}
+
+void sf_gr_scratch_del(sscratch* const s) {
+  if (s->data != NULL) {
+    SDL_free(s->data);
+    s->data = NULL;
+  }
+  s->size = 0;
+}
+
+// DBGP sets the draw color (and blend mode) of the renderer by itself
+static inline void sf_gr_invalidate_print_state(smgf* const c) {
+  c->rstate.color_valid = false;
+  c->rstate.blend_mode_valid = false;
+}
+
+static inline stexture* sf_gr_current_target(smgf* const c) {
+  return c->curstate->target == NULL ? c->screen_texture : c->curstate->target;
+}
+
+// renders the string of a text in its render target, which is created if
+// needed. "color" is a DBGP_ColorPrint color, or -1 to use DBGP_Print with
+// "fg" and "bg". Changes the render target.
+static bool sf_gr_text_render(
+    smgf* const c, stext* const t, int color, SDL_Color fg, SDL_Color bg) {
+  // render targets have been lost: the texture is re-created
+  if (t->render_generation != c->render_generation) {
+    sf_gr_texture_del(c, &t->texture);
+    t->render_generation = c->render_generation;
+  }
+
+  if (t->texture.tex == NULL &&
+      sf_gr_texture_new_empty(c, &t->texture, t->width, t->height) != 0) {
+    return false;
+  }
+
+  bool result = sf_gr_apply_target(c, t->texture.tex) &&
+                sf_gr_apply_color(c, 0, 0, 0, 0) &&
+                SDL_RenderClear(c->renderer);
+  if (result) {
+    sf_gr_count_draw(c, NULL);
+    result = color >= 0 ? DBGP_ColorPrint(
+                              &c->font, c->renderer, 0, 0, (Uint8) color,
+                              t->str)
+                        : DBGP_Print(
+                              &c->font, c->renderer, 0, 0, bg, fg, t->str);
+    sf_gr_invalidate_print_state(c);
+  }
+
+  if (!result) {
+    sf_gr_texture_del(c, &t->texture);
+  }
+  return result;
+}
+
+int sf_gr_text_new(stext* const t, const char* str) {
+  SDL_zerop(t);
+
+  // DBGP uses a fixed-width font
+  int nb_lines = 1, nb_columns = 0, max_columns = 0;
+  for (const char* p = str; *p != '\0'; p++) {
+    if (*p == '\n') {
+      nb_lines += 1;
+      nb_columns = 0;
+    } else {
+      nb_columns += 1;
+      max_columns = SDL_max(max_columns, nb_columns);
+    }
+  }
+  t->width = max_columns * TEXT_GLYPH_WIDTH;
+  t->height = max_columns > 0 ? nb_lines * TEXT_GLYPH_HEIGHT : 0;
+
+  t->str = SDL_strdup(str);
+  if (t->str == NULL) {
+    SDL_SetError("error allocating memory for text");
+    return -1;
+  }
+
+  return 0;
+}
+
+void sf_gr_text_del(smgf* const c, stext* const t) {
+  sf_gr_texture_del(c, &t->texture);
+  if (t->str != NULL) {
+    SDL_free(t->str);
+    t->str = NULL;
+  }
+}
+
+// draws a text rendered in white, tinted with the current color
+bool sf_gr_text_draw(smgf* const c, stext* const t, float x, float y) {
+  if (t->width == 0) {
+    return true;
+  }
+
+  if (t->texture.tex == NULL || t->render_generation != c->render_generation) {
+    SDL_Color white = {255, 255, 255, 255};
+    SDL_Color transparent = {0, 0, 0, 0};
+    bool rendered = sf_gr_text_render(c, t, -1, white, transparent);
+    if (!sf_gr_apply_target(c, sf_gr_current_target(c)->tex) || !rendered) {
+      return false;
+    }
+  }
+
+  return sf_gr_texture_draw(
+      c, &t->texture, x, y, 0, 0, 0, 0, 1, 1, 0, 0, 0, SDL_FLIP_NONE);
+}
+
+static Uint32 sf_gr_text_cache_hash(
+    const char* str, int color, SDL_Color fg, SDL_Color bg) {
+  Uint32 hash = smgf_hash_fnv1a(SMGF_FNV1A_INIT, str, SDL_strlen(str));
+  Uint8 key[9] = {
+      (Uint8) color, fg.r, fg.g, fg.b, fg.a, bg.r, bg.g, bg.b, bg.a};
+  return smgf_hash_fnv1a(hash, key, sizeof(key));
+}
+
+static inline size_t sf_gr_text_cache_size(stext* const t) {
+  return (size_t) t->width * t->height * 4;
+}
+
+static void sf_gr_text_cache_unlink(
+    stext_cache* const tc, stext_cache_entry* const e) {
+  if (e->lru_prev != NULL) {
+    e->lru_prev->lru_next = e->lru_next;
+  } else {
+    tc->lru_first = e->lru_next;
+  }
+  if (e->lru_next != NULL) {
+    e->lru_next->lru_prev = e->lru_prev;
+  } else {
+    tc->lru_last = e->lru_prev;
+  }
+  e->lru_prev = NULL;
+  e->lru_next = NULL;
+}
+
+static void sf_gr_text_cache_push_front(
+    stext_cache* const tc, stext_cache_entry* const e) {
+  e->lru_next = tc->lru_first;
+  if (tc->lru_first != NULL) {
+    tc->lru_first->lru_prev = e;
+  } else {
+    tc->lru_last = e;
+  }
+  tc->lru_first = e;
+}
+
+static void sf_gr_text_cache_remove(
+    smgf* const c, stext_cache_entry* const e) {
+  stext_cache* const tc = &c->text_cache;
+
+  stext_cache_entry** p = &tc->buckets[e->hash % TEXT_CACHE_NB_BUCKETS];
+  while (*p != e) {
+    p = &(*p)->next;
+  }
+  *p = e->next;
+  sf_gr_text_cache_unlink(tc, e);
+
+  if (e->text.texture.tex != NULL) {
+    tc->memory -= sf_gr_text_cache_size(&e->text);
+  }
+  sf_gr_text_del(c, &e->text);
+  SDL_free(e);
+  tc->nb_entries -= 1;
+}
+
+void sf_gr_text_cache_clear(smgf* const c) {
+  while (c->text_cache.lru_last != NULL) {
+    sf_gr_text_cache_remove(c, c->text_cache.lru_last);
+  }
+  SDL_zeroa(c->text_cache.seen);
+}
+
+// returns the cached text for these parameters, rendered and ready to be
+// drawn, or NULL if the text has to be drawn directly by DBGP (first time it
+// is seen, too large for the cache, or error). Changes the render target.
+static stext* sf_gr_text_cache_get(
+    smgf* const c, const char* str, int color, SDL_Color fg, SDL_Color bg) {
+  stext_cache* const tc = &c->text_cache;
+  Uint32 hash = sf_gr_text_cache_hash(str, color, fg, bg);
+  stext_cache_entry** bucket = &tc->buckets[hash % TEXT_CACHE_NB_BUCKETS];
+
+  stext_cache_entry* e = *bucket;
+  while (e != NULL) {
+    if (e->hash == hash && e->color == color &&
+        (color >= 0 || (sf_gr_same_color(&e->fg, &fg) &&
+                        sf_gr_same_color(&e->bg, &bg))) &&
+        SDL_strcmp(e->text.str, str) == 0) {
+      break;
+    }
+    e = e->next;
+  }
+
+  if (e == NULL) {
+    // first time: only its hash is kept
+    Uint32* const seen = &tc->seen[hash % TEXT_CACHE_NB_SEEN];
+    if (*seen != hash) {
+      *seen = hash;
+      c->stats.nb_text_misses += 1;
+      return NULL;
+    }
+
+    if (tc->nb_entries >= TEXT_CACHE_MAX_ENTRIES) {
+      sf_gr_text_cache_remove(c, tc->lru_last);
+    }
+
+    e = SDL_calloc(1, sizeof(stext_cache_entry));
+    if (e == NULL) {
+      return NULL;
+    }
+    if (sf_gr_text_new(&e->text, str) != 0) {
+      SDL_free(e);
+      return NULL;
+    }
+    e->hash = hash;
+    e->color = color;
+    e->fg = fg;
+    e->bg = bg;
+    e->next = *bucket;
+    *bucket = e;
+    sf_gr_text_cache_push_front(tc, e);
+    tc->nb_entries += 1;
+  }
+
+  sf_gr_text_cache_unlink(tc, e);
+  sf_gr_text_cache_push_front(tc, e);
+
+  stext* const t = &e->text;
+  size_t size = sf_gr_text_cache_size(t);
+  if (t->width == 0 || size > TEXT_CACHE_BUDGET) {
+    c->stats.nb_text_misses += 1;
+    return NULL;
+  }
 
-int sf_gr_print_color(
+  if (t->texture.tex != NULL && t->render_generation == c->render_generation) {
+    c->stats.nb_text_hits += 1;
+    return t;
+  }
+
+  // seen for the second time (or texture lost): rendered in a texture
+  c->stats.nb_text_misses += 1;
+  if (t->texture.tex == NULL) {
+    while (tc->memory + size > TEXT_CACHE_BUDGET) {
+      sf_gr_text_cache_remove(c, tc->lru_last);
+    }
+    tc->memory += size;
+  }
+
+  if (!sf_gr_text_render(c, t, color, fg, bg)) {
+    tc->memory -= size;
+    return NULL;
+  }
+  // DBGP drew over a transparent texture with alpha blending, which gives
+  // premultiplied colors
+  sf_gr_texture_set_blend_mode(
+      c, &t->texture, SDL_BLENDMODE_BLEND_PREMULTIPLIED);
+  return t;
+}
+
+static bool sf_gr_text_cache_draw(
+    smgf* const c, stext* const t, int x, int y) {
+  if (!sf_gr_apply_target(c, sf_gr_current_target(c)->tex)) {
+    return false;
+  }
+
+  SDL_FRect dst = {x, y, t->width, t->height};
+  sf_gr_apply_texture_mod(c, &t->texture, 255, 255, 255, 255);
+  sf_gr_count_draw(c, t->texture.tex);
+  return SDL_RenderTexture(c->renderer, t->texture.tex, NULL, &dst);
+}
+
+bool sf_gr_print_color(
     smgf* const c, int x, int y, Uint8 color, const char* str) {
-  return DBGP_ColorPrint(&c->font, c->renderer, x, y, color, str);
+  SDL_Color none = {0, 0, 0, 0};
+  stext* const t = sf_gr_text_cache_get(c, str, color, none, none);
+  if (t != NULL) {
+    return sf_gr_text_cache_draw(c, t, x, y);
+  }
+
+  // the text cache may have changed the render target
+  sf_gr_apply_target(c, sf_gr_current_target(c)->tex);
+  sf_gr_count_draw(c, NULL);
+  bool result = DBGP_ColorPrint(&c->font, c->renderer, x, y, color, str);
+  sf_gr_invalidate_print_state(c);
+  return result;
 }
 
-int sf_gr_print(
+bool sf_gr_print(
     smgf* const c, int x, int y, const char* str, SDL_Color bg_color) {
   SDL_Color fg_color = {0, 0, 0, 255};
   sf_gr_get_color(c, &fg_color);
-  return DBGP_Print(&c->font, c->renderer, x, y, bg_color, fg_color, str);
+
+  stext* const t = sf_gr_text_cache_get(c, str, -1, fg_color, bg_color);
+  if (t != NULL) {
+    return sf_gr_text_cache_draw(c, t, x, y);
+  }
+
+  // the text cache may have changed the render target
+  sf_gr_apply_target(c, sf_gr_current_target(c)->tex);
+  sf_gr_count_draw(c, NULL);
+  bool result =
+      DBGP_Print(&c->font, c->renderer, x, y, bg_color, fg_color, str);
+  sf_gr_invalidate_print_state(c);
+  return result;
 }
 
 int sf_gr_texture_new(smgf* const c, stexture* const t, const char* filename) {
@@ -234,12 +825,14 @@ int sf_gr_texture_new(smgf* const c, stexture* const t, const char* filename) {
   t->width = 0;
   t->height = 0;
   t->format = 0;
+  t->mod.r = t->mod.g = t->mod.b = t->mod.a = 255; // SDL defaults
+  t->blend_mode = SDL_BLENDMODE_INVALID;
 
   if (t->tex == NULL) {
     return -1;
   }
 
-  sf_gr_texture_set_blend_mode(t, SDL_BLENDMODE_BLEND);
+  sf_gr_texture_set_blend_mode(c, t, SDL_BLENDMODE_BLEND);
 
   SDL_PropertiesID props = SDL_GetTextureProperties(t->tex);
   if (props == 0) {
@@ -258,18 +851,28 @@ int sf_gr_texture_new_empty(smgf* const c, stexture* const t, int w, int h) {
   t->width = w;
   t->height = h;
   t->format = 0;
+  t->mod.r = t->mod.g = t->mod.b = t->mod.a = 255; // SDL defaults
+  t->blend_mode = SDL_BLENDMODE_INVALID;
 
   if (t->tex == NULL) {
     return -1;
   }
 
-  sf_gr_texture_set_blend_mode(t, SDL_BLENDMODE_BLEND);
+  sf_gr_texture_set_blend_mode(c, t, SDL_BLENDMODE_BLEND);
   SDL_SetTextureScaleMode(t->tex, SDL_SCALEMODE_NEAREST);
   return 0;
 }
 
-void sf_gr_texture_del(stexture* const t) {
+void sf_gr_texture_del(smgf* const c, stexture* const t) {
   if (t->tex != NULL) {
+    // SDL resets the render target when it is destroyed: a new texture could
+    // then be allocated at the same address
+    if (c->rstate.target == t->tex) {
+      c->rstate.target_valid = false;
+    }
+    if (c->rstate.texture == t->tex) {
+      c->rstate.texture = NULL;
+    }
     SDL_DestroyTexture(t->tex);
     t->tex = NULL;
   }
@@ -288,10 +891,10 @@ bool sf_gr_texture_draw(
       c->curstate->x + x, c->curstate->y + y, qw * sx, qh * sy};
   SDL_FPoint center = {ox, oy};
 
-  SDL_SetTextureColorMod(
-      t->tex, c->curstate->r, c->curstate->g, c->curstate->b);
-  SDL_SetTextureAlphaMod(t->tex, c->curstate->a);
+  sf_gr_apply_texture_mod(
+      c, t, c->curstate->r, c->curstate->g, c->curstate->b, c->curstate->a);
 
+  sf_gr_count_draw(c, t->tex);
   return SDL_RenderTextureRotated(
       c->renderer, t->tex, &srcrect, &dstrect, r, &center, flip);
 }
@@ -309,16 +912,16 @@ int sf_gr_texture_save(smgf* const c, stexture* const t, const char* filename) {
   // format = SDL_GetNumberProperty(props, SDL_PROP_TEXTURE_FORMAT_NUMBER, 0);
 
   // copying from renderer to surface
-  SDL_SetRenderTarget(c->renderer, t->tex);
+  sf_gr_apply_target(c, t->tex);
 
   // @TODO: LockTexture and copy pixels directly instead of calling
   // RenderReadPixels?
   SDL_Surface* s = SDL_RenderReadPixels(c->renderer, NULL);
 
   if (c->curstate->target == NULL) {
-    SDL_SetRenderTarget(c->renderer, c->screen_texture->tex);
+    sf_gr_apply_target(c, c->screen_texture->tex);
   } else {
-    SDL_SetRenderTarget(c->renderer, c->curstate->target->tex);
+    sf_gr_apply_target(c, c->curstate->target->tex);
   }
 
   if (s == NULL) {
@@ -349,10 +952,469 @@ int sf_gr_texture_get_dimensions(stexture* const t, int* w, int* h) {
   return 0;
 }
 
-bool sf_gr_texture_set_blend_mode(stexture* const t, SDL_BlendMode b) {
-  return SDL_SetTextureBlendMode(t->tex, b);
+bool sf_gr_texture_set_blend_mode(
+    smgf* const c, stexture* const t, SDL_BlendMode b) {
+  if (t->blend_mode == b) {
+    c->rstate.nb_skipped += 1;
+    return true;
+  }
+
+  c->rstate.nb_issued += 1;
+  if (!SDL_SetTextureBlendMode(t->tex, b)) {
+    t->blend_mode = SDL_BLENDMODE_INVALID;
+    return false;
+  }
+  t->blend_mode = b;
+  return true;
 }
 
 bool sf_gr_texture_get_blend_mode(stexture* const t, SDL_BlendMode* b) {
   return SDL_GetTextureBlendMode(t->tex, b);
 }
+
+// grows the vertex & index buffers of a batch so that it can hold at least
+// "capacity" sprites. Indices never change once written (two triangles per
+// quad), so they are only filled for the newly allocated sprites.
+static int sf_gr_batch_reserve(sbatch* const b, int capacity) {
+  if (capacity <= b->capacity) {
+    return 0;
+  }
+
+  SDL_Vertex* vertices =
+      SDL_realloc(b->vertices, sizeof(SDL_Vertex) * 4 * capacity);
+  if (vertices == NULL) {
+    return -1;
+  }
+  b->vertices = vertices;
+
+  int* indices = SDL_realloc(b->indices, sizeof(int) * 6 * capacity);
+  if (indices == NULL) {
+    return -1;
+  }
+  b->indices = indices;
+
+  for (int i = b->capacity; i < capacity; i++) {
+    int* idx = &b->indices[i * 6];
+    int v = i * 4;
+    idx[0] = v + 0;
+    idx[1] = v + 1;
+    idx[2] = v + 2;
+    idx[3] = v + 2;
+    idx[4] = v + 3;
+    idx[5] = v + 0;
+  }
+
+  b->capacity = capacity;
+  return 0;
+}
+
+int sf_gr_batch_new(sbatch* const b, stexture* const t, int capacity) {
+  b->texture = t;
+  b->vertices = NULL;
+  b->indices = NULL;
+  b->nb_sprites = 0;
+  b->capacity = 0;
+
+  if (sf_gr_batch_reserve(b, capacity > 0 ? capacity : 1) != 0) {
+    sf_gr_batch_del(b);
+    SDL_SetError("error allocating memory for batch");
+    return -1;
+  }
+
+  return 0;
+}
+
+void sf_gr_batch_del(sbatch* const b) {
+  if (b->vertices != NULL) {
+    SDL_free(b->vertices);
+    b->vertices = NULL;
+  }
+  if (b->indices != NULL) {
+    SDL_free(b->indices);
+    b->indices = NULL;
+  }
+  b->nb_sprites = 0;
+  b->capacity = 0;
+}
+
+// adds a sprite to the batch. Parameters are the same as sf_gr_texture_draw:
+// the current color and translation are captured at the time of the call.
+int sf_gr_batch_add(
+    smgf* const c, sbatch* const b, float x, float y, int qx, int qy, int qw,
+    int qh, float sx, float sy, double r, float ox, float oy, int flip) {
+  if (b->nb_sprites >= b->capacity) {
+    if (sf_gr_batch_reserve(b, b->capacity * 2) != 0) {
+      SDL_SetError("error allocating memory for batch");
+      return -1;
+    }
+  }
+
+  stexture* const t = b->texture;
+  if (!qx && !qy && !qw && !qh) {
+    qw = t->width;
+    qh = t->height;
+  }
+
+  // texture coordinates, swapped when flipping
+  float u1 = (float) qx / t->width;
+  float v1 = (float) qy / t->height;
+  float u2 = (float) (qx + qw) / t->width;
+  float v2 = (float) (qy + qh) / t->height;
+  if (flip & SDL_FLIP_HORIZONTAL) {
+    float tmp = u1;
+    u1 = u2;
+    u2 = tmp;
+  }
+  if (flip & SDL_FLIP_VERTICAL) {
+    float tmp = v1;
+    v1 = v2;
+    v2 = tmp;
+  }
+
+  // corners relative to the rotation origin, clockwise from top-left
+  float w = qw * sx;
+  float h = qh * sy;
+  const float corners[4][2] = {
+      {-ox, -oy}, {w - ox, -oy}, {w - ox, h - oy}, {-ox, h - oy}};
+  const float uvs[4][2] = {{u1, v1}, {u2, v1}, {u2, v2}, {u1, v2}};
+
+  // same convention as SDL_RenderTextureRotated: degrees, clockwise
+  float cos_r = 1;
+  float sin_r = 0;
+  if (r != 0) {
+    double rad = r * SDL_PI_D / 180.0;
+    cos_r = SDL_cos(rad);
+    sin_r = SDL_sin(rad);
+  }
+
+  float px = c->curstate->x + x + ox;
+  float py = c->curstate->y + y + oy;
+  SDL_FColor color = {
+      c->curstate->r / 255.f, c->curstate->g / 255.f, c->curstate->b / 255.f,
+      c->curstate->a / 255.f};
+
+  SDL_Vertex* v = &b->vertices[b->nb_sprites * 4];
+  for (int i = 0; i < 4; i++) {
+    v[i].position.x = px + corners[i][0] * cos_r - corners[i][1] * sin_r;
+    v[i].position.y = py + corners[i][0] * sin_r + corners[i][1] * cos_r;
+    v[i].color = color;
+    v[i].tex_coord.x = uvs[i][0];
+    v[i].tex_coord.y = uvs[i][1];
+  }
+
+  b->nb_sprites += 1;
+  return b->nb_sprites;
+}
+
+void sf_gr_batch_clear(sbatch* const b) {
+  b->nb_sprites = 0;
+}
+
+bool sf_gr_batch_draw(smgf* const c, sbatch* const b) {
+  if (b->nb_sprites == 0) {
+    return true;
+  }
+
+  return sf_gr_draw_geometry(
+      c, b->texture, b->vertices, b->nb_sprites * 4, b->indices,
+      b->nb_sprites * 6);
+}
+
+int sf_gr_mesh_new(smesh* const m, int nb_vertices, int nb_indices) {
+  m->texture = NULL;
+  m->vertices = NULL;
+  m->translated = NULL;
+  m->translated_valid = false;
+  m->indices = NULL;
+  m->nb_vertices = nb_vertices;
+  m->nb_indices = nb_indices;
+
+  m->vertices = SDL_calloc(nb_vertices, sizeof(SDL_Vertex));
+  if (m->vertices == NULL) {
+    SDL_SetError("error allocating memory for mesh vertices");
+    return -1;
+  }
+
+  if (nb_indices > 0) {
+    m->indices = SDL_calloc(nb_indices, sizeof(int));
+    if (m->indices == NULL) {
+      sf_gr_mesh_del(m);
+      SDL_SetError("error allocating memory for mesh indices");
+      return -1;
+    }
+  }
+
+  // vertices default to opaque white
+  for (int i = 0; i < nb_vertices; i++) {
+    m->vertices[i].color.r = 1;
+    m->vertices[i].color.g = 1;
+    m->vertices[i].color.b = 1;
+    m->vertices[i].color.a = 1;
+  }
+
+  return 0;
+}
+
+void sf_gr_mesh_del(smesh* const m) {
+  if (m->vertices != NULL) {
+    SDL_free(m->vertices);
+    m->vertices = NULL;
+  }
+  if (m->translated != NULL) {
+    SDL_free(m->translated);
+    m->translated = NULL;
+  }
+  if (m->indices != NULL) {
+    SDL_free(m->indices);
+    m->indices = NULL;
+  }
+  m->nb_vertices = 0;
+  m->nb_indices = 0;
+}
+
+// note: "i" and "index" are 0-based
+void sf_gr_mesh_set_vertex(smesh* const m, int i, const SDL_Vertex* v) {
+  m->vertices[i] = *v;
+  m->translated_valid = false;
+}
+
+void sf_gr_mesh_set_index(smesh* const m, int i, int index) {
+  m->indices[i] = index;
+}
+
+// draws the mesh at (x, y) + current translation. Vertices are only copied
+// when the mesh is drawn with an offset, and the copy is kept until the
+// offset or the vertices change.
+bool sf_gr_mesh_draw(smgf* const c, smesh* const m, float x, float y) {
+  const SDL_Vertex* vertices = m->vertices;
+
+  x += c->curstate->x;
+  y += c->curstate->y;
+  if (x != 0 || y != 0) {
+    // the copy buffer is allocated once, the first time it is needed
+    if (m->translated == NULL) {
+      m->translated = SDL_malloc(sizeof(SDL_Vertex) * m->nb_vertices);
+      if (m->translated == NULL) {
+        SDL_SetError("error allocating memory for mesh");
+        return false;
+      }
+    }
+
+    if (!m->translated_valid || m->translated_x != x ||
+        m->translated_y != y) {
+      for (int i = 0; i < m->nb_vertices; i++) {
+        m->translated[i] = m->vertices[i];
+        m->translated[i].position.x += x;
+        m->translated[i].position.y += y;
+      }
+      m->translated_x = x;
+      m->translated_y = y;
+      m->translated_valid = true;
+    }
+    vertices = m->translated;
+  }
+
+  return sf_gr_draw_geometry(
+      c, m->texture, vertices, m->nb_vertices, m->indices, m->nb_indices);
+}
+
+int sf_gr_tilemap_new(
+    stilemap* const m, stexture* const t, int tile_w, int tile_h, int map_w,
+    int map_h) {
+  m->tileset = t;
+  m->tile_w = tile_w;
+  m->tile_h = tile_h;
+  m->map_w = map_w;
+  m->map_h = map_h;
+  m->nb_columns = t->width / tile_w;
+  m->nb_chunks_x = (map_w + TILEMAP_CHUNK_SIZE - 1) / TILEMAP_CHUNK_SIZE;
+  m->nb_chunks_y = (map_h + TILEMAP_CHUNK_SIZE - 1) / TILEMAP_CHUNK_SIZE;
+  m->render_generation = 0;
+
+  int nb_chunks = m->nb_chunks_x * m->nb_chunks_y;
+  m->tiles = SDL_calloc(map_w * map_h, sizeof(Uint16));
+  m->chunks = SDL_calloc(nb_chunks, sizeof(stexture));
+  m->dirty = SDL_calloc(nb_chunks, sizeof(bool));
+  if (m->tiles == NULL || m->chunks == NULL || m->dirty == NULL) {
+    SDL_free(m->tiles);
+    SDL_free(m->chunks);
+    SDL_free(m->dirty);
+    m->tiles = NULL;
+    m->chunks = NULL;
+    m->dirty = NULL;
+    SDL_SetError("error allocating memory for tilemap");
+    return -1;
+  }
+
+  return 0;
+}
+
+void sf_gr_tilemap_del(smgf* const c, stilemap* const m) {
+  if (m->chunks != NULL) {
+    for (int i = 0; i < m->nb_chunks_x * m->nb_chunks_y; i++) {
+      sf_gr_texture_del(c, &m->chunks[i]);
+    }
+    SDL_free(m->chunks);
+    m->chunks = NULL;
+  }
+  if (m->tiles != NULL) {
+    SDL_free(m->tiles);
+    m->tiles = NULL;
+  }
+  if (m->dirty != NULL) {
+    SDL_free(m->dirty);
+    m->dirty = NULL;
+  }
+}
+
+// note: "x" and "y" are 0-based
+void sf_gr_tilemap_set_tile(stilemap* const m, int x, int y, Uint16 tile) {
+  Uint16* t = &m->tiles[y * m->map_w + x];
+  if (*t == tile) {
+    return;
+  }
+
+  *t = tile;
+  int chunk_x = x / TILEMAP_CHUNK_SIZE;
+  int chunk_y = y / TILEMAP_CHUNK_SIZE;
+  m->dirty[chunk_y * m->nb_chunks_x + chunk_x] = true;
+}
+
+Uint16 sf_gr_tilemap_get_tile(stilemap* const m, int x, int y) {
+  return m->tiles[y * m->map_w + x];
+}
+
+// renders the tiles of a chunk into its render target, which is created the
+// first time the chunk contains a tile. Changes the render target.
+static bool sf_gr_tilemap_render_chunk(
+    smgf* const c, stilemap* const m, int chunk_x, int chunk_y) {
+  stexture* const chunk = &m->chunks[chunk_y * m->nb_chunks_x + chunk_x];
+  int x0 = chunk_x * TILEMAP_CHUNK_SIZE;
+  int y0 = chunk_y * TILEMAP_CHUNK_SIZE;
+  int x1 = SDL_min(x0 + TILEMAP_CHUNK_SIZE, m->map_w);
+  int y1 = SDL_min(y0 + TILEMAP_CHUNK_SIZE, m->map_h);
+
+  if (chunk->tex == NULL) {
+    bool is_empty = true;
+    for (int y = y0; y < y1 && is_empty; y++) {
+      for (int x = x0; x < x1; x++) {
+        if (m->tiles[y * m->map_w + x] != 0) {
+          is_empty = false;
+          break;
+        }
+      }
+    }
+    if (is_empty) {
+      return true;
+    }
+
+    if (sf_gr_texture_new_empty(
+            c, chunk, TILEMAP_CHUNK_SIZE * m->tile_w,
+            TILEMAP_CHUNK_SIZE * m->tile_h) != 0) {
+      return false;
+    }
+  }
+
+  if (!sf_gr_apply_target(c, chunk->tex) ||
+      !sf_gr_apply_color(c, 0, 0, 0, 0) || !SDL_RenderClear(c->renderer)) {
+    return false;
+  }
+
+  // tiles do not overlap, so they are copied as is (alpha included)
+  stexture* const tileset = m->tileset;
+  SDL_BlendMode blend_mode = tileset->blend_mode;
+  sf_gr_texture_set_blend_mode(c, tileset, SDL_BLENDMODE_NONE);
+  sf_gr_apply_texture_mod(c, tileset, 255, 255, 255, 255);
+
+  bool result = true;
+  for (int y = y0; y < y1; y++) {
+    for (int x = x0; x < x1; x++) {
+      int tile = m->tiles[y * m->map_w + x];
+      if (tile == 0) {
+        continue;
+      }
+      tile -= 1;
+
+      SDL_FRect src = {
+          (tile % m->nb_columns) * m->tile_w,
+          (tile / m->nb_columns) * m->tile_h, m->tile_w, m->tile_h};
+      SDL_FRect dst = {
+          (x - x0) * m->tile_w, (y - y0) * m->tile_h, m->tile_w, m->tile_h};
+      sf_gr_count_draw(c, tileset->tex);
+      if (!SDL_RenderTexture(c->renderer, tileset->tex, &src, &dst)) {
+        result = false;
+      }
+    }
+  }
+
+  sf_gr_texture_set_blend_mode(c, tileset, blend_mode);
+  return result;
+}
+
+// draws the chunks of the tilemap that are visible on the current target.
+// Dirty chunks are re-rendered first, so that the render target is only
+// switched back once.
+bool sf_gr_tilemap_draw(smgf* const c, stilemap* const m, float x, float y) {
+  int nb_chunks = m->nb_chunks_x * m->nb_chunks_y;
+
+  // render targets have been lost: chunks are re-created
+  if (m->render_generation != c->render_generation) {
+    for (int i = 0; i < nb_chunks; i++) {
+      sf_gr_texture_del(c, &m->chunks[i]);
+      m->dirty[i] = true;
+    }
+    m->render_generation = c->render_generation;
+  }
+
+  stexture* const target =
+      c->curstate->target == NULL ? c->screen_texture : c->curstate->target;
+  x += c->curstate->x;
+  y += c->curstate->y;
+
+  float chunk_w = TILEMAP_CHUNK_SIZE * m->tile_w;
+  float chunk_h = TILEMAP_CHUNK_SIZE * m->tile_h;
+
+  // range of chunks intersecting the target
+  int cx0 = SDL_max(0, (int) SDL_floorf(-x / chunk_w));
+  int cy0 = SDL_max(0, (int) SDL_floorf(-y / chunk_h));
+  int cx1 = SDL_min(
+      m->nb_chunks_x, (int) SDL_ceilf((target->width - x) / chunk_w));
+  int cy1 = SDL_min(
+      m->nb_chunks_y, (int) SDL_ceilf((target->height - y) / chunk_h));
+
+  bool result = true;
+  bool target_changed = false;
+  for (int cy = cy0; cy < cy1; cy++) {
+    for (int cx = cx0; cx < cx1; cx++) {
+      int i = cy * m->nb_chunks_x + cx;
+      if (m->dirty[i]) {
+        result = sf_gr_tilemap_render_chunk(c, m, cx, cy) && result;
+        m->dirty[i] = false;
+        target_changed = true;
+      }
+    }
+  }
+  if (target_changed) {
+    result = sf_gr_apply_target(c, target->tex) && result;
+  }
+
+  for (int cy = cy0; cy < cy1; cy++) {
+    for (int cx = cx0; cx < cx1; cx++) {
+      stexture* const chunk = &m->chunks[cy * m->nb_chunks_x + cx];
+      if (chunk->tex == NULL) {
+        continue;
+      }
+
+      SDL_FRect dst = {x + cx * chunk_w, y + cy * chunk_h, chunk_w, chunk_h};
+      sf_gr_apply_texture_mod(
+          c, chunk, c->curstate->r, c->curstate->g, c->curstate->b,
+          c->curstate->a);
+      sf_gr_count_draw(c, chunk->tex);
+      if (!SDL_RenderTexture(c->renderer, chunk->tex, NULL, &dst)) {
+        result = false;
+      }
+    }
+  }
+
+  return result;
+}
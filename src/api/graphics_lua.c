@@ -205,168 +205,165 @@ static int l_draw_rectfill(lua_State* L) {
   return 0;
 }
 
-/* static int l_draw_geometry(lua_State* L) {
+// reads a flat array of numbers at index narg (2 numbers per point, 4 per
+// rectangle) and an optional flat array of colors at index narg + 1 (4 numbers
+// per primitive: RGBA) into the draw buffer of smgf, which is reused between
+// calls. The arrays can be tables or buffers: "f32" (without translation) and
+// "u8" buffers are used directly, without copy. Returns the number of
+// primitives.
+static int lua_get_primitives(
+    lua_State* L, int narg, int nb_components, float** values,
+    SDL_Color** colors) {
   smgf* const c = get_smgf(L);
 
-  stexture* t = (stexture*) luaL_testudata(L, 1, SMGF_TYPE_TEXTURE);
-
-  if (!lua_istable(L, 2)) {
-    return luaL_argerror(L, 2, "expected vertices table");
+  sbuffer* values_buffer = l_testudata(L, narg, SMGF_TYPE_BUFFER);
+  if (values_buffer == NULL) {
+    luaL_checktype(L, narg, LUA_TTABLE);
   }
-
-  int nb_vertices = luaL_len(L, 2);
-  if (nb_vertices % 3 != 0 || nb_vertices <= 0) {
+  lua_Integer len =
+      values_buffer != NULL ? (lua_Integer) values_buffer->length
+                            : luaL_len(L, narg);
+  if (len % nb_components != 0) {
     return luaL_argerror(
-        L, 2,
-        "invalid vertices table: length must be divisible by 3 (and non-zero)");
+        L, narg,
+        nb_components == 2 ? "must have 2 components per point (XY)"
+                           : "must have 4 components per rectangle (XYWH)");
   }
-
-  // @TODO: test code, move memory allocation outside of this function
-  SDL_Vertex* vertices = SDL_malloc(sizeof(SDL_Vertex) * nb_vertices);
-  if (vertices == NULL) {
-    return luaL_argerror(L, 2, "memory error");
-  }
-
-  // iter over all vertices
-  int i = 0;
-  lua_pushnil(L);
-  while (lua_next(L, 2) != 0) {
-    if (!lua_istable(L, -1)) {
-      return luaL_argerror(
-          L, 2, "expected vertices table to contain vertices objects");
+  luaL_argcheck(L, len / nb_components <= SDL_MAX_SINT32, narg, "too large");
+  int n = len / nb_components;
+
+  bool has_colors = !lua_isnoneornil(L, narg + 1);
+  sbuffer* colors_buffer = NULL;
+  if (has_colors) {
+    colors_buffer = l_testudata(L, narg + 1, SMGF_TYPE_BUFFER);
+    if (colors_buffer == NULL) {
+      luaL_checktype(L, narg + 1, LUA_TTABLE);
     }
+    lua_Integer colors_len = colors_buffer != NULL
+                                 ? (lua_Integer) colors_buffer->length
+                                 : luaL_len(L, narg + 1);
+    luaL_argcheck(
+        L, colors_len == (lua_Integer) n * 4, narg + 1,
+        "must have 4 components (RGBA) per primitive");
+  }
 
-    SDL_FPoint pos = {0};
-    SDL_Color color = {0};
-    SDL_FPoint tex_coords = {0};
+  // positions are translated in place by the draw functions, so a buffer is
+  // only used directly when there is no translation
+  int tx = 0, ty = 0;
+  sf_gr_get_translation(c, &tx, &ty);
+  bool copy_values = values_buffer == NULL ||
+                     values_buffer->type != SBUFFER_F32 || tx != 0 || ty != 0;
+  bool copy_colors = has_colors && (colors_buffer == NULL ||
+                                    colors_buffer->type != SBUFFER_U8);
+  size_t size = (copy_values ? sizeof(float) * len : 0) +
+                (copy_colors ? sizeof(SDL_Color) * n : 0);
+  float* buffer = sf_gr_scratch_reserve(&c->draw_buffer, size > 0 ? size : 1);
+  if (buffer == NULL) {
+    return luaL_error(L, "%s", SDL_GetError());
+  }
 
-    if (lua_getfield(L, -1, "position") == LUA_TTABLE) {
-      if (luaL_len(L, -1) != 2) {
-        return luaL_argerror(
-            L, 2,
-            "invalid vertice's \"position\": must contain 2 components (XY)");
+  if (!copy_values) {
+    *values = values_buffer->data;
+  } else {
+    for (int i = 0; i < len; i++) {
+      if (values_buffer != NULL) {
+        buffer[i] = sf_bf_get(values_buffer, i);
+        continue;
       }
-
-      lua_geti(L, -1, 1);
-      pos.x = luaL_optnumber(L, -1, 0);
+      lua_rawgeti(L, narg, i + 1);
+      int isnum = 0;
+      buffer[i] = lua_tonumberx(L, -1, &isnum);
       lua_pop(L, 1);
-      lua_geti(L, -1, 2);
-      pos.y = luaL_optnumber(L, -1, 0);
-      lua_pop(L, 1);
-    } else {
-      return luaL_argerror(
-          L, 2, "invalid vertice's \"position\": must be a table");
+      if (!isnum) {
+        return luaL_argerror(L, narg, "must only contain numbers");
+      }
     }
-    lua_pop(L, 1);
+    *values = buffer;
+  }
 
-    int color_type = lua_getfield(L, -1, "color");
-    if (color_type == LUA_TTABLE) {
-      int len = luaL_len(L, -1);
-      if (len < 3 || len > 4) {
-        return luaL_argerror(
-            L, 2,
-            "invalid vertice's \"color\": must contain 3 or 4 components "
-            "(RGBA)");
+  *colors = NULL;
+  if (has_colors && !copy_colors) {
+    *colors = colors_buffer->data;
+  } else if (has_colors) {
+    Uint8* components = (Uint8*) (copy_values ? buffer + len : buffer);
+    for (int i = 0; i < n * 4; i++) {
+      lua_Integer v = 0;
+      int isnum = 1;
+      if (colors_buffer != NULL) {
+        double d = sf_bf_get(colors_buffer, i);
+        v = d >= 0 && d <= 255 ? (lua_Integer) d : -1;
+      } else {
+        lua_rawgeti(L, narg + 1, i + 1);
+        v = lua_tointegerx(L, -1, &isnum);
+        lua_pop(L, 1);
       }
-
-      lua_geti(L, -1, 1);
-      color.r = luaL_optnumber(L, -1, 0);
-      lua_pop(L, 1);
-      lua_geti(L, -1, 2);
-      color.g = luaL_optnumber(L, -1, 0);
-      lua_pop(L, 1);
-      lua_geti(L, -1, 3);
-      color.b = luaL_optnumber(L, -1, 0);
-      lua_pop(L, 1);
-      lua_geti(L, -1, 4);
-      color.a = luaL_optnumber(L, -1, 255);
-      lua_pop(L, 1);
-    } else if (color_type == LUA_TNIL) {
-      // if color not specified by user, we take the current color
-      if (get_color(c, &color) != 0) {
-        return luaL_error(L, "cannot get color (%s)", SDL_GetError());
+      if (!isnum || v < 0 || v > 255) {
+        return luaL_argerror(
+            L, narg + 1, "RGBA values must be between 0 and 255");
       }
-    } else {
-      return luaL_argerror(
-          L, 2, "invalid vertice's \"color\": must be a table");
+      components[i] = v;
     }
-    lua_pop(L, 1);
+    *colors = (SDL_Color*) components;
+  }
 
-    int tex_coords_type = lua_getfield(L, -1, "tex_coord");
-    if (tex_coords_type == LUA_TTABLE) {
-      int len = luaL_len(L, -1);
-      if (len != 2) {
-        return luaL_argerror(
-            L, 2,
-            "invalid vertice's \"tex_coord\": must contain 2 components (XY)");
-      }
+  return n;
+}
 
-      lua_geti(L, -1, 1);
-      tex_coords.x = luaL_optnumber(L, -1, 0);
-      lua_pop(L, 1);
-      lua_geti(L, -1, 2);
-      tex_coords.y = luaL_optnumber(L, -1, 0);
-      lua_pop(L, 1);
-    } else if (tex_coords_type != LUA_TNIL) {
-      return luaL_argerror(
-          L, 2, "invalid vertice's \"tex_coord\": must be a table");
-    }
-    lua_pop(L, 1);
+static int l_draw_points(lua_State* L) {
+  smgf* const c = get_smgf(L);
 
-    SDL_Vertex* v = &vertices[i++];
-    v->position = pos;
-    v->color = color;
-    v->tex_coord = tex_coords;
+  float* values = NULL;
+  SDL_Color* colors = NULL;
+  int n = lua_get_primitives(L, 1, 2, &values, &colors);
 
-    lua_pop(L, 1);
+  if (!sf_gr_draw_points(c, (SDL_FPoint*) values, colors, n)) {
+    return luaL_error(L, "cannot draw points (%s)", SDL_GetError());
   }
 
-  // indices
-  int nb_indices = 0;
-  int* indices = NULL;
+  return 0;
+}
 
-  if (lua_istable(L, 3)) {
-    nb_indices = luaL_len(L, 3);
-    if (nb_indices % 3 != 0 || nb_indices <= 0) {
-      return luaL_argerror(
-          L, 2,
-          "invalid indices table: length must be divisible by 3 (and "
-          "non-zero)");
-    }
+static int l_draw_lines(lua_State* L) {
+  smgf* const c = get_smgf(L);
 
-    // @TODO: test code, move memory allocation outside of this function
-    indices = SDL_malloc(sizeof(int) * nb_indices);
-    if (indices == NULL) {
-      return luaL_argerror(L, 3, "memory error");
-    }
+  float* values = NULL;
+  SDL_Color* colors = NULL;
+  int n = lua_get_primitives(L, 1, 2, &values, &colors);
 
-    // iter over all vertices
-    int i = 0;
-    lua_pushnil(L);
-    while (lua_next(L, 3) != 0) {
-      if (!lua_isinteger(L, -1)) {
-        return luaL_argerror(L, 3, "indices table must to contain integers");
-      }
+  if (!sf_gr_draw_lines(c, (SDL_FPoint*) values, colors, n)) {
+    return luaL_error(L, "cannot draw lines (%s)", SDL_GetError());
+  }
 
-      indices[i++] = (int) lua_tointeger(L, -1);
+  return 0;
+}
 
-      lua_pop(L, 1);
-    }
-  }
+static int l_draw_rects(lua_State* L) {
+  smgf* const c = get_smgf(L);
 
-  if (draw_geometry(c, t, vertices, nb_vertices, indices, nb_indices)) {
-    return luaL_error(L, "cannot draw geometry (%s)", SDL_GetError());
-  }
+  float* values = NULL;
+  SDL_Color* colors = NULL;
+  int n = lua_get_primitives(L, 1, 4, &values, &colors);
 
-  if (vertices != NULL) {
-    SDL_free(vertices);
+  if (!sf_gr_draw_rects(c, (SDL_FRect*) values, colors, n)) {
+    return luaL_error(L, "cannot draw rects (%s)", SDL_GetError());
   }
-  if (indices != NULL) {
-    SDL_free(indices);
+
+  return 0;
+}
+
+static int l_draw_rectfills(lua_State* L) {
+  smgf* const c = get_smgf(L);
+
+  float* values = NULL;
+  SDL_Color* colors = NULL;
+  int n = lua_get_primitives(L, 1, 4, &values, &colors);
+
+  if (!sf_gr_draw_rectfills(c, (SDL_FRect*) values, colors, n)) {
+    return luaL_error(L, "cannot draw rectfills (%s)", SDL_GetError());
   }
 
   return 0;
-} */
+}
 
 static int l_push_state(lua_State* L) {
   smgf* const c = get_smgf(L);
@@ -400,7 +397,7 @@ static int l_reset_state(lua_State* L) {
 
 static int l_texture_get_dimensions(lua_State* L) {
   smgf* const c = get_smgf(L);
-  stexture* t = (stexture*) luaL_checkudata(L, 1, SMGF_TYPE_TEXTURE);
+  stexture* t = (stexture*) l_checkudata(L, 1, SMGF_TYPE_TEXTURE);
 
   int w = 0, h = 0;
   if (sf_gr_texture_get_dimensions(t, &w, &h)) {
@@ -414,7 +411,7 @@ static int l_texture_get_dimensions(lua_State* L) {
 
 static int l_texture_get_width(lua_State* L) {
   smgf* const c = get_smgf(L);
-  stexture* t = (stexture*) luaL_checkudata(L, 1, SMGF_TYPE_TEXTURE);
+  stexture* t = (stexture*) l_checkudata(L, 1, SMGF_TYPE_TEXTURE);
 
   int w = 0, h = 0;
   if (sf_gr_texture_get_dimensions(t, &w, &h)) {
@@ -427,7 +424,7 @@ static int l_texture_get_width(lua_State* L) {
 
 static int l_texture_get_height(lua_State* L) {
   smgf* const c = get_smgf(L);
-  stexture* t = (stexture*) luaL_checkudata(L, 1, SMGF_TYPE_TEXTURE);
+  stexture* t = (stexture*) l_checkudata(L, 1, SMGF_TYPE_TEXTURE);
 
   int w = 0, h = 0;
   if (sf_gr_texture_get_dimensions(t, &w, &h)) {
@@ -440,7 +437,7 @@ static int l_texture_get_height(lua_State* L) {
 
 static int l_texture_set_blend_mode(lua_State* L) {
   smgf* const c = get_smgf(L);
-  stexture* t = (stexture*) luaL_checkudata(L, 1, SMGF_TYPE_TEXTURE);
+  stexture* t = (stexture*) l_checkudata(L, 1, SMGF_TYPE_TEXTURE);
 
   static const int blend[] = {
       SDL_BLENDMODE_NONE, SDL_BLENDMODE_BLEND, SDL_BLENDMODE_ADD,
@@ -449,7 +446,7 @@ static int l_texture_set_blend_mode(lua_State* L) {
                                             "mod",  "mul",   NULL};
   int op = luaL_checkoption(L, 2, "blend", blend_names);
 
-  if (!sf_gr_texture_set_blend_mode(t, blend[op])) {
+  if (!sf_gr_texture_set_blend_mode(c, t, blend[op])) {
     return luaL_error(L, "cannot set blend mode (%s)", SDL_GetError());
   }
 
@@ -458,7 +455,7 @@ static int l_texture_set_blend_mode(lua_State* L) {
 
 static int l_texture_get_blend_mode(lua_State* L) {
   smgf* const c = get_smgf(L);
-  stexture* t = (stexture*) luaL_checkudata(L, 1, SMGF_TYPE_TEXTURE);
+  stexture* t = (stexture*) l_checkudata(L, 1, SMGF_TYPE_TEXTURE);
   SDL_BlendMode b;
   if (!sf_gr_texture_get_blend_mode(t, &b)) {
     return luaL_error(L, "cannot get blend mode (%s)", SDL_GetError());
@@ -485,10 +482,13 @@ static int l_texture_new(lua_State* L) {
     const char* filename = luaL_checkstring(L, 1);
 
     stexture* t = (stexture*) lua_newuserdata(L, sizeof(stexture));
+    sf_sy_trace_begin(c, filename);
     if (sf_gr_texture_new(c, t, filename)) {
+      sf_sy_trace_end(c);
       return luaL_error(
           L, "unable to open file %s (%s)", filename, SDL_GetError());
     }
+    sf_sy_trace_end(c);
   } else {
     // creating an empty texture
     int w = luaL_checknumber(L, 1);
@@ -500,96 +500,571 @@ static int l_texture_new(lua_State* L) {
     }
   }
 
-  luaL_getmetatable(L, SMGF_TYPE_TEXTURE);
+  l_getmetatable(L, SMGF_TYPE_TEXTURE);
   lua_setmetatable(L, -2);
 
   return 1;
 }
 
 static int l_texture_del(lua_State* L) {
-  stexture* t = (stexture*) luaL_checkudata(L, 1, SMGF_TYPE_TEXTURE);
-  sf_gr_texture_del(t);
+  smgf* const c = get_smgf(L);
+  stexture* t = (stexture*) l_checkudata(L, 1, SMGF_TYPE_TEXTURE);
+  sf_gr_texture_del(c, t);
   return 0;
 }
 
-static int l_texture_draw(lua_State* L) {
-  smgf* const c = get_smgf(L);
-
-  stexture* t = (stexture*) luaL_checkudata(L, 1, SMGF_TYPE_TEXTURE);
-
-  int qx = 0;
-  int qy = 0;
-  int qw = 0;
-  int qh = 0;
-  float x = 0;
-  float y = 0;
-  float sx = 1;
-  float sy = sx;
-  double r = 0;
-  float ox = 0;
-  float oy = 0;
-  int flip = 0;
-
-  // if second argument is table, we only draw part of the texture
-  if (lua_istable(L, 2)) {
-    if (luaL_len(L, 2) != 4) {
+// parameters of a texture draw call, see lua_get_draw_params
+typedef struct draw_params {
+  int qx, qy, qw, qh; // quad (all zeroes = whole texture)
+  float x, y;
+  float sx, sy;
+  double r;
+  float ox, oy;
+  int flip;
+} draw_params;
+
+// reads the "[quad], x, y, sx, sy, r, ox, oy, flip" arguments of a texture
+// draw call, starting at index narg
+static int lua_get_draw_params(lua_State* L, int narg, draw_params* p) {
+  p->qx = 0;
+  p->qy = 0;
+  p->qw = 0;
+  p->qh = 0;
+
+  // if first argument is table, we only draw part of the texture
+  if (lua_istable(L, narg)) {
+    if (luaL_len(L, narg) != 4) {
       return luaL_argerror(
-          L, 2, "invalid quad (must have 4 components) (XYWH)");
+          L, narg, "invalid quad (must have 4 components) (XYWH)");
     }
-    lua_geti(L, 2, 1);
-    lua_geti(L, 2, 2);
-    lua_geti(L, 2, 3);
-    lua_geti(L, 2, 4);
-    qx = luaL_checknumber(L, -4);
-    qy = luaL_checknumber(L, -3);
-    qw = luaL_checknumber(L, -2);
-    qh = luaL_checknumber(L, -1);
+    lua_geti(L, narg, 1);
+    lua_geti(L, narg, 2);
+    lua_geti(L, narg, 3);
+    lua_geti(L, narg, 4);
+    p->qx = luaL_checknumber(L, -4);
+    p->qy = luaL_checknumber(L, -3);
+    p->qw = luaL_checknumber(L, -2);
+    p->qh = luaL_checknumber(L, -1);
     lua_pop(L, 4);
 
-    luaL_argcheck(L, qx >= 0, 2, "x component of quad must be positive");
-    luaL_argcheck(L, qy >= 0, 2, "y component of quad must be positive");
-    luaL_argcheck(L, qw >= 0, 2, "w component of quad must be positive");
-    luaL_argcheck(L, qh >= 0, 2, "h component of quad must be positive");
-
-    x = luaL_optnumber(L, 3, 0);
-    y = luaL_optnumber(L, 4, 0);
-    sx = luaL_optnumber(L, 5, 1);
-    sy = luaL_optnumber(L, 6, sx);
-    r = luaL_optnumber(L, 7, 0);
-    ox = luaL_optnumber(L, 8, 0);
-    oy = luaL_optnumber(L, 9, 0);
-    // flip = luaL_optnumber(L, 10, 0);
-    static const int flips[] = {
-        SDL_FLIP_NONE, SDL_FLIP_HORIZONTAL, SDL_FLIP_VERTICAL};
-    static const char* const flip_names[] = {
-        "none", "horizontal", "vertical", NULL};
-    int op = luaL_checkoption(L, 10, "none", flip_names);
-    flip = flips[op];
-  } else {
-    x = luaL_optnumber(L, 2, 0);
-    y = luaL_optnumber(L, 3, 0);
-    sx = luaL_optnumber(L, 4, 1);
-    sy = luaL_optnumber(L, 5, sx);
-    r = luaL_optnumber(L, 6, 0);
-    ox = luaL_optnumber(L, 7, 0);
-    oy = luaL_optnumber(L, 8, 0);
-    // flip = luaL_optnumber(L, 9, 0);
-    static const int flips[] = {
-        SDL_FLIP_NONE, SDL_FLIP_HORIZONTAL, SDL_FLIP_VERTICAL};
-    static const char* const flip_names[] = {
-        "none", "horizontal", "vertical", NULL};
-    int op = luaL_checkoption(L, 9, "none", flip_names);
-    flip = flips[op];
+    luaL_argcheck(L, p->qx >= 0, narg, "x component of quad must be positive");
+    luaL_argcheck(L, p->qy >= 0, narg, "y component of quad must be positive");
+    luaL_argcheck(L, p->qw >= 0, narg, "w component of quad must be positive");
+    luaL_argcheck(L, p->qh >= 0, narg, "h component of quad must be positive");
+
+    narg += 1;
   }
 
+  p->x = luaL_optnumber(L, narg + 0, 0);
+  p->y = luaL_optnumber(L, narg + 1, 0);
+  p->sx = luaL_optnumber(L, narg + 2, 1);
+  p->sy = luaL_optnumber(L, narg + 3, p->sx);
+  p->r = luaL_optnumber(L, narg + 4, 0);
+  p->ox = luaL_optnumber(L, narg + 5, 0);
+  p->oy = luaL_optnumber(L, narg + 6, 0);
+  static const int flips[] = {
+      SDL_FLIP_NONE, SDL_FLIP_HORIZONTAL, SDL_FLIP_VERTICAL};
+  static const char* const flip_names[] = {
+      "none", "horizontal", "vertical", NULL};
+  int op = luaL_checkoption(L, narg + 7, "none", flip_names);
+  p->flip = flips[op];
+
+  return 0;
+}
+
+static int l_texture_draw(lua_State* L) {
+  smgf* const c = get_smgf(L);
+
+  stexture* t = (stexture*) l_checkudata(L, 1, SMGF_TYPE_TEXTURE);
+
+  draw_params p;
+  lua_get_draw_params(L, 2, &p);
+
   if (!sf_gr_texture_draw(
-          c, t, x, y, qx, qy, qw, qh, sx, sy, r, ox, oy, flip)) {
+          c, t, p.x, p.y, p.qx, p.qy, p.qw, p.qh, p.sx, p.sy, p.r, p.ox, p.oy,
+          p.flip)) {
     return luaL_error(c->L, "cannot draw texture (%s)", SDL_GetError());
   }
 
   return 0;
 }
 
+static int l_batch_new(lua_State* L) {
+  stexture* t = (stexture*) l_checkudata(L, 1, SMGF_TYPE_TEXTURE);
+  int capacity = luaL_optnumber(L, 2, 128);
+  luaL_argcheck(L, capacity > 0, 2, "must be positive and non-zero");
+
+  sbatch* b = (sbatch*) lua_newuserdata(L, sizeof(sbatch));
+  if (sf_gr_batch_new(b, t, capacity)) {
+    return luaL_error(L, "unable to create batch (%s)", SDL_GetError());
+  }
+
+  l_getmetatable(L, SMGF_TYPE_BATCH);
+  lua_setmetatable(L, -2);
+
+  // the batch keeps its texture alive
+  lua_pushvalue(L, 1);
+  lua_setiuservalue(L, -2, 1);
+
+  return 1;
+}
+
+static int l_batch_del(lua_State* L) {
+  sbatch* b = (sbatch*) l_checkudata(L, 1, SMGF_TYPE_BATCH);
+  sf_gr_batch_del(b);
+  return 0;
+}
+
+static int l_batch_add(lua_State* L) {
+  smgf* const c = get_smgf(L);
+  sbatch* b = (sbatch*) l_checkudata(L, 1, SMGF_TYPE_BATCH);
+
+  draw_params p;
+  lua_get_draw_params(L, 2, &p);
+
+  int n = sf_gr_batch_add(
+      c, b, p.x, p.y, p.qx, p.qy, p.qw, p.qh, p.sx, p.sy, p.r, p.ox, p.oy,
+      p.flip);
+  if (n < 0) {
+    return luaL_error(L, "cannot add to batch (%s)", SDL_GetError());
+  }
+
+  lua_pushinteger(L, n);
+  return 1;
+}
+
+static int l_batch_clear(lua_State* L) {
+  sbatch* b = (sbatch*) l_checkudata(L, 1, SMGF_TYPE_BATCH);
+  sf_gr_batch_clear(b);
+  return 0;
+}
+
+static int l_batch_draw(lua_State* L) {
+  smgf* const c = get_smgf(L);
+  sbatch* b = (sbatch*) l_checkudata(L, 1, SMGF_TYPE_BATCH);
+
+  if (!sf_gr_batch_draw(c, b)) {
+    return luaL_error(L, "cannot draw batch (%s)", SDL_GetError());
+  }
+
+  return 0;
+}
+
+static int l_batch_get_count(lua_State* L) {
+  sbatch* b = (sbatch*) l_checkudata(L, 1, SMGF_TYPE_BATCH);
+  lua_pushinteger(L, b->nb_sprites);
+  return 1;
+}
+
+static int l_batch_get_capacity(lua_State* L) {
+  sbatch* b = (sbatch*) l_checkudata(L, 1, SMGF_TYPE_BATCH);
+  lua_pushinteger(L, b->capacity);
+  return 1;
+}
+
+// reads a vertex ("x, y, u, v, r, g, b, a") starting at index narg. If no
+// color is given, the current color is used.
+static int lua_get_vertex(lua_State* L, int narg, SDL_Vertex* v) {
+  smgf* const c = get_smgf(L);
+
+  v->position.x = luaL_checknumber(L, narg + 0);
+  v->position.y = luaL_checknumber(L, narg + 1);
+  v->tex_coord.x = luaL_optnumber(L, narg + 2, 0);
+  v->tex_coord.y = luaL_optnumber(L, narg + 3, 0);
+
+  SDL_Color color = {0};
+  if (lua_isnoneornil(L, narg + 4)) {
+    sf_gr_get_color(c, &color);
+  } else {
+    lua_get_color(L, narg + 4, &color);
+  }
+  v->color.r = color.r / 255.f;
+  v->color.g = color.g / 255.f;
+  v->color.b = color.b / 255.f;
+  v->color.a = color.a / 255.f;
+
+  return 0;
+}
+
+static int l_mesh_new(lua_State* L) {
+  int nb_vertices = luaL_checknumber(L, 1);
+  luaL_argcheck(L, nb_vertices > 0, 1, "must be positive and non-zero");
+  int nb_indices = luaL_optnumber(L, 2, 0);
+  luaL_argcheck(L, nb_indices >= 0, 2, "must be positive");
+
+  smesh* m = (smesh*) lua_newuserdata(L, sizeof(smesh));
+  if (sf_gr_mesh_new(m, nb_vertices, nb_indices)) {
+    return luaL_error(L, "unable to create mesh (%s)", SDL_GetError());
+  }
+
+  l_getmetatable(L, SMGF_TYPE_MESH);
+  lua_setmetatable(L, -2);
+
+  return 1;
+}
+
+static int l_mesh_del(lua_State* L) {
+  smesh* m = (smesh*) l_checkudata(L, 1, SMGF_TYPE_MESH);
+  sf_gr_mesh_del(m);
+  return 0;
+}
+
+static int l_mesh_set_vertex(lua_State* L) {
+  smesh* m = (smesh*) l_checkudata(L, 1, SMGF_TYPE_MESH);
+  int i = luaL_checkinteger(L, 2);
+  luaL_argcheck(L, i >= 1 && i <= m->nb_vertices, 2, "vertex out of range");
+
+  SDL_Vertex v;
+  lua_get_vertex(L, 3, &v);
+  sf_gr_mesh_set_vertex(m, i - 1, &v);
+
+  return 0;
+}
+
+static int l_mesh_get_vertex(lua_State* L) {
+  smesh* m = (smesh*) l_checkudata(L, 1, SMGF_TYPE_MESH);
+  int i = luaL_checkinteger(L, 2);
+  luaL_argcheck(L, i >= 1 && i <= m->nb_vertices, 2, "vertex out of range");
+
+  SDL_Vertex* v = &m->vertices[i - 1];
+  lua_pushnumber(L, v->position.x);
+  lua_pushnumber(L, v->position.y);
+  lua_pushnumber(L, v->tex_coord.x);
+  lua_pushnumber(L, v->tex_coord.y);
+  lua_pushinteger(L, (int) (v->color.r * 255.f + 0.5f));
+  lua_pushinteger(L, (int) (v->color.g * 255.f + 0.5f));
+  lua_pushinteger(L, (int) (v->color.b * 255.f + 0.5f));
+  lua_pushinteger(L, (int) (v->color.a * 255.f + 0.5f));
+  return 8;
+}
+
+// updates a range of vertices from a buffer of 8 numbers per vertex
+// (x, y, u, v, r, g, b, a), starting at vertex "start"
+static int lua_mesh_set_vertices_buffer(lua_State* L, smesh* m, sbuffer* b) {
+  lua_Integer start = luaL_optinteger(L, 3, 1);
+  luaL_argcheck(
+      L, b->length % 8 == 0, 2,
+      "must have 8 components per vertex (XYUVRGBA)");
+  lua_Integer n = (lua_Integer) (b->length / 8);
+  luaL_argcheck(
+      L, start >= 1 && start + n - 1 <= m->nb_vertices, 3,
+      "vertices out of range");
+
+  for (lua_Integer i = 0; i < n; i++) {
+    size_t j = i * 8;
+    SDL_Vertex v;
+    v.position.x = sf_bf_get(b, j + 0);
+    v.position.y = sf_bf_get(b, j + 1);
+    v.tex_coord.x = sf_bf_get(b, j + 2);
+    v.tex_coord.y = sf_bf_get(b, j + 3);
+    v.color.r = sf_bf_get(b, j + 4) / 255.f;
+    v.color.g = sf_bf_get(b, j + 5) / 255.f;
+    v.color.b = sf_bf_get(b, j + 6) / 255.f;
+    v.color.a = sf_bf_get(b, j + 7) / 255.f;
+    sf_gr_mesh_set_vertex(m, start - 1 + i, &v);
+  }
+
+  return 0;
+}
+
+// updates a range of vertices from a table of vertices
+// ({{x, y, u, v, r, g, b, a}, ...}) or a buffer, starting at vertex "start"
+static int l_mesh_set_vertices(lua_State* L) {
+  smesh* m = (smesh*) l_checkudata(L, 1, SMGF_TYPE_MESH);
+  sbuffer* b = l_testudata(L, 2, SMGF_TYPE_BUFFER);
+  if (b != NULL) {
+    return lua_mesh_set_vertices_buffer(L, m, b);
+  }
+  luaL_checktype(L, 2, LUA_TTABLE);
+  int start = luaL_optinteger(L, 3, 1);
+  int n = luaL_len(L, 2);
+  luaL_argcheck(
+      L, start >= 1 && start + n - 1 <= m->nb_vertices, 3,
+      "vertices out of range");
+
+  for (int i = 0; i < n; i++) {
+    if (lua_geti(L, 2, i + 1) != LUA_TTABLE) {
+      return luaL_argerror(L, 2, "each vertex must be a table");
+    }
+    int len = luaL_len(L, -1);
+    if (len < 2 || len > 8) {
+      return luaL_argerror(
+          L, 2, "invalid vertex (must have 2 to 8 components) (XYUVRGBA)");
+    }
+    int top = lua_gettop(L);
+    for (int j = 1; j <= 8; j++) {
+      lua_geti(L, top, j);
+    }
+
+    SDL_Vertex v;
+    lua_get_vertex(L, top + 1, &v);
+    sf_gr_mesh_set_vertex(m, start - 1 + i, &v);
+    lua_pop(L, 9);
+  }
+
+  return 0;
+}
+
+// updates a range of indices from a table or a buffer of (1-based) vertex
+// numbers, starting at index "start"
+static int l_mesh_set_indices(lua_State* L) {
+  smesh* m = (smesh*) l_checkudata(L, 1, SMGF_TYPE_MESH);
+  sbuffer* b = l_testudata(L, 2, SMGF_TYPE_BUFFER);
+  if (b == NULL) {
+    luaL_checktype(L, 2, LUA_TTABLE);
+  }
+  int start = luaL_optinteger(L, 3, 1);
+  lua_Integer n = b != NULL ? (lua_Integer) b->length : luaL_len(L, 2);
+  luaL_argcheck(
+      L, start >= 1 && n <= m->nb_indices - start + 1, 3,
+      "indices out of range");
+
+  for (int i = 0; i < n; i++) {
+    int isnum = 1;
+    lua_Integer index = 0;
+    if (b != NULL) {
+      index = (lua_Integer) sf_bf_get(b, i);
+    } else {
+      lua_geti(L, 2, i + 1);
+      index = lua_tointegerx(L, -1, &isnum);
+      lua_pop(L, 1);
+    }
+    if (!isnum || index < 1 || index > m->nb_vertices) {
+      return luaL_argerror(
+          L, 2, "indices must be integers between 1 and the vertex count");
+    }
+    sf_gr_mesh_set_index(m, start - 1 + i, index - 1);
+  }
+
+  return 0;
+}
+
+static int l_mesh_set_texture(lua_State* L) {
+  smesh* m = (smesh*) l_checkudata(L, 1, SMGF_TYPE_MESH);
+  stexture* t = (stexture*) l_testudata(L, 2, SMGF_TYPE_TEXTURE);
+  if (t == NULL && !lua_isnoneornil(L, 2)) {
+    return luaL_typeerror(L, 2, smgf_type_names[SMGF_TYPE_TEXTURE]);
+  }
+
+  // the mesh keeps its texture alive
+  m->texture = t;
+  lua_settop(L, 2);
+  lua_setiuservalue(L, 1, 1);
+
+  return 0;
+}
+
+static int l_mesh_get_texture(lua_State* L) {
+  l_checkudata(L, 1, SMGF_TYPE_MESH);
+  lua_getiuservalue(L, 1, 1);
+  return 1;
+}
+
+static int l_mesh_get_vertex_count(lua_State* L) {
+  smesh* m = (smesh*) l_checkudata(L, 1, SMGF_TYPE_MESH);
+  lua_pushinteger(L, m->nb_vertices);
+  return 1;
+}
+
+static int l_mesh_get_index_count(lua_State* L) {
+  smesh* m = (smesh*) l_checkudata(L, 1, SMGF_TYPE_MESH);
+  lua_pushinteger(L, m->nb_indices);
+  return 1;
+}
+
+static int l_mesh_draw(lua_State* L) {
+  smgf* const c = get_smgf(L);
+  smesh* m = (smesh*) l_checkudata(L, 1, SMGF_TYPE_MESH);
+  float x = luaL_optnumber(L, 2, 0);
+  float y = luaL_optnumber(L, 3, 0);
+
+  if (!sf_gr_mesh_draw(c, m, x, y)) {
+    return luaL_error(L, "cannot draw mesh (%s)", SDL_GetError());
+  }
+
+  return 0;
+}
+
+static int l_tilemap_new(lua_State* L) {
+  stexture* t = (stexture*) l_checkudata(L, 1, SMGF_TYPE_TEXTURE);
+  int tile_w = luaL_checknumber(L, 2);
+  luaL_argcheck(
+      L, tile_w > 0 && tile_w <= t->width, 2,
+      "must be positive and not larger than the tileset");
+  int tile_h = luaL_checknumber(L, 3);
+  luaL_argcheck(
+      L, tile_h > 0 && tile_h <= t->height, 3,
+      "must be positive and not larger than the tileset");
+  int map_w = luaL_checknumber(L, 4);
+  luaL_argcheck(L, map_w > 0, 4, "must be positive and non-zero");
+  int map_h = luaL_checknumber(L, 5);
+  luaL_argcheck(L, map_h > 0, 5, "must be positive and non-zero");
+
+  stilemap* m = (stilemap*) lua_newuserdata(L, sizeof(stilemap));
+  if (sf_gr_tilemap_new(m, t, tile_w, tile_h, map_w, map_h)) {
+    return luaL_error(L, "unable to create tilemap (%s)", SDL_GetError());
+  }
+
+  l_getmetatable(L, SMGF_TYPE_TILEMAP);
+  lua_setmetatable(L, -2);
+
+  // the tilemap keeps its tileset alive
+  lua_pushvalue(L, 1);
+  lua_setiuservalue(L, -2, 1);
+
+  return 1;
+}
+
+static int l_tilemap_del(lua_State* L) {
+  smgf* const c = get_smgf(L);
+  stilemap* m = (stilemap*) l_checkudata(L, 1, SMGF_TYPE_TILEMAP);
+  sf_gr_tilemap_del(c, m);
+  return 0;
+}
+
+static inline bool tilemap_is_valid_tile(stilemap* m, lua_Integer tile) {
+  int nb_tiles = m->nb_columns * (m->tileset->height / m->tile_h);
+  return tile >= 0 && tile <= nb_tiles;
+}
+
+static int l_tilemap_set_tile(lua_State* L) {
+  stilemap* m = (stilemap*) l_checkudata(L, 1, SMGF_TYPE_TILEMAP);
+  int x = luaL_checkinteger(L, 2);
+  luaL_argcheck(L, x >= 1 && x <= m->map_w, 2, "position out of tilemap");
+  int y = luaL_checkinteger(L, 3);
+  luaL_argcheck(L, y >= 1 && y <= m->map_h, 3, "position out of tilemap");
+  lua_Integer tile = luaL_optinteger(L, 4, 0);
+  luaL_argcheck(L, tilemap_is_valid_tile(m, tile), 4, "tile not in tileset");
+
+  sf_gr_tilemap_set_tile(m, x - 1, y - 1, tile);
+  return 0;
+}
+
+static int l_tilemap_get_tile(lua_State* L) {
+  stilemap* m = (stilemap*) l_checkudata(L, 1, SMGF_TYPE_TILEMAP);
+  int x = luaL_checkinteger(L, 2);
+  luaL_argcheck(L, x >= 1 && x <= m->map_w, 2, "position out of tilemap");
+  int y = luaL_checkinteger(L, 3);
+  luaL_argcheck(L, y >= 1 && y <= m->map_h, 3, "position out of tilemap");
+
+  lua_pushinteger(L, sf_gr_tilemap_get_tile(m, x - 1, y - 1));
+  return 1;
+}
+
+// sets a rectangle of tiles from a flat table or buffer of tile numbers (row
+// by row), starting at (x, y). "width" defaults to the width of the tilemap.
+static int l_tilemap_set_tiles(lua_State* L) {
+  stilemap* m = (stilemap*) l_checkudata(L, 1, SMGF_TYPE_TILEMAP);
+  sbuffer* b = l_testudata(L, 2, SMGF_TYPE_BUFFER);
+  if (b == NULL) {
+    luaL_checktype(L, 2, LUA_TTABLE);
+  }
+  int x0 = luaL_optinteger(L, 3, 1);
+  luaL_argcheck(L, x0 >= 1 && x0 <= m->map_w, 3, "position out of tilemap");
+  int y0 = luaL_optinteger(L, 4, 1);
+  luaL_argcheck(L, y0 >= 1 && y0 <= m->map_h, 4, "position out of tilemap");
+  int width = luaL_optinteger(L, 5, m->map_w - x0 + 1);
+  luaL_argcheck(
+      L, width >= 1 && x0 + width - 1 <= m->map_w, 5, "width out of tilemap");
+
+  lua_Integer n = b != NULL ? (lua_Integer) b->length : luaL_len(L, 2);
+  luaL_argcheck(
+      L, (n + width - 1) / width <= m->map_h - y0 + 1, 2,
+      "tiles out of tilemap");
+
+  for (int i = 0; i < n; i++) {
+    int isnum = 1;
+    lua_Integer tile = 0;
+    if (b != NULL) {
+      tile = (lua_Integer) sf_bf_get(b, i);
+    } else {
+      lua_rawgeti(L, 2, i + 1);
+      tile = lua_tointegerx(L, -1, &isnum);
+      lua_pop(L, 1);
+    }
+    if (!isnum || !tilemap_is_valid_tile(m, tile)) {
+      return luaL_argerror(L, 2, "tile not in tileset");
+    }
+    sf_gr_tilemap_set_tile(m, x0 - 1 + i % width, y0 - 1 + i / width, tile);
+  }
+
+  return 0;
+}
+
+static int l_tilemap_get_dimensions(lua_State* L) {
+  stilemap* m = (stilemap*) l_checkudata(L, 1, SMGF_TYPE_TILEMAP);
+  lua_pushinteger(L, m->map_w);
+  lua_pushinteger(L, m->map_h);
+  return 2;
+}
+
+static int l_tilemap_get_tile_size(lua_State* L) {
+  stilemap* m = (stilemap*) l_checkudata(L, 1, SMGF_TYPE_TILEMAP);
+  lua_pushinteger(L, m->tile_w);
+  lua_pushinteger(L, m->tile_h);
+  return 2;
+}
+
+static int l_tilemap_draw(lua_State* L) {
+  smgf* const c = get_smgf(L);
+  stilemap* m = (stilemap*) l_checkudata(L, 1, SMGF_TYPE_TILEMAP);
+  float x = luaL_optnumber(L, 2, 0);
+  float y = luaL_optnumber(L, 3, 0);
+
+  if (!sf_gr_tilemap_draw(c, m, x, y)) {
+    return luaL_error(L, "cannot draw tilemap (%s)", SDL_GetError());
+  }
+
+  return 0;
+}
+
+static int l_text_new(lua_State* L) {
+  const char* str = luaL_checkstring(L, 1);
+
+  stext* t = (stext*) lua_newuserdata(L, sizeof(stext));
+  if (sf_gr_text_new(t, str)) {
+    return luaL_error(L, "unable to create text (%s)", SDL_GetError());
+  }
+
+  l_getmetatable(L, SMGF_TYPE_TEXT);
+  lua_setmetatable(L, -2);
+
+  return 1;
+}
+
+static int l_text_del(lua_State* L) {
+  smgf* const c = get_smgf(L);
+  stext* t = (stext*) l_checkudata(L, 1, SMGF_TYPE_TEXT);
+  sf_gr_text_del(c, t);
+  return 0;
+}
+
+static int l_text_get_dimensions(lua_State* L) {
+  stext* t = (stext*) l_checkudata(L, 1, SMGF_TYPE_TEXT);
+  lua_pushinteger(L, t->width);
+  lua_pushinteger(L, t->height);
+  return 2;
+}
+
+static int l_text_get_text(lua_State* L) {
+  stext* t = (stext*) l_checkudata(L, 1, SMGF_TYPE_TEXT);
+  lua_pushstring(L, t->str);
+  return 1;
+}
+
+static int l_text_draw(lua_State* L) {
+  smgf* const c = get_smgf(L);
+  stext* t = (stext*) l_checkudata(L, 1, SMGF_TYPE_TEXT);
+  float x = luaL_optnumber(L, 2, 0);
+  float y = luaL_optnumber(L, 3, 0);
+
+  if (!sf_gr_text_draw(c, t, x, y)) {
+    return luaL_error(L, "cannot draw text (%s)", SDL_GetError());
+  }
+
+  return 0;
+}
+
 static int l_set_target(lua_State* L) {
   smgf* const c = get_smgf(L);
 
@@ -599,7 +1074,7 @@ static int l_set_target(lua_State* L) {
     c->curstate->target_luaref = 0;
   }
 
-  stexture* t = (stexture*) luaL_testudata(L, 1, SMGF_TYPE_TEXTURE);
+  stexture* t = (stexture*) l_testudata(L, 1, SMGF_TYPE_TEXTURE);
 
   if (sf_gr_set_target(c, t)) {
     if (t != NULL) {
@@ -629,7 +1104,7 @@ static int l_get_target(lua_State* L) {
 static int l_texture_save(lua_State* L) {
   smgf* const c = get_smgf(L);
 
-  stexture* t = (stexture*) luaL_checkudata(L, 1, SMGF_TYPE_TEXTURE);
+  stexture* t = (stexture*) l_checkudata(L, 1, SMGF_TYPE_TEXTURE);
   const char* filename = luaL_checkstring(L, 2);
 
   if (sf_gr_texture_save(c, t, filename)) {
@@ -747,6 +1222,17 @@ static int l_print(lua_State* L) {
   return 0;
 }
 
+static int l_get_state_changes(lua_State* L) {
+  smgf* const c = get_smgf(L);
+
+  Uint64 issued = 0, skipped = 0;
+  sf_gr_get_state_changes(c, &issued, &skipped);
+
+  lua_pushinteger(L, issued);
+  lua_pushinteger(L, skipped);
+  return 2;
+}
+
 static int l_screenshot(lua_State* L) {
   smgf* const c = get_smgf(L);
 
@@ -775,13 +1261,17 @@ static const struct luaL_Reg smgf_graphics[] = {
     {"get_translation", l_get_translation},
     // {"clip", l_clip},
     {"screenshot", l_screenshot},
+    {"get_state_changes", l_get_state_changes},
 
     {"get_point", l_get_point}, // for now, only used for test cases.
     {"draw_point", l_draw_point},
     {"draw_line", l_draw_line},
     {"draw_rect", l_draw_rect},
     {"draw_rectfill", l_draw_rectfill},
-    // {"draw_geometry", l_draw_geometry},
+    {"draw_points", l_draw_points},
+    {"draw_lines", l_draw_lines},
+    {"draw_rects", l_draw_rects},
+    {"draw_rectfills", l_draw_rectfills},
     {"print_color", l_print_color},
     {"print", l_print},
 
@@ -791,6 +1281,18 @@ static const struct luaL_Reg smgf_graphics[] = {
     // {"texture_draw", l_texture_draw},
     {"draw", l_texture_draw},
 
+    // batch
+    {"new_batch", l_batch_new},
+
+    // mesh
+    {"new_mesh", l_mesh_new},
+
+    // tilemap
+    {"new_tilemap", l_tilemap_new},
+
+    // text
+    {"new_text", l_text_new},
+
     {NULL, NULL}};
 
 static const struct luaL_Reg texture_func[] = {
@@ -803,6 +1305,41 @@ static const struct luaL_Reg texture_func[] = {
     {"draw", l_texture_draw},
     {NULL, NULL}};
 
+static const struct luaL_Reg batch_func[] = {
+    {"add", l_batch_add},
+    {"clear", l_batch_clear},
+    {"draw", l_batch_draw},
+    {"get_count", l_batch_get_count},
+    {"get_capacity", l_batch_get_capacity},
+    {NULL, NULL}};
+
+static const struct luaL_Reg mesh_func[] = {
+    {"set_vertex", l_mesh_set_vertex},
+    {"get_vertex", l_mesh_get_vertex},
+    {"set_vertices", l_mesh_set_vertices},
+    {"set_indices", l_mesh_set_indices},
+    {"set_texture", l_mesh_set_texture},
+    {"get_texture", l_mesh_get_texture},
+    {"get_vertex_count", l_mesh_get_vertex_count},
+    {"get_index_count", l_mesh_get_index_count},
+    {"draw", l_mesh_draw},
+    {NULL, NULL}};
+
+static const struct luaL_Reg tilemap_func[] = {
+    {"set_tile", l_tilemap_set_tile},
+    {"get_tile", l_tilemap_get_tile},
+    {"set_tiles", l_tilemap_set_tiles},
+    {"get_dimensions", l_tilemap_get_dimensions},
+    {"get_tile_size", l_tilemap_get_tile_size},
+    {"draw", l_tilemap_draw},
+    {NULL, NULL}};
+
+static const struct luaL_Reg text_func[] = {
+    {"get_dimensions", l_text_get_dimensions},
+    {"get_text", l_text_get_text},
+    {"draw", l_text_draw},
+    {NULL, NULL}};
+
 void init_graphics(lua_State* L) {
   // @NOTE: we specify the number of functions of each module, so that
   // Lua can preallocate memory (see lua_createtable docs)
@@ -812,11 +1349,47 @@ void init_graphics(lua_State* L) {
   lua_setfield(L, -2, "graphics");
 
   // add texture type
-  luaL_newmetatable(L, SMGF_TYPE_TEXTURE);
+  l_newmetatable(L, SMGF_TYPE_TEXTURE);
   lua_pushcfunction(L, l_texture_del);
   lua_setfield(L, -2, "__gc");
   lua_pushvalue(L, -1);
   lua_setfield(L, -2, "__index");
   luaL_setfuncs(L, texture_func, 0);
   lua_pop(L, 1);
+
+  // add batch type
+  l_newmetatable(L, SMGF_TYPE_BATCH);
+  lua_pushcfunction(L, l_batch_del);
+  lua_setfield(L, -2, "__gc");
+  lua_pushvalue(L, -1);
+  lua_setfield(L, -2, "__index");
+  luaL_setfuncs(L, batch_func, 0);
+  lua_pop(L, 1);
+
+  // add mesh type
+  l_newmetatable(L, SMGF_TYPE_MESH);
+  lua_pushcfunction(L, l_mesh_del);
+  lua_setfield(L, -2, "__gc");
+  lua_pushvalue(L, -1);
+  lua_setfield(L, -2, "__index");
+  luaL_setfuncs(L, mesh_func, 0);
+  lua_pop(L, 1);
+
+  // add tilemap type
+  l_newmetatable(L, SMGF_TYPE_TILEMAP);
+  lua_pushcfunction(L, l_tilemap_del);
+  lua_setfield(L, -2, "__gc");
+  lua_pushvalue(L, -1);
+  lua_setfield(L, -2, "__index");
+  luaL_setfuncs(L, tilemap_func, 0);
+  lua_pop(L, 1);
+
+  // add text type
+  l_newmetatable(L, SMGF_TYPE_TEXT);
+  lua_pushcfunction(L, l_text_del);
+  lua_setfield(L, -2, "__gc");
+  lua_pushvalue(L, -1);
+  lua_setfield(L, -2, "__index");
+  luaL_setfuncs(L, text_func, 0);
+  lua_pop(L, 1);
 }
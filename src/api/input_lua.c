@@ -183,12 +183,32 @@ static const struct luaL_Reg smgf_gamepad[] = {
     {"get_axis", l_gamepad_get_axis}, {"rumble", l_gamepad_rumble},
     {"get_name", l_gamepad_get_name}, {NULL, NULL}};
 
+// bits of the key modifiers of smgf.events
+static const struct {
+  const char* name;
+  SDL_Keymod mod;
+} keyboard_mods[] = {
+    {"lshift", SDL_KMOD_LSHIFT}, {"rshift", SDL_KMOD_RSHIFT},
+    {"lctrl", SDL_KMOD_LCTRL},   {"rctrl", SDL_KMOD_RCTRL},
+    {"lalt", SDL_KMOD_LALT},     {"ralt", SDL_KMOD_RALT},
+    {"lgui", SDL_KMOD_LGUI},     {"rgui", SDL_KMOD_RGUI},
+    {"num", SDL_KMOD_NUM},       {"caps", SDL_KMOD_CAPS},
+    {"mode", SDL_KMOD_MODE},     {"shift", SDL_KMOD_SHIFT},
+    {"ctrl", SDL_KMOD_CTRL},     {"alt", SDL_KMOD_ALT},
+    {"gui", SDL_KMOD_GUI}};
+
 void init_input(lua_State* L) {
   size_t n = 0;
 
   n = SDL_arraysize(smgf_keyboard);
-  lua_createtable(L, 0, n);
+  lua_createtable(L, 0, n + 1);
   luaL_setfuncs(L, smgf_keyboard, 0);
+  lua_createtable(L, 0, SDL_arraysize(keyboard_mods));
+  for (size_t i = 0; i < SDL_arraysize(keyboard_mods); i++) {
+    lua_pushinteger(L, keyboard_mods[i].mod);
+    lua_setfield(L, -2, keyboard_mods[i].name);
+  }
+  lua_setfield(L, -2, "mods");
   lua_setfield(L, -2, "keyboard");
 
   n = SDL_arraysize(smgf_mouse);
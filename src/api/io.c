@@ -4,11 +4,19 @@ int sf_io_new(sfile* const f) {
   f->file = NULL;
   SDL_memset(&f->stat, 0, sizeof(f->stat));
   f->mode = 0;
+  f->block = NULL;
+  f->block_pos = 0;
+  f->block_len = 0;
+  f->line = NULL;
+  f->line_size = 0;
   return 0;
 }
 
 int sf_io_del(sfile* const f) {
   sf_io_close(f);
+  SDL_free(f->line);
+  f->line = NULL;
+  f->line_size = 0;
   return 0;
 }
 
@@ -32,6 +40,16 @@ int sf_io_open(sfile* const f, const char* filename, char mode) {
     SDL_LogWarnC("unable to get stats of file '%s'", filename);
   }
 
+  if (mode == 'r') {
+    f->block = SDL_malloc(FILE_BLOCK_SIZE);
+    if (f->block == NULL) {
+      sf_io_close(f);
+      return 1;
+    }
+    f->block_pos = 0;
+    f->block_len = 0;
+  }
+
   return 0;
 }
 
@@ -48,32 +66,144 @@ int sf_io_close(sfile* const f) {
   }
 
   f->file = NULL;
+  SDL_free(f->block);
+  f->block = NULL;
+  f->block_pos = 0;
+  f->block_len = 0;
 
   return 0;
 }
 
 Sint64 sf_io_seek(sfile* const f, Sint64 offset, int whence) {
+  if (f->block != NULL) {
+    // the stream is ahead of the file cursor by the unread bytes of the block
+    Sint64 unread = f->block_len - f->block_pos;
+    if (whence == SDL_IO_SEEK_CUR) {
+      if (offset >= -(Sint64) f->block_pos && offset <= unread) {
+        f->block_pos += offset; // stays in the block
+        return sf_io_tell(f);
+      }
+      offset -= unread;
+    }
+    f->block_pos = 0;
+    f->block_len = 0;
+  }
   return SDL_SeekIO(f->file, offset, whence);
 }
 
 Sint64 sf_io_tell(sfile* const f) {
-  return SDL_TellIO(f->file);
+  Sint64 offset = SDL_TellIO(f->file);
+  if (f->block != NULL && offset != -1) {
+    offset -= f->block_len - f->block_pos;
+  }
+  return offset;
 }
 
 Sint64 sf_io_rewind(sfile* const f) {
-  return SDL_SeekIO(f->file, 0, SDL_IO_SEEK_SET);
+  return sf_io_seek(f, 0, SDL_IO_SEEK_SET);
 }
 
 Sint64 sf_io_size(sfile* const f) {
   return SDL_GetIOSize(f->file);
 }
 
-// returns nb of objects read
-int sf_io_read(sfile* const f, void* ptr, size_t size) {
-  if (size > 0) {
-    return SDL_ReadIO(f->file, ptr, size);
+// reads the next block if the current one was read, returns the nb of unread
+// bytes in the block (0 at the end of the file or on error)
+static size_t sf_io_fill(sfile* const f) {
+  if (f->block_pos == f->block_len) {
+    f->block_pos = 0;
+    f->block_len = SDL_ReadIO(f->file, f->block, FILE_BLOCK_SIZE);
   }
-  return 0;
+  return f->block_len - f->block_pos;
+}
+
+// returns nb of bytes read
+size_t sf_io_read(sfile* const f, void* ptr, size_t size) {
+  if (f->block == NULL) {
+    return size > 0 ? SDL_ReadIO(f->file, ptr, size) : 0;
+  }
+
+  Uint8* dst = (Uint8*) ptr;
+  size_t total = 0;
+  while (total < size) {
+    size_t unread = f->block_len - f->block_pos;
+    if (unread == 0 && size - total >= FILE_BLOCK_SIZE) {
+      // large reads go directly to the destination
+      size_t n = SDL_ReadIO(f->file, dst + total, size - total);
+      if (n == 0) {
+        break;
+      }
+      total += n;
+      continue;
+    }
+    if (unread == 0 && (unread = sf_io_fill(f)) == 0) {
+      break; // end of file or read error
+    }
+
+    size_t n = SDL_min(unread, size - total);
+    SDL_memcpy(dst + total, f->block + f->block_pos, n);
+    f->block_pos += n;
+    total += n;
+  }
+  return total;
+}
+
+// returns the next byte, or -1 at the end of the file (the byte is not read
+// if "peek" is true)
+int sf_io_getc(sfile* const f, bool peek) {
+  if (f->block == NULL || sf_io_fill(f) == 0) {
+    return -1;
+  }
+  int c = f->block[f->block_pos];
+  if (!peek) {
+    f->block_pos += 1;
+  }
+  return c;
+}
+
+// reads the bytes up to the next "needle" (included) or the end of the file.
+// The returned data is valid until the next operation on the file. Returns
+// NULL if there is nothing to read or on error.
+const char* sf_io_read_until(sfile* const f, char needle, size_t* len) {
+  *len = 0;
+  if (f->block == NULL) {
+    SDL_SetError("file is not open for reading");
+    return NULL;
+  }
+
+  size_t line_len = 0;
+  while (sf_io_fill(f) > 0) {
+    const Uint8* start = f->block + f->block_pos;
+    size_t unread = f->block_len - f->block_pos;
+    const Uint8* end = SDL_memchr(start, needle, unread);
+    size_t n = end != NULL ? (size_t) (end - start) + 1 : unread;
+
+    if (end != NULL && line_len == 0) {
+      // in a single block: no copy
+      f->block_pos += n;
+      *len = n;
+      return (const char*) start;
+    }
+
+    if (line_len + n > f->line_size) {
+      size_t size = SDL_max(f->line_size * 2, line_len + n);
+      char* line = SDL_realloc(f->line, size);
+      if (line == NULL) {
+        return NULL;
+      }
+      f->line = line;
+      f->line_size = size;
+    }
+    SDL_memcpy(f->line + line_len, start, n);
+    line_len += n;
+    f->block_pos += n;
+    if (end != NULL) {
+      break;
+    }
+  }
+
+  *len = line_len;
+  return line_len > 0 ? f->line : NULL;
 }
 
 // returns nb of objects written
@@ -84,20 +214,88 @@ int sf_io_write(sfile* const f, const void* ptr, size_t size) {
   return 0;
 }
 
-// get the position of the next occurence of character "c". If not found,
-// returns the EOF offset.
-int sf_io_strchr(sfile* const f, Sint64* pos, char needle) {
-  Sint64 cur_pos = sf_io_tell(f);
+// files smaller than this are read, as mapping them costs more than a copy
+#define IO_MAP_MIN_SIZE (64 * 1024)
+
+// returns the native path of a file which can be mapped in memory (in a
+// directory of the search path, but not the write directory, whose files can
+// be truncated while mapped), or NULL. The path must be freed. Must be called
+// on the main thread, as the strings returned by PhysFS for the search path
+// are freed when it changes (see sf_sy_set_identity).
+char* sf_io_mappable_path(const char* filename) {
+  PHYSFS_Stat stat;
+  if (PHYSFS_stat(filename, &stat) == 0 ||
+      stat.filetype != PHYSFS_FILETYPE_REGULAR ||
+      stat.filesize < IO_MAP_MIN_SIZE) {
+    return NULL;
+  }
+
+  const char* dir = PHYSFS_getRealDir(filename);
+  const char* write_dir = PHYSFS_getWriteDir();
+  if (dir == NULL || (write_dir != NULL && SDL_strcmp(dir, write_dir) == 0)) {
+    return NULL;
+  }
+
+  SDL_PathInfo info;
+  if (!SDL_GetPathInfo(dir, &info) || info.type != SDL_PATHTYPE_DIRECTORY) {
+    return NULL; // archive
+  }
 
-  char c = 0;
-  while (c != needle) {
-    if (sf_io_read(f, &c, 1) <= 0) {
-      break; // eof of file or read error
+  char* path = NULL;
+  const char* sep = PHYSFS_getDirSeparator();
+  if (SDL_asprintf(&path, "%s%s%s", dir, sep, filename) < 0) {
+    return NULL;
+  }
+  return path;
+}
+
+// loads a whole file in a "u8" buffer, which must be deleted with sf_bf_del.
+// The file is mapped in memory from "map_path" if it is not NULL (see
+// sf_io_mappable_path), else it is read directly in the buffer. Can be called
+// on any thread.
+int sf_io_load(sbuffer* const b, const char* filename, const char* map_path) {
+  PHYSFS_Stat stat;
+  if (PHYSFS_stat(filename, &stat) == 0) {
+    SDL_SetError(
+        "unable to get stats of file '%s' (%s)", filename,
+        PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode()));
+    return -1;
+  }
+  if (stat.filetype != PHYSFS_FILETYPE_REGULAR) {
+    SDL_SetError("'%s' is not a file", filename);
+    return -1;
+  }
+
+  if (map_path != NULL && sf_bf_map(b, map_path) == 0) {
+    return 0;
+  }
+
+  SDL_IOStream* file = PHYSFSSDL3_openRead(filename);
+  if (file == NULL) {
+    return -1;
+  }
+
+  Sint64 size = SDL_GetIOSize(file);
+  if (size < 0 || sf_bf_new(b, SBUFFER_U8, (size_t) size) != 0) {
+    SDL_CloseIO(file);
+    return -1;
+  }
+
+  size_t total = 0;
+  while (total < (size_t) size) {
+    size_t n = SDL_ReadIO(file, (Uint8*) b->data + total, size - total);
+    if (n == 0) {
+      break;
     }
+    total += n;
   }
-  *pos = sf_io_tell(f);
-  sf_io_seek(f, cur_pos, SDL_IO_SEEK_SET);
+  SDL_CloseIO(file);
 
+  if (total != (size_t) size) {
+    SDL_SetError("unable to read file '%s'", filename);
+    sf_bf_del(b);
+    return -1;
+  }
   return 0;
 }
 
@@ -12,12 +12,91 @@ static int l_open(lua_State* L) {
     return luaL_error(L, "unable to open file: %s", SDL_GetError());
   }
 
-  luaL_getmetatable(L, SMGF_TYPE_FILE);
+  l_getmetatable(L, SMGF_TYPE_FILE);
   lua_setmetatable(L, -2);
 
   return 1;
 }
 
+// loads a whole file in a "u8" buffer, without going through a Lua string
+static int l_load(lua_State* L) {
+  smgf* const c = get_smgf(L);
+  const char* filename = luaL_checkstring(L, 1);
+
+  sbuffer* b = l_newbuffer(L);
+  sf_sy_trace_begin(c, filename);
+  char* map_path = sf_io_mappable_path(filename);
+  int error = sf_io_load(b, filename, map_path);
+  SDL_free(map_path);
+  sf_sy_trace_end(c);
+  if (error != 0) {
+    return luaL_error(L, "unable to load file: %s", SDL_GetError());
+  }
+
+  return 1;
+}
+
+// reads a whole file on a worker thread. The callback is called during a
+// next frame with a "u8" buffer, or nil and an error message.
+static int l_read_async(lua_State* L) {
+  smgf* const c = get_smgf(L);
+  const char* filename = luaL_checkstring(L, 1);
+  luaL_checktype(L, 2, LUA_TFUNCTION);
+
+  lua_settop(L, 2);
+  int ref = luaL_ref(L, LUA_REGISTRYINDEX);
+  int id = smgf_async_push(c, SASYNC_READ, filename, NULL, 0, ref);
+  if (id < 0) {
+    luaL_unref(L, LUA_REGISTRYINDEX, ref);
+    return luaL_error(
+        L, "unable to read file '%s': %s", filename, SDL_GetError());
+  }
+
+  lua_pushinteger(L, id);
+  return 1;
+}
+
+// writes a string or the bytes of a buffer (which are copied) on a worker
+// thread. The optional callback is called during a next frame with true, or
+// nil and an error message.
+static int l_write_async(lua_State* L) {
+  smgf* const c = get_smgf(L);
+  const char* filename = luaL_checkstring(L, 1);
+
+  const void* data = NULL;
+  size_t len = 0;
+  sbuffer* b = l_testudata(L, 2, SMGF_TYPE_BUFFER);
+  if (b != NULL) {
+    data = b->data;
+    len = b->length * sf_bf_element_size(b->type);
+  } else {
+    data = luaL_checklstring(L, 2, &len);
+  }
+
+  int ref = LUA_NOREF;
+  if (!lua_isnoneornil(L, 3)) {
+    luaL_checktype(L, 3, LUA_TFUNCTION);
+    lua_settop(L, 3);
+    ref = luaL_ref(L, LUA_REGISTRYINDEX);
+  }
+  int id = smgf_async_push(c, SASYNC_WRITE, filename, data, len, ref);
+  if (id < 0) {
+    luaL_unref(L, LUA_REGISTRYINDEX, ref);
+    return luaL_error(
+        L, "unable to write file '%s': %s", filename, SDL_GetError());
+  }
+
+  lua_pushinteger(L, id);
+  return 1;
+}
+
+static int l_cancel(lua_State* L) {
+  smgf* const c = get_smgf(L);
+  int id = (int) luaL_checkinteger(L, 1);
+  lua_pushboolean(L, smgf_async_cancel(c, id));
+  return 1;
+}
+
 static int l_mkdir(lua_State* L) {
   // smgf* const c = get_smgf(L);
   const char* dirname = luaL_checkstring(L, 1);
@@ -72,7 +151,7 @@ static int l_exists(lua_State* L) {
 
 static int l_close(lua_State* L) {
   smgf* const c = get_smgf(L);
-  sfile* f = (sfile*) luaL_checkudata(L, 1, SMGF_TYPE_FILE);
+  sfile* f = (sfile*) l_checkudata(L, 1, SMGF_TYPE_FILE);
 
   if (sf_io_close(f) != 0) {
     return luaL_error(L, "unable to close file: %s", SDL_GetError());
@@ -83,7 +162,7 @@ static int l_close(lua_State* L) {
 
 static int l_size(lua_State* L) {
   smgf* const c = get_smgf(L);
-  sfile* f = (sfile*) luaL_checkudata(L, 1, SMGF_TYPE_FILE);
+  sfile* f = (sfile*) l_checkudata(L, 1, SMGF_TYPE_FILE);
 
   Sint64 size = sf_io_size(f);
   if (size == -1) {
@@ -96,7 +175,7 @@ static int l_size(lua_State* L) {
 
 static int l_seek(lua_State* L) {
   smgf* const c = get_smgf(L);
-  sfile* f = (sfile*) luaL_checkudata(L, 1, SMGF_TYPE_FILE);
+  sfile* f = (sfile*) l_checkudata(L, 1, SMGF_TYPE_FILE);
   Sint64 offset = luaL_checknumber(L, 2);
 
   static const int mode[] = {SDL_IO_SEEK_SET, SDL_IO_SEEK_CUR, SDL_IO_SEEK_END};
@@ -115,7 +194,7 @@ static int l_seek(lua_State* L) {
 static int l_rewind(lua_State* L) {
   smgf* const c = get_smgf(L);
 
-  sfile* f = (sfile*) luaL_checkudata(L, 1, SMGF_TYPE_FILE);
+  sfile* f = (sfile*) l_checkudata(L, 1, SMGF_TYPE_FILE);
   sf_io_rewind(f);
 
   return 0;
@@ -124,80 +203,233 @@ static int l_rewind(lua_State* L) {
 static int l_tell(lua_State* L) {
   smgf* const c = get_smgf(L);
 
-  sfile* f = (sfile*) luaL_checkudata(L, 1, SMGF_TYPE_FILE);
+  sfile* f = (sfile*) l_checkudata(L, 1, SMGF_TYPE_FILE);
   Sint64 offset = sf_io_tell(f);
   lua_pushinteger(L, offset);
 
   return 1;
 }
 
+// reads a numeral, as io.read("n") in Lua's standard library
+#define FILE_NUMERAL_SIZE 200
+
+typedef struct lua_numeral {
+  sfile* f;
+  int n;
+  char buf[FILE_NUMERAL_SIZE + 1];
+} lua_numeral;
+
+// adds the next byte to the numeral (which is invalidated if too long)
+static bool lua_numeral_add(lua_numeral* rn) {
+  if (rn->n >= FILE_NUMERAL_SIZE) {
+    rn->buf[0] = '\0';
+    return false;
+  }
+  rn->buf[rn->n++] = (char) sf_io_getc(rn->f, false);
+  return true;
+}
+
+// adds the next byte if it is one of the two bytes of "set"
+static bool lua_numeral_test(lua_numeral* rn, const char* set) {
+  int c = sf_io_getc(rn->f, true);
+  return (c == set[0] || c == set[1]) && c != -1 && lua_numeral_add(rn);
+}
+
+static int lua_numeral_digits(lua_numeral* rn, bool hex) {
+  int count = 0;
+  int c = sf_io_getc(rn->f, true);
+  while (c != -1 && (hex ? SDL_isxdigit(c) : SDL_isdigit(c)) &&
+         lua_numeral_add(rn)) {
+    count += 1;
+    c = sf_io_getc(rn->f, true);
+  }
+  return count;
+}
+
+// pushes the number read, or nil if the next bytes are not a numeral
+static void lua_readnumber(lua_State* L, sfile* f) {
+  lua_numeral rn = {.f = f, .n = 0};
+
+  int c = sf_io_getc(f, true);
+  while (c != -1 && SDL_isspace(c)) {
+    sf_io_getc(f, false);
+    c = sf_io_getc(f, true);
+  }
+
+  int count = 0;
+  bool hex = false;
+  lua_numeral_test(&rn, "-+");
+  if (lua_numeral_test(&rn, "00")) {
+    if (lua_numeral_test(&rn, "xX")) {
+      hex = true;
+    } else {
+      count = 1;
+    }
+  }
+  count += lua_numeral_digits(&rn, hex);
+  if (lua_numeral_test(&rn, "..")) {
+    count += lua_numeral_digits(&rn, hex);
+  }
+  if (count > 0 && lua_numeral_test(&rn, hex ? "pP" : "eE")) {
+    lua_numeral_test(&rn, "-+");
+    lua_numeral_digits(&rn, false);
+  }
+  rn.buf[rn.n] = '\0';
+
+  if (lua_stringtonumber(L, rn.buf) == 0) {
+    lua_pushnil(L);
+  }
+}
+
+// reads "bytes" bytes (less at the end of the file) in a new string
+static int lua_readbytes(lua_State* L, sfile* f, Sint64 bytes) {
+  if (bytes <= 0) {
+    return 0;
+  }
+
+  luaL_Buffer b;
+  char* data = luaL_buffinitsize(L, &b, bytes);
+  size_t n = sf_io_read(f, data, bytes);
+  if (n == 0) {
+    if (sf_io_tell(f) >= sf_io_size(f)) {
+      return luaL_error(L, "unable to read outside of file");
+    }
+
+    return luaL_error(L, "unable to read from file: %s", SDL_GetError());
+  }
+
+  luaL_pushresultsize(&b, n);
+  return 1;
+}
+
 static int l_read(lua_State* L) {
   smgf* const c = get_smgf(L);
-  sfile* f = (sfile*) luaL_checkudata(L, 1, SMGF_TYPE_FILE);
+  sfile* f = (sfile*) l_checkudata(L, 1, SMGF_TYPE_FILE);
 
   if (f->mode != 'r') {
     return luaL_error(
         L, "unable to read from file: PhysicsFS error: file open for writing");
   }
 
-  Sint64 bytes = 0;
-
-  int n = lua_gettop(L);
-  if (n == 1) {
-    luaL_error(L, "missing argument ('all', 'line', or a number)");
-  } else if (n >= 2) {
-    // if the argument is a number, we read N characters
-    if (lua_type(L, 2) == LUA_TNUMBER) {
-      bytes = lua_tointeger(L, 2);
-    } else if (lua_type(L, 2) == LUA_TSTRING) {
-      const char* mode = lua_tostring(L, 2);
-      if (SDL_strcmp(mode, "all") == 0) {
-        // read the rest of the file starting at cursor
-        bytes = sf_io_size(f) - sf_io_tell(f);
-      } else if (SDL_strcmp(mode, "line") == 0) {
-        // read only a line
-        Sint64 pos = 0;
-        sf_io_strchr(f, &pos, '\n');
-
-        bytes = pos - sf_io_tell(f);
-      } else {
-        luaL_error(L, "unknown read mode '%s'", mode);
-      }
-    } else {
-      luaL_error(L, "invalid call to read()");
+  if (lua_gettop(L) == 1) {
+    return luaL_error(L, "missing argument ('all', 'line', or a number)");
+  }
+
+  // if the argument is a number, we read N characters
+  if (lua_type(L, 2) == LUA_TNUMBER) {
+    return lua_readbytes(L, f, lua_tointeger(L, 2));
+  }
+  if (lua_type(L, 2) != LUA_TSTRING) {
+    return luaL_error(L, "invalid call to read()");
+  }
+
+  const char* mode = lua_tostring(L, 2);
+  if (SDL_strcmp(mode, "all") == 0) {
+    // read the rest of the file starting at cursor
+    return lua_readbytes(L, f, sf_io_size(f) - sf_io_tell(f));
+  } else if (SDL_strcmp(mode, "line") == 0) {
+    // read only a line, with its end of line
+    size_t len = 0;
+    const char* line = sf_io_read_until(f, '\n', &len);
+    if (line == NULL) {
+      return 0;
     }
+    lua_pushlstring(L, line, len);
+    return 1;
+  } else if (SDL_strcmp(mode, "number") == 0) {
+    lua_readnumber(L, f);
+    return 1;
   }
 
-  if (bytes == 0) {
+  return luaL_error(L, "unknown read mode '%s'", mode);
+}
+
+static int l_lines_next(lua_State* L) {
+  sfile* f = (sfile*) lua_touserdata(L, lua_upvalueindex(1));
+  if (f->file == NULL) {
+    return luaL_error(L, "unable to read from file: file is closed");
+  }
+
+  size_t len = 0;
+  const char* line = sf_io_read_until(f, '\n', &len);
+  if (line == NULL) {
     return 0;
   }
+  if (line[len - 1] == '\n') {
+    len -= 1;
+  }
+  lua_pushlstring(L, line, len);
+  return 1;
+}
 
-  void* data = SDL_malloc(bytes);
-  if (data == NULL) {
-    return luaL_error(L, "error allocating buffer for file reading");
+// returns an iterator on the lines of the file, without their end of line
+static int l_lines(lua_State* L) {
+  smgf* const c = get_smgf(L);
+  sfile* f = (sfile*) l_checkudata(L, 1, SMGF_TYPE_FILE);
+
+  if (f->mode != 'r') {
+    return luaL_error(
+        L, "unable to read from file: PhysicsFS error: file open for writing");
   }
 
-  if (sf_io_read(f, data, bytes) <= 0) {
-    if (sf_io_tell(f) >= sf_io_size(f)) {
-      return luaL_error(L, "unable to read outside of file");
-    }
+  lua_settop(L, 1);
+  lua_pushcclosure(L, l_lines_next, 1);
+  return 1;
+}
 
-    return luaL_error(L, "unable to read from file: %s", SDL_GetError());
+// reads up to "count" elements of a buffer starting at element "first" (all
+// the buffer by default), returns the nb of elements read
+static int l_read_into(lua_State* L) {
+  smgf* const c = get_smgf(L);
+  sfile* f = (sfile*) l_checkudata(L, 1, SMGF_TYPE_FILE);
+  sbuffer* b = (sbuffer*) l_checkudata(L, 2, SMGF_TYPE_BUFFER);
+
+  if (f->mode != 'r') {
+    return luaL_error(
+        L, "unable to read from file: PhysicsFS error: file open for writing");
   }
 
-  lua_pushlstring(L, data, bytes);
-  SDL_free(data);
+  lua_Integer first = luaL_optinteger(L, 3, 1);
+  luaL_argcheck(
+      L, first >= 1 && (lua_Unsigned) first <= b->length + 1, 3,
+      "index out of range");
+  lua_Integer count = luaL_optinteger(L, 4, b->length - (first - 1));
+  luaL_argcheck(
+      L, count >= 0 && (lua_Unsigned) count <= b->length - (first - 1), 4,
+      "count out of range");
+
+  // only whole elements are kept, the file is positioned after the last one
+  size_t element_size = sf_bf_element_size(b->type);
+  Uint8* data = (Uint8*) b->data + (first - 1) * element_size;
+  size_t size = count * element_size;
+  size_t total = sf_io_read(f, data, size);
+  if (total < size && SDL_GetIOStatus(f->file) == SDL_IO_STATUS_ERROR) {
+    return luaL_error(L, "unable to read from file: %s", SDL_GetError());
+  }
+  size_t extra = total % element_size;
+  if (extra != 0) {
+    sf_io_seek(f, -(Sint64) extra, SDL_IO_SEEK_CUR);
+  }
 
+  lua_pushinteger(L, total / element_size);
   return 1;
 }
 
 static int l_write(lua_State* L) {
   smgf* const c = get_smgf(L);
-  sfile* f = (sfile*) luaL_checkudata(L, 1, SMGF_TYPE_FILE);
-
-  size_t len;
-  const char* str = luaL_checklstring(L, 2, &len);
-  if (sf_io_write(f, (void*) str, len) <= 0) {
+  sfile* f = (sfile*) l_checkudata(L, 1, SMGF_TYPE_FILE);
+
+  // a string, or the bytes of a buffer
+  const void* data = NULL;
+  size_t len = 0;
+  sbuffer* b = l_testudata(L, 2, SMGF_TYPE_BUFFER);
+  if (b != NULL) {
+    data = b->data;
+    len = b->length * sf_bf_element_size(b->type);
+  } else {
+    data = luaL_checklstring(L, 2, &len);
+  }
+  if (sf_io_write(f, data, len) <= 0) {
     return luaL_error(L, "unable to write to file: %s", SDL_GetError());
   }
 
@@ -206,7 +438,7 @@ static int l_write(lua_State* L) {
 
 static int l_file_del(lua_State* L) { // function on garbage collection
   smgf* const c = get_smgf(L);
-  sfile* f = (sfile*) luaL_checkudata(L, 1, SMGF_TYPE_FILE);
+  sfile* f = (sfile*) l_checkudata(L, 1, SMGF_TYPE_FILE);
 
   sf_io_del(f);
   return 0;
@@ -214,7 +446,7 @@ static int l_file_del(lua_State* L) { // function on garbage collection
 
 static int l_flush(lua_State* L) {
   smgf* const c = get_smgf(L);
-  sfile* f = (sfile*) luaL_checkudata(L, 1, SMGF_TYPE_FILE);
+  sfile* f = (sfile*) l_checkudata(L, 1, SMGF_TYPE_FILE);
 
   if (!sf_io_flush(f)) {
     return luaL_error(L, "unable to flush file: %s", SDL_GetError());
@@ -225,16 +457,20 @@ static int l_flush(lua_State* L) {
 
 static const struct luaL_Reg smgf_io[] = {
     {"open", l_open},     {"mkdir", l_mkdir},   {"delete", l_delete},
-    {"type", l_get_type}, {"exists", l_exists},
+    {"type", l_get_type}, {"exists", l_exists}, {"load", l_load},
+    {"read_async", l_read_async}, {"write_async", l_write_async},
+    {"cancel", l_cancel},
 
     {"close", l_close},   {"size", l_size},     {"seek", l_seek},
     {"rewind", l_rewind}, {"tell", l_tell},     {"read", l_read},
-    {"write", l_write},   {"flush", l_flush},   {NULL, NULL}};
+    {"write", l_write},   {"flush", l_flush},   {"lines", l_lines},
+    {"read_into", l_read_into}, {NULL, NULL}};
 
 static const struct luaL_Reg file_func[] = {
     {"close", l_close},   {"size", l_size},   {"seek", l_seek},
     {"rewind", l_rewind}, {"tell", l_tell},   {"read", l_read},
-    {"write", l_write},   {"flush", l_flush}, {NULL, NULL}};
+    {"write", l_write},   {"flush", l_flush}, {"lines", l_lines},
+    {"read_into", l_read_into}, {NULL, NULL}};
 
 void init_io(lua_State* L) {
   size_t n = SDL_arraysize(smgf_io);
@@ -243,7 +479,7 @@ void init_io(lua_State* L) {
   lua_setfield(L, -2, "io");
 
   // add file type
-  luaL_newmetatable(L, SMGF_TYPE_FILE);
+  l_newmetatable(L, SMGF_TYPE_FILE);
   lua_pushcfunction(L, l_file_del);
   lua_setfield(L, -2, "__gc");
   lua_pushvalue(L, -1);
@@ -21,6 +21,15 @@ void sf_sy_set_fps(smgf* const c, int fps) {
   c->fps = fps;
 }
 
+int sf_sy_get_update_rate(smgf* const c) {
+  return c->update_rate;
+}
+
+void sf_sy_set_update_rate(smgf* const c, int update_rate) {
+  c->update_rate = update_rate;
+  c->update_accumulator = 0;
+}
+
 int sf_sy_get_zoom(smgf* const c) {
   return c->zoom;
 }
@@ -75,15 +84,64 @@ void sf_sy_get_platform(smgf* const c, char const** platform) {
   *platform = SDL_GetPlatform();
 }
 
-void sf_sy_sleep(smgf* const c, float seconds) {
-  Uint32 ms = seconds * 1000.f;
-  SDL_Delay(ms);
+void sf_sy_sleep(smgf* const c, double seconds) {
+  SDL_DelayPrecise(seconds * SDL_NS_PER_SECOND);
 }
 
-void sf_sy_get_dt(smgf* const c, float* dt) {
+void sf_sy_get_dt(smgf* const c, double* dt) {
   *dt = c->dt;
 }
 
+// keeps the counters of the frame that just ended, and resets them for the
+// next one
+void sf_sy_end_frame_stats(smgf* const c) {
+  smgf_stats* const s = &c->stats;
+  s->nb_state_changes = c->rstate.nb_issued - s->first_state_change;
+  s->lua_memory =
+      (size_t) lua_gc(c->L, LUA_GCCOUNT) * 1024 + lua_gc(c->L, LUA_GCCOUNTB);
+  s->nb_allocs = c->heap.nb_allocs;
+  s->nb_frees = c->heap.nb_frees;
+  s->heap_live = c->heap.live;
+  s->heap_peak = c->heap.peak;
+  c->heap.nb_allocs = 0;
+  c->heap.nb_frees = 0;
+
+  smgf_frame_times* const f = &c->frame_times;
+  f->times[f->next] = s->frame_time;
+  f->update_times[f->next] = s->update_time;
+  f->draw_times[f->next] = s->draw_time;
+  f->present_times[f->next] = s->present_time;
+  f->next = (f->next + 1) % NB_FRAME_TIMES;
+  if (f->count < NB_FRAME_TIMES) {
+    f->count += 1;
+  }
+
+  c->last_stats = *s;
+  SDL_zerop(s);
+  s->first_state_change = c->rstate.nb_issued;
+}
+
+// mean and variance (in seconds and seconds²) of the last frame times
+void sf_sy_get_frame_time(smgf* const c, double* mean, double* variance) {
+  smgf_frame_times* const f = &c->frame_times;
+  *mean = 0;
+  *variance = 0;
+  if (f->count == 0) {
+    return;
+  }
+
+  for (int i = 0; i < f->count; i++) {
+    *mean += (double) f->times[i] / SDL_NS_PER_SECOND;
+  }
+  *mean /= f->count;
+
+  for (int i = 0; i < f->count; i++) {
+    double d = (double) f->times[i] / SDL_NS_PER_SECOND - *mean;
+    *variance += d * d;
+  }
+  *variance /= f->count;
+}
+
 int sf_sy_open_url(smgf* const c, const char* url) {
   return SDL_OpenURL(url);
 }
@@ -114,6 +172,7 @@ int sf_sy_set_identity(smgf* const c, const char* org, const char* app) {
     };
     PHYSFS_unmount(current_pref_dir);
   }
+  c->mount_generation += 1;
 
   if (c->organisation) {
     SDL_free(c->organisation);
@@ -184,3 +243,148 @@ SDL_Locale** sf_sy_get_preferred_locales(smgf* const c) {
 char* sf_sy_get_version(smgf* const c) {
   return SMGF_VERSION;
 }
+
+int sf_sy_trace_start(smgf* const c) {
+  smgf_trace* const t = &c->trace;
+  if (t->events == NULL) {
+    t->events = SDL_malloc(TRACE_CAPACITY * sizeof(strace_event));
+    if (t->events == NULL) {
+      SDL_SetError("error allocating memory for trace");
+      return -1;
+    }
+  }
+
+  SDL_SetAtomicInt(&t->nb_events, 0);
+  SDL_SetAtomicInt(&t->enabled, 1);
+  return 0;
+}
+
+static void sf_sy_trace_zone(smgf* const c, const char* name, char phase) {
+  smgf_trace* const t = &c->trace;
+  if (!SDL_GetAtomicInt(&t->enabled)) {
+    return;
+  }
+
+  Uint32 i = (Uint32) SDL_AddAtomicInt(&t->nb_events, 1) % TRACE_CAPACITY;
+  strace_event* const e = &t->events[i];
+  e->time = SDL_GetTicksNS();
+  e->thread = SDL_GetCurrentThreadID();
+  e->phase = phase;
+  SDL_strlcpy(e->name, name, TRACE_NAME_SIZE);
+}
+
+void sf_sy_trace_begin(smgf* const c, const char* name) {
+  sf_sy_trace_zone(c, name, 'B');
+}
+
+void sf_sy_trace_end(smgf* const c) {
+  sf_sy_trace_zone(c, "", 'E');
+}
+
+// writes a string in a JSON file, escaping it
+static void sf_sy_trace_write_string(SDL_IOStream* f, const char* str) {
+  SDL_WriteU8(f, '"');
+  for (const char* p = str; *p != '\0'; p++) {
+    if (*p == '"' || *p == '\\') {
+      SDL_IOprintf(f, "\\%c", *p);
+    } else if ((Uint8) *p < 0x20) {
+      SDL_IOprintf(f, "\\u%04x", (Uint8) *p);
+    } else {
+      SDL_WriteU8(f, *p);
+    }
+  }
+  SDL_WriteU8(f, '"');
+}
+
+static void sf_sy_trace_write_event(
+    SDL_IOStream* f, const char* sep, const char* name, char phase,
+    Uint64 time, SDL_ThreadID thread) {
+  SDL_IOprintf(f, "%s{\"name\":", sep);
+  sf_sy_trace_write_string(f, name);
+  SDL_IOprintf(
+      f, ",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%" SDL_PRIu64 "}",
+      phase, time / 1000.0, thread);
+}
+
+// zones still open are counted per thread (for this nb of threads at most),
+// to be closed at the end of the trace
+#define TRACE_MAX_THREADS 16
+
+typedef struct strace_depth {
+  SDL_ThreadID thread;
+  int depth;
+} strace_depth;
+
+// returns the depth of a thread, or NULL if there are too many threads
+static int* sf_sy_trace_depth(
+    strace_depth* depths, int* nb_depths, SDL_ThreadID thread) {
+  for (int i = 0; i < *nb_depths; i++) {
+    if (depths[i].thread == thread) {
+      return &depths[i].depth;
+    }
+  }
+  if (*nb_depths == TRACE_MAX_THREADS) {
+    return NULL;
+  }
+  strace_depth* d = &depths[*nb_depths];
+  *nb_depths += 1;
+  d->thread = thread;
+  d->depth = 0;
+  return &d->depth;
+}
+
+// stops recording, and writes the recorded events as a Chrome trace (JSON
+// format) in the write directory. Zones still open are closed, and the ends
+// of zones whose beginning was overwritten in the ring buffer are dropped.
+int sf_sy_trace_stop(smgf* const c, const char* filename) {
+  smgf_trace* const t = &c->trace;
+  if (!SDL_GetAtomicInt(&t->enabled)) {
+    SDL_SetError("no trace was started");
+    return -1;
+  }
+  // the events are kept (and freed by smgf_quit): another thread can still
+  // be recording a zone
+  SDL_SetAtomicInt(&t->enabled, 0);
+  Uint64 now = SDL_GetTicksNS();
+
+  SDL_IOStream* f = PHYSFSSDL3_openWrite(filename);
+  if (f == NULL) {
+    return -1;
+  }
+
+  // when the ring buffer is full, the oldest events have been overwritten
+  Uint32 nb_events = SDL_GetAtomicInt(&t->nb_events);
+  Uint32 first = 0;
+  if (nb_events > TRACE_CAPACITY) {
+    first = nb_events - TRACE_CAPACITY;
+  }
+
+  strace_depth depths[TRACE_MAX_THREADS];
+  int nb_depths = 0;
+  const char* sep = "";
+  SDL_IOprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+  for (Uint32 i = first; i < nb_events; i++) {
+    const strace_event* const e = &t->events[i % TRACE_CAPACITY];
+    int* depth = sf_sy_trace_depth(depths, &nb_depths, e->thread);
+    if (depth != NULL) {
+      if (e->phase == 'B') {
+        *depth += 1;
+      } else if (*depth > 0) {
+        *depth -= 1;
+      } else {
+        continue; // its zone began before the first event kept
+      }
+    }
+    sf_sy_trace_write_event(f, sep, e->name, e->phase, e->time, e->thread);
+    sep = ",\n";
+  }
+  for (int i = 0; i < nb_depths; i++) {
+    for (int j = 0; j < depths[i].depth; j++) {
+      sf_sy_trace_write_event(f, sep, "", 'E', now, depths[i].thread);
+      sep = ",\n";
+    }
+  }
+  SDL_IOprintf(f, "\n]}\n");
+
+  return SDL_CloseIO(f) ? 0 : -1;
+}
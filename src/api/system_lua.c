@@ -63,6 +63,29 @@ static int l_set_fps(lua_State* L) {
   return 0;
 }
 
+static int l_get_update_rate(lua_State* L) {
+  smgf* const c = get_smgf(L);
+  int update_rate = sf_sy_get_update_rate(c);
+  if (update_rate == 0) {
+    lua_pushnil(L);
+  } else {
+    lua_pushinteger(L, update_rate);
+  }
+  return 1;
+}
+
+static int l_set_update_rate(lua_State* L) {
+  smgf* const c = get_smgf(L);
+
+  int update_rate = luaL_optnumber(L, 1, 0);
+  luaL_argcheck(
+      L, update_rate >= 0, 1,
+      "must be positive (or nil to disable fixed updates)");
+
+  sf_sy_set_update_rate(c, update_rate);
+  return 0;
+}
+
 static int l_get_zoom(lua_State* L) {
   smgf* const c = get_smgf(L);
   lua_pushinteger(L, sf_sy_get_zoom(c));
@@ -122,7 +145,7 @@ static int l_get_platform(lua_State* L) {
 static int l_sleep(lua_State* L) {
   smgf* const c = get_smgf(L);
 
-  int seconds = luaL_checknumber(L, 1);
+  lua_Number seconds = luaL_checknumber(L, 1);
   luaL_argcheck(L, seconds >= 0, 1, "must be positive");
 
   sf_sy_sleep(c, seconds);
@@ -132,12 +155,74 @@ static int l_sleep(lua_State* L) {
 
 static int l_get_dt(lua_State* L) {
   smgf* const c = get_smgf(L);
-  float dt;
+  double dt;
   sf_sy_get_dt(c, &dt);
   lua_pushnumber(L, dt);
   return 1;
 }
 
+static int l_get_frame_time(lua_State* L) {
+  smgf* const c = get_smgf(L);
+  double mean = 0, variance = 0;
+  sf_sy_get_frame_time(c, &mean, &variance);
+  lua_pushnumber(L, mean);
+  lua_pushnumber(L, variance);
+  return 2;
+}
+
+// returns the counters of the last complete frame, in a new table
+static int l_get_stats(lua_State* L) {
+  smgf* const c = get_smgf(L);
+  const smgf_stats* const s = &c->last_stats;
+
+  lua_createtable(L, 0, 22);
+  lua_pushnumber(L, (double) s->update_time / SDL_NS_PER_SECOND);
+  lua_setfield(L, -2, "update_time");
+  lua_pushnumber(L, (double) s->draw_time / SDL_NS_PER_SECOND);
+  lua_setfield(L, -2, "draw_time");
+  lua_pushnumber(L, (double) s->present_time / SDL_NS_PER_SECOND);
+  lua_setfield(L, -2, "present_time");
+  lua_pushinteger(L, s->nb_draw_calls);
+  lua_setfield(L, -2, "draw_calls");
+  lua_pushinteger(L, s->nb_texture_binds);
+  lua_setfield(L, -2, "texture_binds");
+  lua_pushinteger(L, s->nb_target_switches);
+  lua_setfield(L, -2, "target_switches");
+  lua_pushinteger(L, s->nb_state_changes);
+  lua_setfield(L, -2, "state_changes");
+  lua_pushinteger(L, s->nb_pcalls);
+  lua_setfield(L, -2, "pcalls");
+  lua_pushinteger(L, s->nb_events);
+  lua_setfield(L, -2, "events");
+  lua_pushinteger(L, s->nb_text_hits);
+  lua_setfield(L, -2, "text_cache_hits");
+  lua_pushinteger(L, s->nb_text_misses);
+  lua_setfield(L, -2, "text_cache_misses");
+  lua_pushinteger(L, s->nb_async);
+  lua_setfield(L, -2, "async_requests");
+  lua_pushnumber(L, (double) s->async_wait_time / SDL_NS_PER_SECOND);
+  lua_setfield(L, -2, "async_wait_time");
+  lua_pushnumber(L, (double) s->async_io_time / SDL_NS_PER_SECOND);
+  lua_setfield(L, -2, "async_io_time");
+  lua_pushnumber(L, (double) s->async_max_time / SDL_NS_PER_SECOND);
+  lua_setfield(L, -2, "async_max_time");
+  lua_pushinteger(L, s->lua_memory);
+  lua_setfield(L, -2, "lua_memory");
+  lua_pushinteger(L, s->nb_gc_steps);
+  lua_setfield(L, -2, "gc_steps");
+  lua_pushnumber(L, (double) s->gc_time / SDL_NS_PER_SECOND);
+  lua_setfield(L, -2, "gc_time");
+  lua_pushinteger(L, s->nb_allocs);
+  lua_setfield(L, -2, "allocs");
+  lua_pushinteger(L, s->nb_frees);
+  lua_setfield(L, -2, "frees");
+  lua_pushinteger(L, s->heap_live);
+  lua_setfield(L, -2, "heap_live");
+  lua_pushinteger(L, s->heap_peak);
+  lua_setfield(L, -2, "heap_peak");
+  return 1;
+}
+
 static int l_get_fullscreen(lua_State* L) {
   smgf* const c = get_smgf(L);
 
@@ -328,6 +413,108 @@ static int l_get_version(lua_State* L) {
   return 1;
 }
 
+static int l_start_trace(lua_State* L) {
+  smgf* const c = get_smgf(L);
+  if (sf_sy_trace_start(c)) {
+    return luaL_error(L, "cannot start trace (%s)", SDL_GetError());
+  }
+  return 0;
+}
+
+static int l_stop_trace(lua_State* L) {
+  smgf* const c = get_smgf(L);
+  const char* filename = luaL_checkstring(L, 1);
+  if (sf_sy_trace_stop(c, filename)) {
+    return luaL_error(L, "cannot save trace (%s)", SDL_GetError());
+  }
+  return 0;
+}
+
+static int l_trace_begin(lua_State* L) {
+  smgf* const c = get_smgf(L);
+  const char* name = luaL_checkstring(L, 1);
+  sf_sy_trace_begin(c, name);
+  return 0;
+}
+
+static int l_trace_end(lua_State* L) {
+  smgf* const c = get_smgf(L);
+  sf_sy_trace_end(c);
+  return 0;
+}
+
+static int lua_event_int(lua_State* L, const char* k) {
+  lua_getfield(L, 1, k);
+  int v = (int) luaL_optinteger(L, -1, 0);
+  lua_pop(L, 1);
+  return v;
+}
+
+// sends an input event to the game, as if it came from the user: a table in
+// the format given to smgf.events (key, text and mouse events)
+static int l_push_event(lua_State* L) {
+  smgf* const c = get_smgf(L);
+  luaL_checktype(L, 1, LUA_TTABLE);
+  lua_getfield(L, 1, "type");
+  const char* type = luaL_checkstring(L, -1);
+
+  bool key_down = SDL_strcmp(type, "key_down") == 0;
+  if (key_down || SDL_strcmp(type, "key_up") == 0) {
+    lua_getfield(L, 1, "key");
+    SDL_KeyboardEvent ev = {0};
+    ev.scancode = smgf_get_scancode_from_name(luaL_checkstring(L, -1));
+    luaL_argcheck(L, ev.scancode != SDL_SCANCODE_UNKNOWN, 1, "unknown key");
+    ev.mod = (SDL_Keymod) lua_event_int(L, "mod");
+    if (key_down) {
+      smgf_lkey_down(c, &ev);
+    } else {
+      smgf_lkey_up(c, &ev);
+    }
+  } else if (SDL_strcmp(type, "text_input") == 0) {
+    lua_getfield(L, 1, "text");
+    smgf_ltext_input(c, luaL_checkstring(L, -1));
+  } else if (SDL_strcmp(type, "mouse_down") == 0) {
+    smgf_lmouse_down(
+        c, lua_event_int(L, "x"), lua_event_int(L, "y"),
+        lua_event_int(L, "button"));
+  } else if (SDL_strcmp(type, "mouse_up") == 0) {
+    smgf_lmouse_up(
+        c, lua_event_int(L, "x"), lua_event_int(L, "y"),
+        lua_event_int(L, "button"));
+  } else if (SDL_strcmp(type, "mouse_moved") == 0) {
+    smgf_lmouse_moved(
+        c, lua_event_int(L, "x"), lua_event_int(L, "y"),
+        lua_event_int(L, "dx"), lua_event_int(L, "dy"));
+  } else if (SDL_strcmp(type, "mouse_wheel") == 0) {
+    smgf_lmouse_wheel(
+        c, lua_event_int(L, "x"), lua_event_int(L, "y"),
+        SDL_MOUSEWHEEL_NORMAL);
+  } else {
+    return luaL_argerror(L, 1, "unsupported event type");
+  }
+
+  return 0;
+}
+
+static int l_profiler_start(lua_State* L) {
+  smgf* const c = get_smgf(L);
+  double interval = luaL_optnumber(L, 1, 0.001);
+  luaL_argcheck(L, interval > 0, 1, "interval must be > 0");
+  if (smgf_profiler_start(c, interval * SDL_NS_PER_SECOND)) {
+    return luaL_error(L, "cannot start profiler (%s)", SDL_GetError());
+  }
+  return 0;
+}
+
+static int l_profiler_stop(lua_State* L) {
+  smgf* const c = get_smgf(L);
+  const char* filename = luaL_checkstring(L, 1);
+  if (smgf_profiler_stop(c, filename)) {
+    return luaL_error(L, "cannot save profile (%s)", SDL_GetError());
+  }
+  return 0;
+}
+
 static const struct luaL_Reg smgf_system[] = {
     {"get_dimensions", l_get_dimensions},
     {"set_dimensions", l_set_dimensions},
@@ -335,6 +522,8 @@ static const struct luaL_Reg smgf_system[] = {
     {"get_height", l_get_height},
     {"get_fps", l_get_fps},
     {"set_fps", l_set_fps},
+    {"get_update_rate", l_get_update_rate},
+    {"set_update_rate", l_set_update_rate},
     {"get_zoom", l_get_zoom},
     {"set_zoom", l_set_zoom},
     {"get_cursor_visible", l_get_cursor_visible},
@@ -345,6 +534,15 @@ static const struct luaL_Reg smgf_system[] = {
     {"get_platform", l_get_platform},
     {"sleep", l_sleep},
     {"get_dt", l_get_dt},
+    {"get_frame_time", l_get_frame_time},
+    {"get_stats", l_get_stats},
+    {"start_trace", l_start_trace},
+    {"stop_trace", l_stop_trace},
+    {"trace_begin", l_trace_begin},
+    {"trace_end", l_trace_end},
+    {"push_event", l_push_event},
+    {"profiler_start", l_profiler_start},
+    {"profiler_stop", l_profiler_stop},
     {"get_fullscreen", l_get_fullscreen},
     {"set_fullscreen", l_set_fullscreen},
     // {"log", l_log},
@@ -1,105 +1,259 @@
 #include "smgf.h"
 #include "api_lua.h"
 
-// searches for a module name in a search path (usually package.path):
-// tries to open files and return the filename of the first file that could be
-// opened + pushes it onto the Lua stack.
-const char* searchpath(
-    lua_State* L, const char* name, const char* path, const char* sep,
-    const char* dirsep) {
-  // we replace Lua's "." directory separator with a slash (for physfs),
-  // and create a new path variable with "?" characters replaced by module name
-  const char* name_withdirsep = luaL_gsub(L, name, ".", dirsep);
-  const char* path_withmodname =
-      luaL_gsub(L, path, LUA_PATH_MARK, name_withdirsep);
-
-  // we iterate over all paths (which are separated by a ";")
-  const char* const path_start = path_withmodname;
-  const char* const path_end = path_withmodname + SDL_strlen(path_withmodname);
-  const char* path_curpos = path_start;
-
-  while (path_curpos < path_end) {
-    const char* separator_pos = SDL_strchr(path_curpos, *sep);
-
-    // if there's no more separator in string, we set the separator to end
-    // of string
-    if (separator_pos == NULL) {
-      separator_pos = path_end;
+#define SMGF_MODULE_CACHE "smgf_module_cache"
+
+static Uint32 module_index_hash(const char* path) {
+  return smgf_hash_fnv1a(SMGF_FNV1A_INIT, path, SDL_strlen(path));
+}
+
+void smgf_module_index_clear(smgf* const c) {
+  smodule_index* const m = &c->module_index;
+  for (int i = 0; i < MODULE_INDEX_NB_BUCKETS; i++) {
+    smodule_index_entry* e = m->buckets[i];
+    while (e != NULL) {
+      smodule_index_entry* next = e->next;
+      SDL_free(e);
+      e = next;
     }
+    m->buckets[i] = NULL;
+  }
+  m->nb_files = 0;
+  m->built = false;
+  m->complete = false;
+}
+
+static PHYSFS_EnumerateCallbackResult
+module_index_add(void* data, const char* dir, const char* fname) {
+  smgf* const c = data;
+  smodule_index* const m = &c->module_index;
 
-    lua_pushlstring(L, path_curpos, separator_pos - path_curpos);
-    const char* p = lua_tostring(L, -1);
+  char path[MODULE_PATH_SIZE];
+  int len = *dir == '\0' || SDL_strcmp(dir, "/") == 0
+                ? SDL_snprintf(path, sizeof(path), "%s", fname)
+                : SDL_snprintf(path, sizeof(path), "%s/%s", dir, fname);
+  if (len < 0 || len >= (int) sizeof(path)) {
+    m->complete = false;
+    return PHYSFS_ENUM_STOP;
+  }
 
-    // note: physfs returns a PHYSFS_ERR_BAD_FILENAME error
-    // if filename starts with "./", so we skip the "." with "+ 1":
-    if (PHYSFS_exists(p + 1) != 0) {
-      lua_remove(L, -2); // remove strings generated by gsub
-      lua_remove(L, -3);
-      return p + 1;
+  // all the files of the merged tree are indexed, including the files of the
+  // write directory: they can hide a file of the game with the same path,
+  // which must still be found once they are deleted (see module_exists)
+  PHYSFS_Stat st;
+  if (!PHYSFS_stat(path, &st)) {
+    return PHYSFS_ENUM_OK;
+  }
+  if (st.filetype == PHYSFS_FILETYPE_DIRECTORY) {
+    if (SDL_strcmp(path, BYTECODE_CACHE_DIR) == 0) {
+      return PHYSFS_ENUM_OK;
     }
+    PHYSFS_enumerate(path, module_index_add, c);
+    return m->complete ? PHYSFS_ENUM_OK : PHYSFS_ENUM_STOP;
+  }
 
-    lua_pop(L, 1);
-    path_curpos = separator_pos + 1;
+  if (m->nb_files == MODULE_INDEX_MAX_FILES) {
+    m->complete = false;
+    return PHYSFS_ENUM_STOP;
+  }
+  smodule_index_entry* e = SDL_malloc(sizeof(smodule_index_entry) + len + 1);
+  if (e == NULL) {
+    m->complete = false;
+    return PHYSFS_ENUM_STOP;
+  }
+  SDL_memcpy(e->path, path, len + 1);
+  e->hash = module_index_hash(path);
+  e->next = m->buckets[e->hash % MODULE_INDEX_NB_BUCKETS];
+  m->buckets[e->hash % MODULE_INDEX_NB_BUCKETS] = e;
+  m->nb_files += 1;
+  return PHYSFS_ENUM_OK;
+}
+
+// lists the files of the search path (once per mount generation)
+static void module_index_build(smgf* const c) {
+  smodule_index* const m = &c->module_index;
+  smgf_module_index_clear(c);
+  m->complete = true;
+  if (PHYSFS_enumerate("/", module_index_add, c) == 0) {
+    m->complete = false;
+  }
+  if (!m->complete) {
+    SDL_LogInfoC("module index disabled (too many files)");
+    smgf_module_index_clear(c);
+  }
+  m->built = true;
+  m->mount_generation = c->mount_generation;
+}
+
+static bool module_exists(smgf* const c, const char* path) {
+  // files of the write directory come first in the search path
+  const char* write_dir = PHYSFS_getWriteDir();
+  if (write_dir != NULL) {
+    char real_path[MODULE_PATH_SIZE];
+    SDL_PathInfo info;
+    SDL_snprintf(real_path, sizeof(real_path), "%s%s", write_dir, path);
+    if (SDL_GetPathInfo(real_path, &info) &&
+        info.type == SDL_PATHTYPE_FILE) {
+      return true;
+    }
+  }
+
+  smodule_index* const m = &c->module_index;
+  if (!m->built || m->mount_generation != c->mount_generation) {
+    module_index_build(c);
+  }
+  if (!m->complete) {
+    return PHYSFS_exists(path) != 0;
+  }
+
+  // the index only rules out files: an indexed file may have been deleted
+  // from the write directory since the index was built
+  Uint32 hash = module_index_hash(path);
+  smodule_index_entry* e = m->buckets[hash % MODULE_INDEX_NB_BUCKETS];
+  for (; e != NULL; e = e->next) {
+    if (e->hash == hash && SDL_strcmp(e->path, path) == 0) {
+      return PHYSFS_exists(path) != 0;
+    }
+  }
+  return false;
+}
+
+// searches for a module name in a search path (usually package.path): each
+// tpl of the path (separated by "sep") has its "?" replaced by the module
+// name (with "." replaced by "dirsep"). The first file that exists is copied
+// in "file_name". Returns false if there is no such file.
+bool searchpath(
+    smgf* const c, const char* name, const char* path, char sep, char dirsep,
+    char* file_name, size_t size) {
+  const char* tpl = path;
+  while (*tpl != '\0') {
+    // note: physfs returns a PHYSFS_ERR_BAD_FILENAME error if filename
+    // starts with "./", so we skip it
+    if (tpl[0] == '.' && tpl[1] == '/') {
+      tpl += 2;
+    }
+    while (*tpl == '/') {
+      tpl += 1;
+    }
+
+    size_t len = 0;
+    bool too_long = false;
+    for (; *tpl != '\0' && *tpl != sep; tpl++) {
+      const char* part = tpl;
+      size_t part_len = 1;
+      if (*tpl == LUA_PATH_MARK[0]) {
+        part = name;
+        part_len = SDL_strlen(name);
+      }
+      if (len + part_len >= size) {
+        too_long = true;
+        continue;
+      }
+      for (size_t i = 0; i < part_len; i++) {
+        bool is_name = part == name;
+        file_name[len++] = is_name && part[i] == '.' ? dirsep : part[i];
+      }
+    }
+    file_name[len] = '\0';
+    if (*tpl == sep) {
+      tpl += 1;
+    }
+
+    if (len > 0 && !too_long && module_exists(c, file_name)) {
+      return true;
+    }
   }
 
-  lua_pop(L, 2); // remove strings generated by gsub
-  return NULL;
+  return false;
 }
 
-// custom smgf package.searcher that tries to load modules through physfs
+// custom smgf package.searcher that tries to load modules through physfs.
+// Resolved file names are cached in a table of the registry:
+// {[1] = package.path, [2] = mount generation, [module name] = file name}
 int l_smgf_searcher(lua_State* L) {
-  // smgf* const c = get_smgf(L);
+  smgf* const c = get_smgf(L);
   const char* mod_name = luaL_checkstring(L, 1);
 
   lua_getglobal(L, "package");
   lua_getfield(L, -1, "path");
   const char* packagepath = luaL_checkstring(L, -1);
+  int path_index = lua_gettop(L);
 
-  // finding a file matching the module name
-  const char* file_name =
-      searchpath(L, mod_name, packagepath, LUA_PATH_SEP, "/");
-
-  if (file_name == NULL) {
-    return luaL_error(
-        L, "module '%s' not found in smgf game folders.", mod_name);
+  lua_getfield(L, LUA_REGISTRYINDEX, SMGF_MODULE_CACHE);
+  bool valid = false;
+  if (lua_istable(L, -1)) {
+    lua_rawgeti(L, -1, 1);
+    lua_rawgeti(L, -2, 2);
+    valid = lua_rawequal(L, -2, path_index) &&
+            lua_tointeger(L, -1) == c->mount_generation;
+    lua_pop(L, 2);
+  }
+  if (!valid) {
+    lua_pop(L, 1);
+    lua_newtable(L);
+    lua_pushvalue(L, path_index);
+    lua_rawseti(L, -2, 1);
+    lua_pushinteger(L, c->mount_generation);
+    lua_rawseti(L, -2, 2);
+    lua_pushvalue(L, -1);
+    lua_setfield(L, LUA_REGISTRYINDEX, SMGF_MODULE_CACHE);
   }
+  int cache_index = lua_gettop(L);
 
-  // loading file
-  PHYSFS_file* file = PHYSFS_openRead(file_name);
+  // finding a file matching the module name
+  lua_getfield(L, cache_index, mod_name);
+  const char* file_name = lua_tostring(L, -1);
+  if (file_name == NULL) {
+    char found[MODULE_PATH_SIZE];
+    if (!searchpath(
+            c, mod_name, packagepath, LUA_PATH_SEP[0], '/', found,
+            sizeof(found))) {
+      return luaL_error(
+          L, "module '%s' not found in smgf game folders.", mod_name);
+    }
 
-  if (file == NULL) {
-    int error_code = PHYSFS_getLastErrorCode();
-    return luaL_error(
-        L, "error opening file '%s': %s (%d)", file_name,
-        PHYSFS_getErrorByCode(error_code), error_code);
+    lua_pop(L, 1);
+    lua_pushstring(L, found);
+    lua_pushvalue(L, -1);
+    lua_setfield(L, cache_index, mod_name);
+    file_name = lua_tostring(L, -1);
   }
 
-  int file_len = PHYSFS_fileLength(file);
-
-  char* file_contents = SDL_calloc(file_len, sizeof(char));
-  if (PHYSFS_readBytes(file, file_contents, file_len) != file_len) {
-    int error_code = PHYSFS_getLastErrorCode();
+  // loading file (or its cached bytecode)
+  sf_sy_trace_begin(c, file_name);
+  if (smgf_loadfile(L, file_name, mod_name) != LUA_OK) {
+    sf_sy_trace_end(c);
     return luaL_error(
-        L, "error reading file '%s': %s (%d)", file_name,
-        PHYSFS_getErrorByCode(error_code), error_code);
+        L, "error loading module '%s' from file '%s':\n\t%s", mod_name,
+        file_name, lua_tostring(L, -1));
   }
-
-  // loading Lua string
-  luaL_loadbuffer(L, file_contents, file_len, mod_name);
   lua_pushstring(L, mod_name);
-
-  SDL_free(file_contents);
-  PHYSFS_close(file);
+  sf_sy_trace_end(c);
 
   return 2;
 }
 
+const char* const smgf_type_names[SMGF_NB_TYPES] = {
+    [SMGF_TYPE_TEXTURE] = "smgf.texture", [SMGF_TYPE_SOUND] = "smgf.sound",
+    [SMGF_TYPE_FILE] = "smgf.file",       [SMGF_TYPE_BATCH] = "smgf.batch",
+    [SMGF_TYPE_MESH] = "smgf.mesh",       [SMGF_TYPE_TILEMAP] = "smgf.tilemap",
+    [SMGF_TYPE_TEXT] = "smgf.text",       [SMGF_TYPE_BUFFER] = "smgf.buffer",
+};
+
+// creates the metatable of a type (pushed on the stack), and keeps its
+// address and a reference to it in the smgf instance
+void l_newmetatable(lua_State* L, smgf_type type) {
+  smgf* const c = get_smgf(L);
+  luaL_newmetatable(L, smgf_type_names[type]);
+  c->metatables[type] = lua_topointer(L, -1);
+  lua_pushvalue(L, -1);
+  c->metatable_refs[type] = luaL_ref(L, LUA_REGISTRYINDEX);
+}
+
 // initialises a Lua state for smgf use
 void lua_api_init(smgf* const c) {
-  // store a pointer to smgf struct in Lua registry
-  lua_pushstring(c->L, SMGF_PTRNAME);
-  lua_pushlightuserdata(c->L, (void*) c);
-  lua_settable(c->L, LUA_REGISTRYINDEX);
+  // store a pointer to smgf struct in the extra space of the Lua state
+  *(smgf**) lua_getextraspace(c->L) = c;
 
   // open standard libs
   luaL_openlibs(c->L);
@@ -188,11 +342,20 @@ void lua_api_init(smgf* const c) {
 
   // add modules to smgf table
   init_audio(c->L);
+  init_buffer(c->L);
   init_graphics(c->L);
   init_input(c->L);
   init_io(c->L);
   init_system(c->L);
 
+  // watch the callbacks assigned to the smgf table
+  c->callbacks.table_ref = LUA_NOREF;
+  c->callbacks.metatable_ref = LUA_NOREF;
+  for (int i = 0; i < SMGF_NB_CALLBACKS; i++) {
+    c->callbacks.refs[i] = LUA_NOREF;
+  }
+  smgf_callbacks_watch(c);
+
   // set smgf table global
   lua_setglobal(c->L, "smgf");
 }
@@ -3,17 +3,46 @@
 
 #include "api.h"
 
-#define SMGF_TYPE_TEXTURE "smgf.texture"
-#define SMGF_TYPE_SOUND "smgf.sound"
-#define SMGF_TYPE_FILE "smgf.file"
+extern const char* const smgf_type_names[SMGF_NB_TYPES];
 
-const char* searchpath(
-    lua_State* L, const char* name, const char* path, const char* sep,
-    const char* dirsep);
+void l_newmetatable(lua_State* L, smgf_type type);
+
+// pushes the metatable of a type
+static inline void l_getmetatable(lua_State* L, smgf_type type) {
+  lua_rawgeti(L, LUA_REGISTRYINDEX, get_smgf(L)->metatable_refs[type]);
+}
+
+// returns the userdata at index "arg" if it has the metatable of "type", or
+// NULL. Metatables are compared by address, instead of being looked up by name
+// as in luaL_testudata.
+static inline void* l_testudata(lua_State* L, int arg, smgf_type type) {
+  void* p = lua_touserdata(L, arg);
+  if (p == NULL || !lua_getmetatable(L, arg)) {
+    return NULL;
+  }
+  const void* mt = lua_topointer(L, -1);
+  lua_pop(L, 1);
+  return mt == get_smgf(L)->metatables[type] ? p : NULL;
+}
+
+static inline void* l_checkudata(lua_State* L, int arg, smgf_type type) {
+  void* p = l_testudata(L, arg, type);
+  if (p == NULL) {
+    luaL_typeerror(L, arg, smgf_type_names[type]);
+  }
+  return p;
+}
+
+sbuffer* l_newbuffer(lua_State* L);
+
+bool searchpath(
+    smgf* const c, const char* name, const char* path, char sep, char dirsep,
+    char* file_name, size_t size);
 int l_smgf_searcher(lua_State* L);
 // void luaapi_init(smgf* const c);
 
 void init_audio(lua_State* L);
+void init_buffer(lua_State* L);
 void init_graphics(lua_State* L);
 void init_input(lua_State* L);
 void init_io(lua_State* L);
@@ -14,22 +14,34 @@
 #include <physfs.h>
 
 #include "smgf.h"
+#include "api.h"
 
 #include "SDL_DBGP_unscii16.h"
 
-#if !SDL_VERSION_ATLEAST(3, 1, 5)
-#error SMGF requires SDL 3.1.5 or later.
+#if !SDL_VERSION_ATLEAST(3, 2, 0)
+#error SMGF requires SDL 3.2.0 or later.
 #endif
 
-// main loop variables
-static int start_time = 0;
-static int end_time = 0;
-static int dt = 0;
+// main loop variables (times in nanoseconds)
+static Uint64 start_time = 0;
+static Uint64 end_time = 0;
+static Uint64 dt = 0;
 static SDL_FRect dst_rect = {0};
 static smgf c;
 static char* bundled_game_path = NULL;
 static const char* dropped_path = NULL;
 static SDL_IOStream* log_file = NULL;
+// headless mode ("--headless"), and nb of frames to run ("--frames N", 0 =
+// no limit)
+static bool headless = false;
+static int max_frames = 0;
+static int nb_frames = 0;
+static Uint64 headless_start_time = 0;
+// Chrome trace file written at exit ("--trace FILE", in the write directory)
+static const char* trace_filename = NULL;
+// "--preload" and "--read-ahead", which override conf.lua
+static bool preload = false;
+static bool read_ahead = false;
 
 /** returns file path if a file has been dropped, or NULL. Used for startup.
  * Returned value must be freed by user.
@@ -81,6 +93,66 @@ SDL_AppResult SDL_AppInit(void** appstate, int argc, char** argv) {
 
   SDL_Log("SMGF v%s (%s)", SMGF_VERSION, SDL_GetPlatform());
 
+  // options must be read before SDL init, as they change the drivers used
+  char* arg_path = NULL;
+  for (int i = 1; i < argc; i++) {
+    if (SDL_strcmp(argv[i], "--headless") == 0) {
+      headless = true;
+      continue;
+    }
+
+    if (SDL_strcmp(argv[i], "--frames") == 0) {
+      char* end = NULL;
+      if (i + 1 < argc) {
+        max_frames = SDL_strtol(argv[i + 1], &end, 10);
+      }
+      if (end == NULL || *end != '\0' || max_frames <= 0) {
+        SDL_LogErrorC("--frames expects a number of frames > 0");
+        return SDL_APP_FAILURE;
+      }
+      i += 1;
+      continue;
+    }
+
+    if (SDL_strcmp(argv[i], "--preload") == 0) {
+      preload = true;
+      continue;
+    }
+
+    if (SDL_strcmp(argv[i], "--read-ahead") == 0) {
+      read_ahead = true;
+      continue;
+    }
+
+    if (SDL_strcmp(argv[i], "--trace") == 0) {
+      if (i + 1 >= argc) {
+        SDL_LogErrorC("--trace expects a file name");
+        return SDL_APP_FAILURE;
+      }
+      trace_filename = argv[i + 1];
+      i += 1;
+      continue;
+    }
+
+    // we ignore "-psn" arguments from macOS Finder
+    // https://github.com/libsdl-org/SDL/blob/9130f7c377c34cc4a2742202bb42d9332b7d8d7e/test/testdropfile.c#L47
+    if (SDL_strcmp(SDL_GetPlatform(), "macOS") == 0 &&
+        SDL_strncmp(argv[i], "-psn", 4) == 0) {
+      continue;
+    }
+
+    if (arg_path == NULL) {
+      arg_path = argv[i];
+    }
+  }
+
+  if (headless) {
+    // no display and no audio device needed: the window is created
+    // offscreen, and the mixer is not bound to a playback device
+    SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "offscreen");
+    SDL_SetHint(SDL_HINT_AUDIO_DRIVER, "dummy");
+  }
+
   // SDL init
   Uint32 flags = SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_GAMEPAD;
   if (!SDL_Init(flags)) {
@@ -102,14 +174,14 @@ SDL_AppResult SDL_AppInit(void** appstate, int argc, char** argv) {
       SDL_VERSIONNUM_MINOR(compiled), SDL_VERSIONNUM_MICRO(compiled),
       SDL_REVISION);
 
-  if (linked < SDL_VERSIONNUM(3, 1, 5)) {
-    SDL_LogErrorC("SMGF requires SDL 3.1.5 or later.");
+  if (linked < SDL_VERSIONNUM(3, 2, 0)) {
+    SDL_LogErrorC("SMGF requires SDL 3.2.0 or later.");
     return SDL_APP_FAILURE;
   }
 
   SDL_Log("using %s", LUA_RELEASE);
 
-  SDL_SetHint(SDL_HINT_RENDER_VSYNC, "1");
+  SDL_SetHint(SDL_HINT_RENDER_VSYNC, headless ? "0" : "1");
   // SDL_SetHint(SDL_HINT_RENDER_DRIVER, "gpu");
 
   if (SDL_strcmp(SDL_GetPlatform(), "macOS") == 0) {
@@ -158,19 +230,6 @@ SDL_AppResult SDL_AppInit(void** appstate, int argc, char** argv) {
       bundled_game_path, bundled_game_path_len, "%s%s", base_path,
       SMGF_AUTOLOAD_FILE);
 
-  char* arg_path = NULL;
-  for (int i = 1; i < argc; i++) {
-    // we ignore "-psn" arguments from macOS Finder
-    // https://github.com/libsdl-org/SDL/blob/9130f7c377c34cc4a2742202bb42d9332b7d8d7e/test/testdropfile.c#L47
-    if (SDL_strcmp(SDL_GetPlatform(), "macOS") == 0 &&
-        SDL_strncmp(argv[i], "-psn", 4) == 0) {
-      continue;
-    }
-
-    arg_path = argv[i];
-    break;
-  }
-
   // handle files dropped on app on launch
   SDL_PumpEvents();
   dropped_path = startup_get_dropped_file();
@@ -192,6 +251,9 @@ SDL_AppResult SDL_AppInit(void** appstate, int argc, char** argv) {
   }
 
   // smgf init (opens conf.lua file)
+  c.headless = headless;
+  c.force_preload = preload;
+  c.force_read_ahead = read_ahead;
   if (smgf_init(&c, game_path) != 0) {
     return SDL_APP_FAILURE;
   }
@@ -207,23 +269,97 @@ SDL_AppResult SDL_AppInit(void** appstate, int argc, char** argv) {
   SDL_GetRenderVSync(c.renderer, &vsync);
   SDL_Log("using \"%s\" video renderer (vsync: %d)", renderer_name, vsync);
 
+  if (trace_filename != NULL && sf_sy_trace_start(&c)) {
+    SDL_LogErrorC("cannot start trace (%s)", SDL_GetError());
+  }
+
+  smgf_callbacks_check(&c);
   smgf_linit(&c);
-  SDL_RaiseWindow(c.window);
+  if (headless) {
+    headless_start_time = SDL_GetTicksNS();
+  } else {
+    SDL_RaiseWindow(c.window);
+  }
+  end_time = SDL_GetTicksNS();
 
   return SDL_APP_CONTINUE;
 }
 
 SDL_AppResult SDL_AppIterate(void* appstate) {
-  start_time = SDL_GetTicks();
+  start_time = SDL_GetTicksNS();
   dt = start_time - end_time;
+  c.stats.frame_time = dt;
+
+  // the smgf global may have been replaced by the game
+  smgf_callbacks_check(&c);
+  smgf_events_flush(&c);
+  smgf_async_flush(&c);
+
+  double frame_dt = (double) dt / SDL_NS_PER_SECOND;
+  if (headless) {
+    // fixed dt, so that headless runs are reproducible
+    frame_dt = c.fps > 0 ? 1.0 / c.fps : 1.0 / 60;
+  }
 
-  // update
-  c.dt = dt / 1000.f;
-  smgf_lupdate(&c);
+  // update: once per frame, or at a fixed rate. In the latter case, "alpha"
+  // is the fraction of an update step that remains to be simulated, used by
+  // the game to interpolate between the last two updates when drawing.
+  sf_sy_trace_begin(&c, "update");
+  Uint64 time = SDL_GetTicksNS();
+  double alpha = 1;
+  if (c.update_rate > 0) {
+    const double step = 1.0 / c.update_rate;
+    c.dt = step;
+    c.update_accumulator += frame_dt;
+    int nb_updates = 0;
+    while (c.update_accumulator >= step && c.update_rate > 0 &&
+           !c.should_quit) {
+      if (nb_updates == MAX_UPDATES_PER_FRAME) {
+        // too late: the remaining steps are dropped
+        c.update_accumulator = SDL_fmod(c.update_accumulator, step);
+        break;
+      }
+      smgf_lupdate(&c);
+      c.update_accumulator -= step;
+      nb_updates += 1;
+    }
+    alpha = c.update_rate > 0 ? c.update_accumulator / step : 1;
+  } else {
+    c.dt = frame_dt;
+    smgf_lupdate(&c);
+  }
+  c.stats.update_time = SDL_GetTicksNS() - time;
+  sf_sy_trace_end(&c);
 
   // draw
-  SDL_SetRenderTarget(c.renderer, c.screen_texture->tex);
-  smgf_ldraw(&c);
+  sf_sy_trace_begin(&c, "draw");
+  time = SDL_GetTicksNS();
+  sf_gr_set_target(&c, NULL);
+  smgf_ldraw(&c, alpha);
+  c.stats.draw_time = SDL_GetTicksNS() - time;
+  sf_sy_trace_end(&c);
+
+  // garbage collection, in the time left before the next frame. It runs
+  // before presenting, as with vsync the present waits for the next frame
+  // (headless runs have no deadline, the whole budget is used)
+  if (c.conf.gc_budget > 0) {
+    Uint64 period = c.fps > 0 ? SDL_NS_PER_SECOND / c.fps : c.stats.frame_time;
+    Uint64 elapsed = SDL_GetTicksNS() - start_time;
+    Uint64 budget = c.conf.gc_budget * SDL_NS_PER_SECOND;
+    if (!headless) {
+      budget = elapsed < period ? SDL_min(budget, period - elapsed) : 0;
+    }
+    sf_sy_trace_begin(&c, "gc");
+    smgf_heap_collect(&c, budget);
+    sf_sy_trace_end(&c);
+  }
+
+  // not measured, so that the overlay does not change what it shows
+  if (c.overlay.visible) {
+    smgf_draw_overlay(&c);
+  }
+  sf_sy_trace_begin(&c, "present");
+  time = SDL_GetTicksNS();
 
   // clearing the renderer
   SDL_SetRenderTarget(c.renderer, NULL);
@@ -233,13 +369,22 @@ SDL_AppResult SDL_AppIterate(void* appstate) {
   // drawing texture on renderer
   SDL_RenderTexture(c.renderer, c.screen_texture->tex, NULL, &dst_rect);
   SDL_RenderPresent(c.renderer);
-
-  // wait a little bit before next frame if needed
-  if (c.fps > 0) {
-    const int frame_rate = 1000.f / c.fps;
-    int frame_time = SDL_GetTicks() - start_time;
-    if (frame_time < frame_rate) {
-      SDL_Delay(frame_rate - frame_time);
+  // the renderer state was modified above without the sf_gr_* functions
+  sf_gr_invalidate_state(&c);
+  c.stats.present_time = SDL_GetTicksNS() - time;
+  sf_sy_trace_end(&c);
+
+  c.stats.nb_draw_calls += 1;
+  sf_sy_end_frame_stats(&c);
+
+  // wait a little bit before next frame if needed (headless runs as fast as
+  // possible)
+  if (c.fps > 0 && !headless) {
+    const Uint64 frame_duration = SDL_NS_PER_SECOND / c.fps;
+    Uint64 frame_time = SDL_GetTicksNS() - start_time;
+    if (frame_time < frame_duration) {
+      // sleeps, then spins for the last part of the delay
+      SDL_DelayPrecise(frame_duration - frame_time);
     }
   }
 
@@ -255,10 +400,19 @@ SDL_AppResult SDL_AppIterate(void* appstate) {
   // printf(">> %s\n", lua_type(c.L, 1) == LUA_TNONE ? "none" : "something");
   // printf(">> %d elements on the stack\n", lua_gettop(c.L));
 
+  nb_frames += 1;
+  if (c.should_quit) {
+    return c.has_error ? SDL_APP_FAILURE : SDL_APP_SUCCESS;
+  }
+  if (max_frames > 0 && nb_frames >= max_frames) {
+    return SDL_APP_SUCCESS;
+  }
+
   return SDL_APP_CONTINUE;
 }
 
 SDL_AppResult SDL_AppEvent(void* appstate, SDL_Event* e) {
+  sf_sy_trace_begin(&c, "event");
   switch (e->type) {
 
   case SDL_EVENT_QUIT: c.should_quit = true; break;
@@ -279,6 +433,9 @@ SDL_AppResult SDL_AppEvent(void* appstate, SDL_Event* e) {
     if (e->key.repeat != 0) {
       break;
     }
+    if (e->key.key == SDLK_F3) {
+      c.overlay.visible = !c.overlay.visible;
+    }
     smgf_lkey_down(&c, &e->key);
     break;
 
@@ -341,6 +498,7 @@ SDL_AppResult SDL_AppEvent(void* appstate, SDL_Event* e) {
   case SDL_EVENT_RENDER_TARGETS_RESET: {
     // the render targets have been reset and their contents need to be
     // updated (>= SDL 2.0.2)
+    c.render_generation += 1;
     DBGP_DestroyFont(&c.font);
     if (!DBGP_CreateFont(
             &c.font, c.renderer, DBGP_UNSCII16, sizeof(DBGP_UNSCII16),
@@ -354,6 +512,8 @@ SDL_AppResult SDL_AppEvent(void* appstate, SDL_Event* e) {
   case SDL_EVENT_RENDER_DEVICE_RESET: {
     // the device has been reset and all textures need to be recreated (>=
     // SDL 2.0.4)
+    sf_gr_invalidate_state(&c);
+    c.render_generation += 1;
     DBGP_DestroyFont(&c.font);
     if (!DBGP_CreateFont(
             &c.font, c.renderer, DBGP_UNSCII16, sizeof(DBGP_UNSCII16),
@@ -364,15 +524,31 @@ SDL_AppResult SDL_AppEvent(void* appstate, SDL_Event* e) {
     smgf_ldevice_reset(&c);
   } break;
   }
+  sf_sy_trace_end(&c);
 
   if (c.should_quit) {
-    return SDL_APP_SUCCESS;
+    return c.has_error ? SDL_APP_FAILURE : SDL_APP_SUCCESS;
   }
 
   return SDL_APP_CONTINUE;
 }
 
 void SDL_AppQuit(void* appstate, SDL_AppResult result) {
+  if (headless && headless_start_time != 0) {
+    double seconds = (SDL_GetTicksNS() - headless_start_time) / 1e9;
+    SDL_Log(
+        "ran %d frames in %.3fs (%.1f frames per second)", nb_frames, seconds,
+        seconds > 0 ? nb_frames / seconds : 0);
+  }
+
+  if (trace_filename != NULL && SDL_GetAtomicInt(&c.trace.enabled)) {
+    if (sf_sy_trace_stop(&c, trace_filename)) {
+      SDL_LogErrorC("cannot save trace (%s)", SDL_GetError());
+    } else {
+      SDL_Log("trace saved to \"%s\"", trace_filename);
+    }
+  }
+
   smgf_quit(&c);
   PHYSFS_deinit();
   SDL_free(bundled_game_path);
@@ -3,15 +3,6 @@
 #include "smgf.h"
 #include "api.h"
 
-// returns smgf instance from the user data stored in Lua registry
-smgf* get_smgf(lua_State* L) {
-  lua_pushstring(L, SMGF_PTRNAME);
-  lua_gettable(L, LUA_REGISTRYINDEX);
-  smgf* const f = lua_touserdata(L, -1);
-  lua_pop(L, 1);
-  return f;
-}
-
 // custom Lua error handler that pushes the traceback of the error
 // on top of the stack
 static int smgf_error_handler(lua_State* L) {
@@ -21,17 +12,29 @@ static int smgf_error_handler(lua_State* L) {
   return 1;
 }
 
-// from Lua 5.4 source (lua.c, function "docall"):
+// from Lua 5.4 source (lua.c, function "docall"). The Lua state of the game
+// keeps the error handler at the bottom of its stack, so that it is not pushed
+// for each call.
 int smgf_pcall(lua_State* L, int narg, int nres) {
   int base = lua_gettop(L) - narg;
-  lua_pushcfunction(L, smgf_error_handler);
-  lua_insert(L, base);
-  int status = lua_pcall(L, narg, nres, base);
-  lua_remove(L, base);
+  bool persistent_handler = lua_tocfunction(L, 1) == smgf_error_handler;
+  if (!persistent_handler) {
+    lua_pushcfunction(L, smgf_error_handler);
+    lua_insert(L, base);
+  }
+  int status = lua_pcall(L, narg, nres, persistent_handler ? 1 : base);
+  if (!persistent_handler) {
+    lua_remove(L, base);
+  }
+
+  // note: the Lua state used to read conf.lua has no smgf instance
+  smgf* const c = get_smgf(L);
+  if (c != NULL) {
+    c->stats.nb_pcalls += 1;
+  }
 
   // if an error happened, we raise the error to smgf
   if (status != LUA_OK) {
-    smgf* const c = get_smgf(L);
     smgf_set_error(c, "%s", lua_tostring(L, -1));
   }
 
@@ -84,6 +87,199 @@ static inline char* PHYSFS_readToBuffer(const char* filename) {
   return file_contents;
 }
 
+// bytecode cache: chunks compiled from source are dumped in the write
+// directory, and loaded from there as long as the source file keeps the same
+// size and contents (its modification time only has a one second
+// resolution). Entries whose source file no longer exists are deleted when
+// the game starts.
+#define BYTECODE_CACHE_MAGIC "SMGFLUA2"
+
+typedef struct sbytecode_header {
+  char magic[8];
+  Uint32 lua_version;
+  Uint32 path_len; // the path of the source file follows the header
+  Sint64 size; // of the source file
+  Uint32 hash; // FNV-1a of the contents of the source file
+  Uint32 padding;
+} sbytecode_header;
+
+static void bytecode_cache_path(const char* filename, char* path, size_t n) {
+  Uint32 hash =
+      smgf_hash_fnv1a(SMGF_FNV1A_INIT, filename, SDL_strlen(filename));
+  SDL_snprintf(path, n, "%s/%08x.luac", BYTECODE_CACHE_DIR, (unsigned) hash);
+}
+
+static void bytecode_cache_header(
+    sbytecode_header* h, const char* filename, Sint64 size, Uint32 hash) {
+  SDL_zerop(h);
+  SDL_memcpy(h->magic, BYTECODE_CACHE_MAGIC, sizeof(h->magic));
+  h->lua_version = LUA_VERSION_NUM;
+  h->path_len = SDL_strlen(filename);
+  h->size = size;
+  h->hash = hash;
+}
+
+// loads a chunk from the cache. Returns false if there is no valid cached
+// chunk for this file.
+static bool bytecode_cache_load(
+    lua_State* L, const char* filename, const char* chunkname, Sint64 size,
+    Uint32 hash) {
+  char path[64];
+  bytecode_cache_path(filename, path, sizeof(path));
+  if (!PHYSFS_exists(path)) {
+    return false;
+  }
+
+  PHYSFS_file* file = PHYSFS_openRead(path);
+  if (file == NULL) {
+    return false;
+  }
+  int len = PHYSFS_fileLength(file);
+  char* contents = PHYSFS_load(file);
+  PHYSFS_close(file);
+  if (contents == NULL) {
+    return false;
+  }
+
+  sbytecode_header expected, h;
+  bytecode_cache_header(&expected, filename, size, hash);
+  size_t offset = sizeof(h) + expected.path_len;
+  bool ok = false;
+  if (len > (int) offset) {
+    SDL_memcpy(&h, contents, sizeof(h));
+    ok = SDL_memcmp(&h, &expected, sizeof(h)) == 0 &&
+         SDL_memcmp(contents + sizeof(h), filename, h.path_len) == 0;
+  }
+
+  if (ok && luaL_loadbufferx(
+                L, contents + offset, len - offset, chunkname, "b") != LUA_OK) {
+    lua_pop(L, 1);
+    ok = false;
+  }
+
+  SDL_free(contents);
+  return ok;
+}
+
+static int bytecode_cache_writer(
+    lua_State* L, const void* p, size_t sz, void* ud) {
+  if (p == NULL || sz == 0) {
+    return 0;
+  }
+  return PHYSFS_writeBytes(ud, p, sz) == (PHYSFS_sint64) sz ? 0 : 1;
+}
+
+// dumps the chunk on top of the stack in the cache
+static void bytecode_cache_save(
+    lua_State* L, const char* filename, Sint64 size, Uint32 hash) {
+  char path[64];
+  bytecode_cache_path(filename, path, sizeof(path));
+  if (!PHYSFS_mkdir(BYTECODE_CACHE_DIR)) {
+    return;
+  }
+
+  PHYSFS_file* file = PHYSFS_openWrite(path);
+  if (file == NULL) {
+    return;
+  }
+
+  sbytecode_header h;
+  bytecode_cache_header(&h, filename, size, hash);
+  bool ok = PHYSFS_writeBytes(file, &h, sizeof(h)) == sizeof(h) &&
+            PHYSFS_writeBytes(file, filename, h.path_len) == h.path_len &&
+            lua_dump(L, bytecode_cache_writer, file, 0) == 0;
+  ok = PHYSFS_close(file) && ok;
+  if (!ok) {
+    PHYSFS_delete(path);
+  }
+}
+
+// returns true if a cache entry is valid and its source file still exists
+static bool bytecode_cache_is_used(const char* path) {
+  PHYSFS_file* file = PHYSFS_openRead(path);
+  if (file == NULL) {
+    return true; // left as it is
+  }
+
+  sbytecode_header h;
+  char source[1024];
+  bool used = PHYSFS_readBytes(file, &h, sizeof(h)) == sizeof(h) &&
+              SDL_memcmp(h.magic, BYTECODE_CACHE_MAGIC, sizeof(h.magic)) == 0 &&
+              h.lua_version == LUA_VERSION_NUM && h.path_len < sizeof(source) &&
+              PHYSFS_readBytes(file, source, h.path_len) == h.path_len;
+  PHYSFS_close(file);
+  if (used) {
+    source[h.path_len] = '\0';
+    used = PHYSFS_exists(source);
+  }
+  return used;
+}
+
+// deletes the entries of the cache whose source file no longer exists (e.g.
+// renamed or deleted modules), or which were written by another version
+static void bytecode_cache_prune(void) {
+  if (PHYSFS_getWriteDir() == NULL) {
+    return;
+  }
+  char** names = PHYSFS_enumerateFiles(BYTECODE_CACHE_DIR);
+  if (names == NULL) {
+    return;
+  }
+
+  int nb_deleted = 0;
+  for (char** name = names; *name != NULL; name++) {
+    char path[64];
+    SDL_snprintf(path, sizeof(path), "%s/%s", BYTECODE_CACHE_DIR, *name);
+    if (!bytecode_cache_is_used(path) && PHYSFS_delete(path)) {
+      nb_deleted += 1;
+    }
+  }
+  PHYSFS_freeList(names);
+
+  if (nb_deleted > 0) {
+    SDL_Log("deleted %d unused bytecode cache entries", nb_deleted);
+  }
+}
+
+// loads a Lua file as a chunk, and pushes it on the stack (or pushes the
+// error message). Files may contain bytecode (e.g. precompiled games). When
+// a write directory is set, compiled chunks are cached in it.
+int smgf_loadfile(lua_State* L, const char* filename, const char* chunkname) {
+  PHYSFS_file* file = PHYSFS_openRead(filename);
+  if (file == NULL) {
+    lua_pushfstring(
+        L, "cannot open %s (%s)", filename,
+        PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode()));
+    return LUA_ERRFILE;
+  }
+  int len = PHYSFS_fileLength(file);
+  char* contents = PHYSFS_load(file);
+  PHYSFS_close(file);
+  if (contents == NULL) {
+    lua_pushfstring(
+        L, "cannot read %s (%s)", filename,
+        PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode()));
+    return LUA_ERRFILE;
+  }
+
+  // the contents are hashed to check the cache, which saves the compilation
+  bool is_bytecode = len > 0 && contents[0] == LUA_SIGNATURE[0];
+  bool use_cache = PHYSFS_getWriteDir() != NULL && !is_bytecode;
+  Uint32 hash = use_cache ? smgf_hash_fnv1a(SMGF_FNV1A_INIT, contents, len) : 0;
+  if (use_cache && bytecode_cache_load(L, filename, chunkname, len, hash)) {
+    SDL_free(contents);
+    return LUA_OK;
+  }
+
+  int status = luaL_loadbuffer(L, contents, len, chunkname);
+  SDL_free(contents);
+
+  if (status == LUA_OK && use_cache) {
+    bytecode_cache_save(L, filename, len, hash);
+  }
+  return status;
+}
+
 // Copies a string. The pointer returned must be freed by user.
 const char* smgf_strcpy(const char* str) {
   int len = SDL_strlen(str) + 1;
@@ -95,6 +291,16 @@ const char* smgf_strcpy(const char* str) {
   return copy;
 }
 
+// FNV-1a hash of some data, continuing "hash" (SMGF_FNV1A_INIT for a new
+// hash). Used by the hash tables and caches of the engine.
+Uint32 smgf_hash_fnv1a(Uint32 hash, const void* data, size_t size) {
+  const Uint8* p = (const Uint8*) data;
+  for (size_t i = 0; i < size; i++) {
+    hash = (hash ^ p[i]) * 16777619u;
+  }
+  return hash;
+}
+
 // loads a smgf config file in a separated Lua state. If the file does not
 // exists, sets the values to smgf defaults
 static int load_config(smgf* c, const char* conf_file_name) {
@@ -104,8 +310,17 @@ static int load_config(smgf* c, const char* conf_file_name) {
   c->conf.width = WIDTH_DEFAULT;
   c->conf.height = HEIGHT_DEFAULT;
   c->conf.fps = FPS_DEFAULT;
+  c->conf.update_rate = UPDATE_RATE_DEFAULT;
   c->conf.zoom = ZOOM_DEFAULT;
   c->conf.cursor_visible = CURSOR_VISIBLE_DEFAULT;
+  c->conf.stats_overlay = STATS_OVERLAY_DEFAULT;
+  c->conf.lua_pool_allocator = LUA_POOL_ALLOCATOR_DEFAULT;
+  c->conf.gc_generational = GC_GENERATIONAL_DEFAULT;
+  c->conf.gc_pause = GC_PARAM_DEFAULT;
+  c->conf.gc_stepmul = GC_PARAM_DEFAULT;
+  c->conf.gc_budget = GC_BUDGET_DEFAULT;
+  c->conf.preload = PRELOAD_DEFAULT;
+  c->conf.read_ahead = READ_AHEAD_DEFAULT;
 
   if (!PHYSFS_exists(conf_file_name)) {
     SDL_LogInfoC("cannot find %s, skipping...", conf_file_name);
@@ -113,6 +328,7 @@ static int load_config(smgf* c, const char* conf_file_name) {
   }
 
   lua_State* L = luaL_newstate();
+  *(smgf**) lua_getextraspace(L) = NULL; // see get_smgf
 
   char* buffer = PHYSFS_readToBuffer(conf_file_name);
   if (buffer == NULL) {
@@ -163,6 +379,15 @@ static int load_config(smgf* c, const char* conf_file_name) {
   }
   lua_pop(L, 1);
 
+  if (lua_getfield(L, -1, "update_rate") == LUA_TNUMBER) {
+    c->conf.update_rate = lua_tonumber(L, -1);
+    if (c->conf.update_rate < 0) {
+      smgf_set_error(c, "update_rate in conf.lua must be >= 0");
+      return 1;
+    }
+  }
+  lua_pop(L, 1);
+
   if (lua_getfield(L, -1, "zoom") == LUA_TNUMBER) {
     c->conf.zoom = lua_tonumber(L, -1);
     if (c->conf.zoom < 1) {
@@ -177,6 +402,77 @@ static int load_config(smgf* c, const char* conf_file_name) {
   }
   lua_pop(L, 1);
 
+  if (lua_getfield(L, -1, "stats_overlay") == LUA_TBOOLEAN) {
+    c->conf.stats_overlay = lua_toboolean(L, -1);
+  }
+  lua_pop(L, 1);
+
+  if (lua_getfield(L, -1, "lua_allocator") == LUA_TSTRING) {
+    const char* str = lua_tostring(L, -1);
+    if (SDL_strcmp(str, "pool") == 0) {
+      c->conf.lua_pool_allocator = true;
+    } else if (SDL_strcmp(str, "system") == 0) {
+      c->conf.lua_pool_allocator = false;
+    } else {
+      smgf_set_error(
+          c, "lua_allocator in conf.lua must be \"pool\" or \"system\"");
+      return 1;
+    }
+  }
+  lua_pop(L, 1);
+
+  if (lua_getfield(L, -1, "gc_mode") == LUA_TSTRING) {
+    const char* str = lua_tostring(L, -1);
+    if (SDL_strcmp(str, "incremental") == 0) {
+      c->conf.gc_generational = false;
+    } else if (SDL_strcmp(str, "generational") == 0) {
+      c->conf.gc_generational = true;
+    } else {
+      smgf_set_error(
+          c, "gc_mode in conf.lua must be \"incremental\" or "
+             "\"generational\"");
+      return 1;
+    }
+  }
+  lua_pop(L, 1);
+
+  if (lua_getfield(L, -1, "gc_pause") == LUA_TNUMBER) {
+    c->conf.gc_pause = lua_tonumber(L, -1);
+    if (c->conf.gc_pause < 0) {
+      smgf_set_error(c, "gc_pause in conf.lua must be >= 0");
+      return 1;
+    }
+  }
+  lua_pop(L, 1);
+
+  if (lua_getfield(L, -1, "gc_stepmul") == LUA_TNUMBER) {
+    c->conf.gc_stepmul = lua_tonumber(L, -1);
+    if (c->conf.gc_stepmul < 0) {
+      smgf_set_error(c, "gc_stepmul in conf.lua must be >= 0");
+      return 1;
+    }
+  }
+  lua_pop(L, 1);
+
+  if (lua_getfield(L, -1, "gc_budget") == LUA_TNUMBER) {
+    c->conf.gc_budget = lua_tonumber(L, -1);
+    if (c->conf.gc_budget < 0) {
+      smgf_set_error(c, "gc_budget in conf.lua must be >= 0");
+      return 1;
+    }
+  }
+  lua_pop(L, 1);
+
+  if (lua_getfield(L, -1, "preload") == LUA_TBOOLEAN) {
+    c->conf.preload = lua_toboolean(L, -1);
+  }
+  lua_pop(L, 1);
+
+  if (lua_getfield(L, -1, "read_ahead") == LUA_TBOOLEAN) {
+    c->conf.read_ahead = lua_toboolean(L, -1);
+  }
+  lua_pop(L, 1);
+
   if (lua_getfield(L, -1, "window_title") == LUA_TSTRING) {
     const char* str = lua_tostring(L, -1);
     c->conf.window_title = smgf_strcpy(str);
@@ -208,8 +504,11 @@ int smgf_init(smgf* const c, const char* game_folder) {
       .channels = 2,
       .freq = 44100,
   };
+  // headless: the mixer is not bound to any playback device
   MIX_Mixer* mixer =
-      MIX_CreateMixerDevice(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, &spec);
+      c->headless
+          ? MIX_CreateMixer(&spec)
+          : MIX_CreateMixerDevice(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, &spec);
   if (mixer == NULL) {
     smgf_set_error(c, "Unable to create mixer device: %s", SDL_GetError());
     return 1;
@@ -230,14 +529,32 @@ int smgf_init(smgf* const c, const char* game_folder) {
   if (load_config(c, CONF_FILE_NAME) != 0) {
     return 1;
   }
+
+  // the options of the command line override conf.lua
+  if ((c->conf.preload || c->force_preload) &&
+      smgf_preload_game(c, game_folder) != 0) {
+    return 1;
+  }
+  if (c->conf.read_ahead || c->force_read_ahead) {
+    smgf_read_ahead_start(c, game_folder);
+  }
+
   c->width = c->conf.width;
   c->height = c->conf.height;
   c->fps = c->conf.fps;
+  c->update_rate = c->conf.update_rate;
+  c->update_accumulator = 0;
   c->zoom = c->conf.zoom;
 
   // opening Lua env
-  c->L = luaL_newstate();
+  c->L = smgf_heap_newstate(c);
+  if (c->L == NULL) {
+    smgf_set_error(c, "error creating Lua state");
+    return 1;
+  }
   lua_api_init(c); // init Lua state + register smgf functions
+  // stays at the bottom of the stack (see smgf_pcall)
+  lua_pushcfunction(c->L, smgf_error_handler);
 
   // sets the identity of the game, which has the effect of mounting pref path
   // if application+organisation are valid values
@@ -246,13 +563,19 @@ int smgf_init(smgf* const c, const char* game_folder) {
   const char* app =
       c->conf.application ? smgf_strcpy(c->conf.application) : NULL;
   sf_sy_set_identity(c, org, app);
+  bytecode_cache_prune();
 
   SDL_memset(c->controllers, -1, sizeof(SDL_JoystickID) * 4);
 
   // setting up SDL window
+  SDL_WindowFlags window_flags =
+      SDL_WINDOW_RESIZABLE | SDL_WINDOW_HIGH_PIXEL_DENSITY;
+  if (c->headless) {
+    window_flags |= SDL_WINDOW_HIDDEN;
+  }
   c->window = SDL_CreateWindow(
       c->conf.window_title, c->width * c->zoom, c->height * c->zoom,
-      SDL_WINDOW_RESIZABLE | SDL_WINDOW_HIGH_PIXEL_DENSITY);
+      window_flags);
   if (c->window == NULL) {
     SDL_Log("unable to create window: %s", SDL_GetError());
     return 1;
@@ -260,16 +583,17 @@ int smgf_init(smgf* const c, const char* game_folder) {
   SDL_SetWindowMinimumSize(c->window, c->width, c->height);
 
   // create SDL renderer
-  c->renderer = SDL_CreateRenderer(c->window, NULL);
+  c->renderer = SDL_CreateRenderer(
+      c->window, c->headless ? SDL_SOFTWARE_RENDERER : NULL);
   if (c->renderer == NULL) {
     SDL_Log("unable to create renderer: %s", SDL_GetError());
     return 1;
   }
-  SDL_SetRenderVSync(c->renderer, true);
+  SDL_SetRenderVSync(c->renderer, !c->headless);
 
   SDL_SetRenderLogicalPresentation(
       c->renderer, c->width, c->height, SDL_LOGICAL_PRESENTATION_LETTERBOX);
-  SDL_SetRenderDrawBlendMode(c->renderer, SDL_BLENDMODE_BLEND);
+  sf_gr_invalidate_state(c);
 
   if (!DBGP_CreateFont(
           &c->font, c->renderer, DBGP_UNSCII16, sizeof(DBGP_UNSCII16),
@@ -293,23 +617,20 @@ int smgf_init(smgf* const c, const char* game_folder) {
   sf_gr_reset_graphics_stack(c);
 
   // clearing screen texture once
-  SDL_SetRenderTarget(c->renderer, c->screen_texture->tex);
-  SDL_SetRenderDrawColor(c->renderer, 0, 0, 0, 255);
-  SDL_RenderClear(c->renderer);
+  SDL_Color black = {0, 0, 0, 255};
+  sf_gr_set_target(c, NULL);
+  sf_gr_clear(c, &black);
 
   // loading up main.lua
-  char* buffer = PHYSFS_readToBuffer(MAIN_FILE_NAME);
-  if (buffer == NULL) {
+  if (!PHYSFS_exists(MAIN_FILE_NAME)) {
     smgf_set_error(c, "File %s not found from game directory.", MAIN_FILE_NAME);
     return 1;
   }
 
-  if (luaC_loadstring(c->L, buffer, MAIN_FILE_NAME)) {
+  if (smgf_loadfile(c->L, MAIN_FILE_NAME, MAIN_FILE_NAME)) {
     smgf_set_error(c, "%s", lua_tostring(c->L, -1));
-    SDL_free(buffer);
     return 1;
   }
-  SDL_free(buffer);
 
   if (smgf_pcall(c->L, 0, LUA_MULTRET)) {
     return 1;
@@ -319,17 +640,24 @@ int smgf_init(smgf* const c, const char* game_folder) {
   c->keyboard_state = SDL_GetKeyboardState(NULL);
   sf_kb_set_textinput(c, false);
   sf_sy_set_cursor_visible(c, c->conf.cursor_visible);
+  c->overlay.visible = c->conf.stats_overlay;
   c->focused = true;
 
   return 0;
 }
 
 int smgf_quit(smgf* const c) {
+  smgf_read_ahead_stop(c);
+  smgf_async_clear(c);
+  smgf_profiler_clear(c);
+  smgf_module_index_clear(c);
   if (c->L) {
     lua_close(c->L);
+    c->L = NULL;
   }
+  smgf_heap_clear(c);
   if (c->screen_texture != NULL) {
-    sf_gr_texture_del(c->screen_texture);
+    sf_gr_texture_del(c, c->screen_texture);
   }
   if (c->screen_texture != NULL) {
     SDL_free(c->screen_texture);
@@ -338,6 +666,13 @@ int smgf_quit(smgf* const c) {
   if (c->gstates != NULL) {
     SDL_free(c->gstates);
   }
+  sf_gr_text_cache_clear(c);
+  sf_gr_scratch_del(&c->draw_buffer);
+  sf_gr_scratch_del(&c->geometry_buffer);
+  if (c->trace.events != NULL) {
+    SDL_free(c->trace.events);
+    c->trace.events = NULL;
+  }
   DBGP_DestroyFont(&c->font);
   sf_sy_set_identity(c, NULL, NULL);
   if (c->conf.application) {
@@ -355,6 +690,8 @@ int smgf_quit(smgf* const c) {
   if (c->mixer != NULL) {
     MIX_DestroyMixer(c->mixer);
   }
+  // after the sounds, which can stream from the game archive
+  smgf_preload_clear(c);
   return 0;
 }
 
@@ -369,6 +706,7 @@ int smgf_set_error(smgf* const c, const char* fmt, ...) {
       return 1;
     }
     c->should_quit = true;
+    c->has_error = true;
   }
 
   va_list args, args_copy;
@@ -382,8 +720,10 @@ int smgf_set_error(smgf* const c, const char* fmt, ...) {
   // note: we need to make a copy of "args" to avoid segfault
   char error_message[4096];
   SDL_vsnprintf(error_message, 4096, fmt, args_copy);
-  SDL_ShowSimpleMessageBox(
-      SDL_MESSAGEBOX_ERROR, "SMGF error", error_message, window);
+  if (c == NULL || !c->headless) {
+    SDL_ShowSimpleMessageBox(
+        SDL_MESSAGEBOX_ERROR, "SMGF error", error_message, window);
+  }
 
   va_end(args);
   va_end(args_copy);
@@ -391,32 +731,6 @@ int smgf_set_error(smgf* const c, const char* fmt, ...) {
   return 1;
 }
 
-// Adds "smgf" global on the top of the stack.
-// Returns 0 if OK, 1 if smgf table not found
-int lua_getsmgf(smgf* const c) {
-  if (lua_getglobal(c->L, "smgf") != LUA_TTABLE) {
-    return smgf_set_error(c, "%s", "smgf table does not exist");
-  }
-
-  return 0;
-}
-
-// Adds a "smgf" function on the top of the stack.
-// returns 0 if OK, 1 if smgf table not found, 2 if func not found
-int lua_getsmgffunc(smgf* const c, const char* fname) {
-  if (lua_getsmgf(c) != 0) {
-    return 1;
-  }
-
-  if (lua_getfield(c->L, -1, fname) != LUA_TFUNCTION) {
-    lua_pop(c->L, 2);
-    return 2;
-  }
-  lua_remove(c->L, -2); // remove smgf table from stack
-
-  return 0;
-}
-
 SDL_Scancode smgf_get_scancode_from_name(const char* name) {
   return SDL_GetScancodeFromName(name);
 }
@@ -24,7 +24,8 @@
 
 #define CONF_FILE_NAME "conf.lua"
 #define MAIN_FILE_NAME "main.lua"
-#define SMGF_PTRNAME "smgf_ptr"
+// compiled Lua chunks are cached in this directory of the write directory
+#define BYTECODE_CACHE_DIR ".smgf-cache"
 #ifdef __EMSCRIPTEN__
 #define SMGF_AUTOLOAD_FILE "game/"
 #else
@@ -34,11 +35,22 @@
 #define WIDTH_DEFAULT 256
 #define HEIGHT_DEFAULT 256
 #define FPS_DEFAULT 0
+#define UPDATE_RATE_DEFAULT 0
 #define ZOOM_DEFAULT 1
 #define WINDOW_TITLE_DEFAULT "SMGF v" SMGF_VERSION
 #define CURSOR_VISIBLE_DEFAULT true
+#define STATS_OVERLAY_DEFAULT false
+#define LUA_POOL_ALLOCATOR_DEFAULT true
+#define GC_GENERATIONAL_DEFAULT false
+#define GC_PARAM_DEFAULT -1 // keeps Lua default
+#define GC_BUDGET_DEFAULT 0.001
+#define PRELOAD_DEFAULT false
+#define READ_AHEAD_DEFAULT false
 
 #define MAX_NB_GSTATES 64
+// max nb of fixed updates per frame, so that slow frames do not trigger
+// more and more updates ("spiral of death")
+#define MAX_UPDATES_PER_FRAME 5
 
 #define SDL_LogErrorC(...) \
   SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, __VA_ARGS__)
@@ -53,8 +65,98 @@ typedef struct stexture {
   SDL_Texture* tex;
   int width, height;
   Uint32 format;
+  SDL_Color mod; // last color/alpha mod applied to the SDL texture
+  SDL_BlendMode blend_mode; // last blend mode applied to the SDL texture
 } stexture;
 
+// a batch of textured quads, drawn in a single SDL_RenderGeometry call
+typedef struct sbatch {
+  stexture* texture;
+  SDL_Vertex* vertices; // 4 vertices per sprite
+  int* indices; // 6 indices per sprite (2 triangles)
+  int nb_sprites;
+  int capacity; // nb of sprites that fit in the buffers before growing
+} sbatch;
+
+// vertices (+ optional indices) owned by C, updated from Lua and drawn with
+// SDL_RenderGeometry
+typedef struct smesh {
+  stexture* texture; // can be NULL
+  SDL_Vertex* vertices;
+  SDL_Vertex* translated; // copy of vertices, used when drawing with an offset
+  float translated_x, translated_y; // offset of the copy
+  bool translated_valid; // the copy is up to date with the vertices
+  int* indices; // can be NULL
+  int nb_vertices;
+  int nb_indices;
+} smesh;
+
+// growable memory block, reused between calls to avoid allocations
+typedef struct sscratch {
+  void* data;
+  size_t size;
+} sscratch;
+
+// a grid of tiles taken from a tileset texture. Tiles are grouped in chunks
+// of TILEMAP_CHUNK_SIZE x TILEMAP_CHUNK_SIZE tiles, each pre-rendered in a
+// render target and only re-rendered when one of its tiles changes.
+#define TILEMAP_CHUNK_SIZE 16
+
+typedef struct stilemap {
+  stexture* tileset;
+  int tile_w, tile_h; // in pixels
+  int map_w, map_h; // in tiles
+  int nb_columns; // nb of tiles per row in tileset
+  Uint16* tiles; // tile numbers (1-based, 0 = no tile), row by row
+  int nb_chunks_x, nb_chunks_y;
+  stexture* chunks; // chunk render targets (tex is NULL until needed)
+  bool* dirty; // chunks that need to be re-rendered
+  Uint32 render_generation; // see smgf.render_generation
+} stilemap;
+
+// size of a glyph of the debug font (unscii-16)
+#define TEXT_GLYPH_WIDTH 8
+#define TEXT_GLYPH_HEIGHT 16
+
+// a string rendered once by DBGP in a render target, then drawn as a single
+// textured quad
+typedef struct stext {
+  stexture texture; // tex is NULL until the text is rendered
+  char* str;
+  int width, height; // in pixels
+  Uint32 render_generation; // see smgf.render_generation
+} stext;
+
+// cache of the strings drawn by sf_gr_print & sf_gr_print_color. A string is
+// only added to the cache (and rendered in a texture) the second time it is
+// drawn: the hashes of the strings seen once are kept in a small table, so
+// that strings changing every frame do not allocate anything. Least recently
+// used strings are evicted when there are too many entries, or when their
+// textures use more than TEXT_CACHE_BUDGET bytes.
+#define TEXT_CACHE_NB_BUCKETS 256
+#define TEXT_CACHE_NB_SEEN 256
+#define TEXT_CACHE_MAX_ENTRIES 1024
+#define TEXT_CACHE_BUDGET (4 * 1024 * 1024)
+
+typedef struct stext_cache_entry {
+  stext text;
+  Uint32 hash;
+  int color; // sf_gr_print_color color, or -1 for sf_gr_print
+  SDL_Color fg, bg; // sf_gr_print colors
+  struct stext_cache_entry* next; // in bucket
+  struct stext_cache_entry* lru_prev; // more recently used
+  struct stext_cache_entry* lru_next; // less recently used
+} stext_cache_entry;
+
+typedef struct stext_cache {
+  stext_cache_entry* buckets[TEXT_CACHE_NB_BUCKETS];
+  stext_cache_entry* lru_first; // most recently used
+  stext_cache_entry* lru_last; // least recently used
+  int nb_entries;
+  size_t memory; // bytes used by the textures of the entries
+  Uint32 seen[TEXT_CACHE_NB_SEEN]; // hashes of strings seen once (by hash)
+} stext_cache;
+
 typedef struct ssound {
   const char* filename;
   bool predecoded;
@@ -63,20 +165,64 @@ typedef struct ssound {
   MIX_Track* track;
 } ssound;
 
+// files open for reading are read by blocks, and the reads (lines, numbers,
+// small reads) are served from the block
+#define FILE_BLOCK_SIZE (16 * 1024)
+
 typedef struct sfile {
   SDL_IOStream* file;
   PHYSFS_Stat stat;
   char mode;
+  Uint8* block; // read-ahead, NULL if not open for reading
+  size_t block_pos; // next byte to read in the block
+  size_t block_len; // nb of bytes in the block
+  char* line; // lines which are not in a single block are copied here
+  size_t line_size;
 } sfile;
 
+// contiguous array of numbers, read and written by C functions (file writes,
+// bulk drawing...) without a Lua value per element. A view points into the
+// data of another buffer, which it keeps alive (user value of the userdata).
+typedef enum sbuffer_type {
+  SBUFFER_U8,
+  SBUFFER_I16,
+  SBUFFER_I32,
+  SBUFFER_F32,
+  SBUFFER_F64,
+  SBUFFER_NB_TYPES
+} sbuffer_type;
+
+// owner of the data of a buffer
+typedef enum sbuffer_storage {
+  SBUFFER_VIEW, // another buffer
+  SBUFFER_HEAP, // the buffer (SDL_malloc)
+  SBUFFER_MAPPED, // the buffer (memory-mapped file, see sf_bf_map)
+} sbuffer_storage;
+
+typedef struct sbuffer {
+  void* data;
+  size_t length; // nb of elements
+  sbuffer_type type;
+  sbuffer_storage storage;
+  size_t mapping_size; // in bytes, if mapped
+} sbuffer;
+
 typedef struct smgf_config {
   const char* window_title;
   const char* application; // game identity
   const char* organisation; // game identity
   int width, height; // of game screen
   int fps; // fps capping for update (defaults to 0 = disabled)
+  int update_rate; // fixed updates per second (defaults to 0 = disabled)
   float zoom; // zoom at startup
   bool cursor_visible;
+  bool stats_overlay; // shows the frame time overlay at startup
+  bool lua_pool_allocator; // conf.lua_allocator: "pool" (true) or "system"
+  bool gc_generational; // conf.gc_mode: "generational" or "incremental"
+  int gc_pause, gc_stepmul; // in %, or GC_PARAM_DEFAULT
+  double gc_budget; // max time of the GC steps made by smgf each frame (s)
+  bool preload; // the game archive is mounted from memory (see smgf_preload)
+  bool read_ahead; // the files of the game are read in the background
 } smgf_config;
 
 typedef struct smgf_graphic_state {
@@ -86,6 +232,300 @@ typedef struct smgf_graphic_state {
   int target_luaref;
 } smgf_graphic_state;
 
+// last state applied to the SDL renderer, used to skip redundant SDL calls
+typedef struct smgf_render_state {
+  SDL_Texture* target;
+  SDL_Color color; // draw color
+  SDL_BlendMode blend_mode;
+  SDL_Texture* texture; // last texture drawn (only used for stats)
+  bool target_valid, color_valid, blend_mode_valid;
+  Uint64 nb_issued; // nb of state changes sent to SDL
+  Uint64 nb_skipped; // nb of redundant state changes that were skipped
+} smgf_render_state;
+
+// counters of what a frame costs in the engine. They are updated during the
+// frame, then copied to smgf.last_stats at the end of the frame.
+typedef struct smgf_stats {
+  Uint64 frame_time; // time since the previous frame, in nanoseconds
+  Uint64 update_time, draw_time, present_time; // in nanoseconds
+  Uint64 nb_draw_calls;
+  Uint64 nb_texture_binds; // nb of draw calls using another texture
+  Uint64 nb_target_switches;
+  Uint64 nb_state_changes; // see smgf_render_state.nb_issued
+  Uint64 nb_pcalls; // Lua calls made by smgf (callbacks...)
+  Uint64 nb_events; // input events delivered to smgf.events
+  Uint64 nb_text_hits, nb_text_misses; // strings printed from the text cache
+  Uint64 nb_async; // asynchronous file requests delivered
+  Uint64 async_wait_time, async_io_time; // total of these requests, in ns
+  Uint64 async_max_time; // longest of these requests (queued to done), in ns
+  Uint64 nb_gc_steps; // Lua GC steps made by smgf
+  Uint64 gc_time; // in nanoseconds
+  size_t lua_memory; // size of the Lua heap at the end of the frame
+  Uint64 nb_allocs, nb_frees; // made by Lua during the frame
+  size_t heap_live, heap_peak; // bytes allocated by Lua (now, and at most)
+  Uint64 first_state_change; // nb_issued at the start of the frame
+} smgf_stats;
+
+// durations of the last frames (ring buffers, in nanoseconds), used for frame
+// time statistics and the stats overlay
+#define NB_FRAME_TIMES 1024
+
+typedef struct smgf_frame_times {
+  Uint64 times[NB_FRAME_TIMES];
+  Uint64 update_times[NB_FRAME_TIMES];
+  Uint64 draw_times[NB_FRAME_TIMES];
+  Uint64 present_times[NB_FRAME_TIMES];
+  int next; // index of the next frame time to write
+  int count; // nb of frame times written (up to NB_FRAME_TIMES)
+} smgf_frame_times;
+
+// timeline of engine & user zones, saved as a Chrome trace (JSON). Events
+// are written in a ring buffer of TRACE_CAPACITY events: slots are reserved
+// with an atomic counter, so zones can be recorded from any thread.
+#define TRACE_CAPACITY 65536
+#define TRACE_NAME_SIZE 32
+
+typedef struct strace_event {
+  Uint64 time; // in nanoseconds
+  SDL_ThreadID thread;
+  char phase; // 'B' (zone begins) or 'E' (zone ends)
+  char name[TRACE_NAME_SIZE];
+} strace_event;
+
+typedef struct smgf_trace {
+  strace_event* events; // kept until quitting, as zones can still be recorded
+  SDL_AtomicInt nb_events; // nb of events recorded since the trace started
+  SDL_AtomicInt enabled;
+} smgf_trace;
+
+// sampling profiler of the Lua code: a timer sets a flag at each sampling
+// interval, and a count hook (run every PROFILER_HOOK_COUNT instructions)
+// records the Lua call stack when the flag is set. Samples are counted per
+// call stack, and saved in the "folded stacks" format of flame graph tools.
+#define PROFILER_NB_BUCKETS 1024
+#define PROFILER_HOOK_COUNT 1000
+#define PROFILER_MAX_DEPTH 64
+#define PROFILER_STACK_SIZE 2048
+
+typedef struct sprofile_entry {
+  char* stack; // function names, from the outermost one, separated by ';'
+  Uint32 hash;
+  Uint64 nb_samples;
+  struct sprofile_entry* next; // in bucket
+} sprofile_entry;
+
+typedef struct smgf_profiler {
+  sprofile_entry* buckets[PROFILER_NB_BUCKETS];
+  SDL_TimerID timer; // 0 when not profiling
+  SDL_AtomicInt sample_requested; // set by the timer, cleared by the hook
+  Uint64 nb_samples;
+  char stack[PROFILER_STACK_SIZE]; // call stack of the current sample
+} smgf_profiler;
+
+// allocator of the game Lua state (see smgf_heap.c): blocks up to
+// HEAP_MAX_POOLED bytes come from pools, one per size class (multiples of
+// HEAP_CLASS_GRANULARITY bytes)
+#define HEAP_CLASS_GRANULARITY 16
+#define HEAP_MAX_POOLED 256
+#define HEAP_NB_CLASSES (HEAP_MAX_POOLED / HEAP_CLASS_GRANULARITY)
+#define HEAP_SLAB_SIZE (64 * 1024)
+
+typedef struct sheap_block {
+  struct sheap_block* next; // in free list
+} sheap_block;
+
+typedef struct sheap_slab {
+  struct sheap_slab* next;
+  void* padding; // blocks stay aligned on HEAP_CLASS_GRANULARITY bytes
+} sheap_slab;
+
+typedef struct smgf_heap {
+  sheap_block* free_lists[HEAP_NB_CLASSES];
+  sheap_slab* slabs;
+  lua_Alloc system_alloc; // conf.lua_allocator = "system"
+  void* system_ud;
+  size_t live, peak; // in bytes
+  Uint64 nb_allocs, nb_frees; // since the last frame
+  bool gc_paced; // the collector is stopped, smgf runs its steps
+  bool gc_restarted; // the collector runs by itself until the cycle ends
+  bool gc_in_cycle; // smgf is running a GC cycle
+  size_t gc_threshold; // Lua memory at which smgf starts a GC cycle
+  size_t gc_limit; // Lua memory at which the collector is restarted
+  bool warnings; // Lua warnings ("@on" / "@off")
+  char warning[256];
+  size_t warning_len;
+} smgf_heap;
+
+// index of the files of the search path, so that modules can be found
+// without asking PhysFS for each package.path template (which walks the
+// directory of archives). Files of the write directory are not indexed, as
+// they can change while the game runs. The index is built on the first
+// require, and is not used if there are too many files.
+#define MODULE_INDEX_NB_BUCKETS 1024
+#define MODULE_INDEX_MAX_FILES 16384
+#define MODULE_PATH_SIZE 1024
+
+typedef struct smodule_index_entry {
+  Uint32 hash;
+  struct smodule_index_entry* next; // in bucket
+  char path[]; // without leading "/"
+} smodule_index_entry;
+
+typedef struct smodule_index {
+  smodule_index_entry* buckets[MODULE_INDEX_NB_BUCKETS];
+  int nb_files;
+  bool built, complete;
+  Uint32 mount_generation; // see smgf.mount_generation
+} smodule_index;
+
+// frame time overlay, drawn by the engine on top of the game
+#define OVERLAY_NB_LINES 3
+
+typedef struct smgf_overlay {
+  bool visible;
+  int refresh_countdown; // nb of frames before the text is refreshed
+  char lines[OVERLAY_NB_LINES][32];
+} smgf_overlay;
+
+// Lua callbacks of the smgf table. References to their functions are kept in
+// the registry, and refreshed when a callback is assigned (the smgf table has
+// a __newindex metamethod), so that dispatching an event does not look them
+// up by name.
+typedef enum smgf_callback {
+  SMGF_CB_INIT,
+  SMGF_CB_UPDATE,
+  SMGF_CB_DRAW,
+  SMGF_CB_FOCUS,
+  SMGF_CB_KEY_DOWN,
+  SMGF_CB_KEY_UP,
+  SMGF_CB_TEXT_INPUT,
+  SMGF_CB_MOUSE_DOWN,
+  SMGF_CB_MOUSE_UP,
+  SMGF_CB_MOUSE_MOVED,
+  SMGF_CB_MOUSE_WHEEL,
+  SMGF_CB_GAMEPAD_ADDED,
+  SMGF_CB_GAMEPAD_REMOVED,
+  SMGF_CB_GAMEPAD_DOWN,
+  SMGF_CB_GAMEPAD_UP,
+  SMGF_CB_GAMEPAD_AXISMOTION,
+  SMGF_CB_TARGETS_RESET,
+  SMGF_CB_DEVICE_RESET,
+  SMGF_CB_EVENTS,
+  SMGF_NB_CALLBACKS
+} smgf_callback;
+
+typedef struct smgf_callbacks {
+  int refs[SMGF_NB_CALLBACKS]; // in registry (LUA_NOREF if not a function)
+  int table_ref; // smgf table whose callbacks are cached
+  int metatable_ref; // metatable set on the smgf table, if watched
+  bool watched; // the smgf table has the __newindex metamethod of smgf
+  bool dirty; // references must be refreshed
+} smgf_callbacks;
+
+// input events queued for smgf.events: when this callback is defined, input
+// events are delivered once per frame as a list, instead of one callback call
+// per event. Consecutive mouse motions (and motions of the same gamepad axis)
+// are merged. When the queue is full, it is delivered immediately.
+#define EVENT_QUEUE_SIZE 256
+#define EVENT_TEXT_SIZE 1024 // text of the text_input events
+
+typedef enum sevent_type {
+  SEVENT_KEY_DOWN,
+  SEVENT_KEY_UP,
+  SEVENT_TEXT_INPUT,
+  SEVENT_MOUSE_DOWN,
+  SEVENT_MOUSE_UP,
+  SEVENT_MOUSE_MOVED,
+  SEVENT_MOUSE_WHEEL,
+  SEVENT_GAMEPAD_DOWN,
+  SEVENT_GAMEPAD_UP,
+  SEVENT_GAMEPAD_AXISMOTION,
+  SEVENT_NB_TYPES
+} sevent_type;
+
+typedef struct sevent {
+  sevent_type type;
+  const char* name; // key, text, gamepad button or axis (static or in text)
+  int x, y; // mouse position, wheel motion, or player index in x
+  int dx, dy; // mouse motion
+  int button; // mouse button
+  float value; // gamepad axis
+  SDL_Keymod mod;
+} sevent;
+
+typedef struct smgf_events {
+  sevent queue[EVENT_QUEUE_SIZE];
+  int count;
+  char text[EVENT_TEXT_SIZE];
+  size_t text_len;
+  int list_len; // length of the list given to smgf.events
+} smgf_events;
+
+// asynchronous file operations (smgf.io.read_async...), run by a pool of
+// worker threads started by the first request. Their callbacks are called at
+// the start of the frame following their completion, after the input events.
+// Without threads, requests are run at the start of the next frame.
+#define ASYNC_NB_WORKERS 2
+#define ASYNC_QUEUE_SIZE 64 // max nb of requests whose callback is not called
+
+typedef enum sasync_op { SASYNC_READ, SASYNC_WRITE } sasync_op;
+
+typedef enum sasync_state {
+  SASYNC_PENDING,
+  SASYNC_RUNNING,
+  SASYNC_DONE,
+} sasync_state;
+
+typedef struct sasync_request {
+  int id;
+  sasync_op op;
+  sasync_state state; // changed by the workers, with the lock
+  bool cancelled; // the callback will not be called
+  char* path;
+  char* map_path; // native path of a read to map, or NULL
+  sbuffer data; // file read, or copy of the data to write
+  char* error; // NULL if the operation succeeded
+  int callback_ref; // in registry, LUA_NOREF if none
+  Uint64 queued_at, started_at, done_at; // in nanoseconds
+  struct sasync_request* next;
+} sasync_request;
+
+typedef struct smgf_async {
+  SDL_Thread* workers[ASYNC_NB_WORKERS];
+  int nb_workers; // 0 if threads could not be started
+  bool started;
+  bool quit; // asks the workers to stop
+  SDL_Mutex* lock;
+  SDL_Condition* wake; // signaled when a request is queued
+  sasync_request* first; // requests in queue order
+  sasync_request* last;
+  sasync_request* delivering; // done, callbacks not called yet
+  int nb_requests; // not cancelled
+  int next_id;
+} smgf_async;
+
+// types of the userdata given to Lua (see api_lua.h)
+typedef enum smgf_type {
+  SMGF_TYPE_TEXTURE,
+  SMGF_TYPE_SOUND,
+  SMGF_TYPE_FILE,
+  SMGF_TYPE_BATCH,
+  SMGF_TYPE_MESH,
+  SMGF_TYPE_TILEMAP,
+  SMGF_TYPE_TEXT,
+  SMGF_TYPE_BUFFER,
+  SMGF_NB_TYPES
+} smgf_type;
+
+// game archive mounted from memory, and read-ahead thread
+typedef struct smgf_preload {
+  sbuffer archive; // data of the archive, if mounted from memory
+  char* mounted_path; // name of the archive mounted from memory, or NULL
+  char* game_path; // game read by the read-ahead thread
+  SDL_Thread* read_ahead; // NULL if not started
+  SDL_AtomicInt stop; // asks the read-ahead thread to stop
+} smgf_preload;
+
 // smgf machine
 typedef struct smgf {
   lua_State* L;
@@ -95,19 +535,45 @@ typedef struct smgf {
   stexture* screen_texture;
   int width, height;
   int fps;
+  int update_rate; // nb of fixed updates per second (0 = once per frame)
+  double update_accumulator; // time not yet simulated by fixed updates
   float zoom;
   const char* application;
   const char* organisation;
 
   smgf_config conf;
   bool should_quit;
+  bool has_error; // set by smgf_set_error
   bool focused;
+  bool headless; // no visible window, no audio output, no vsync
+  bool force_preload; // "--preload", same as conf.preload = true
+  bool force_read_ahead; // "--read-ahead", same as conf.read_ahead = true
 
   smgf_graphic_state* gstates;
   int gstates_ptr;
   smgf_graphic_state* curstate;
+  smgf_render_state rstate;
+  Uint32 render_generation; // incremented when render targets are lost
+  sscratch draw_buffer; // primitives + colors read by bulk draw functions
+  sscratch geometry_buffer; // vertices + indices built by bulk draw functions
+  stext_cache text_cache;
 
-  float dt; // last dt
+  double dt; // last dt (in seconds)
+  smgf_frame_times frame_times;
+  smgf_stats stats; // current frame
+  smgf_stats last_stats; // last complete frame
+  smgf_overlay overlay;
+  smgf_trace trace;
+  smgf_profiler profiler;
+  smgf_heap heap;
+  Uint32 mount_generation; // incremented when the search path changes
+  smgf_preload preload;
+  smodule_index module_index;
+  smgf_callbacks callbacks;
+  smgf_events events;
+  smgf_async async;
+  const void* metatables[SMGF_NB_TYPES]; // compared by l_testudata
+  int metatable_refs[SMGF_NB_TYPES]; // in registry
   bool const* keyboard_state;
   SDL_JoystickID controllers[4];
   DBGP_Font font;
@@ -116,19 +582,51 @@ typedef struct smgf {
 int smgf_init(smgf* const c, const char* game_folder);
 int smgf_quit(smgf* const c);
 
-smgf* get_smgf(lua_State* L);
+// returns smgf instance, stored in the extra space of the Lua state (which is
+// copied to the coroutines). NULL for the Lua state that reads conf.lua.
+static inline smgf* get_smgf(lua_State* L) {
+  return *(smgf**) lua_getextraspace(L);
+}
+
 int smgf_set_error(smgf* const c, const char* fmt, ...);
+void smgf_draw_overlay(smgf* const c);
+int smgf_profiler_start(smgf* const c, Uint64 interval);
+int smgf_profiler_stop(smgf* const c, const char* filename);
+void smgf_profiler_clear(smgf* const c);
 int smgf_pcall(lua_State* L, int narg, int nres);
-int lua_getsmgf(smgf* const c);
-int lua_getsmgffunc(smgf* const c, const char* fname);
+int smgf_loadfile(lua_State* L, const char* filename, const char* chunkname);
+void smgf_callbacks_watch(smgf* const c);
+void smgf_callbacks_check(smgf* const c);
+int smgf_getcallback(smgf* const c, smgf_callback cb);
+bool smgf_hascallback(smgf* const c, smgf_callback cb);
+sevent* smgf_events_push(smgf* const c, sevent_type type);
+sevent* smgf_events_push_text(smgf* const c, const char* text);
+sevent* smgf_events_last(smgf* const c, sevent_type type);
+void smgf_events_flush(smgf* const c);
+int smgf_async_push(
+    smgf* const c, sasync_op op, const char* path, const void* data,
+    size_t size, int callback_ref);
+bool smgf_async_cancel(smgf* const c, int id);
+void smgf_async_flush(smgf* const c);
+void smgf_async_clear(smgf* const c);
+int smgf_preload_game(smgf* const c, const char* game_folder);
+int smgf_read_ahead_start(smgf* const c, const char* game_folder);
+void smgf_read_ahead_stop(smgf* const c);
+void smgf_preload_clear(smgf* const c);
 void lua_api_init(smgf* const c); // initialises a Lua state for smgf use
+void smgf_module_index_clear(smgf* const c);
+lua_State* smgf_heap_newstate(smgf* const c);
+void smgf_heap_clear(smgf* const c);
+void smgf_heap_collect(smgf* const c, Uint64 budget);
 
 const char* smgf_strcpy(const char* str);
+#define SMGF_FNV1A_INIT 2166136261u
+Uint32 smgf_hash_fnv1a(Uint32 hash, const void* data, size_t size);
 
 // Lua callbacks:
 int smgf_linit(smgf* const c);
 int smgf_lupdate(smgf* const c);
-int smgf_ldraw(smgf* const c);
+int smgf_ldraw(smgf* const c, double alpha);
 int smgf_lfocus(smgf* const c, bool is_focused);
 int smgf_lkey_down(smgf* const c, SDL_KeyboardEvent* ev);
 int smgf_lkey_up(smgf* const c, SDL_KeyboardEvent* ev);
@@ -0,0 +1,335 @@
+#include "smgf.h"
+#include "api.h"
+#include "api_lua.h"
+
+// asynchronous requests are kept in a single list, in queue order. Workers
+// take the first pending request, and the main thread removes the requests
+// which are done when delivering them. Cancelled requests stay in the list
+// until then, but do not count in the queue depth. The requests which are
+// done are moved to the delivering list while their callbacks are called.
+
+// writes the data of a request to its file
+static int async_write(sasync_request* r) {
+  SDL_IOStream* file = PHYSFSSDL3_openWrite(r->path);
+  if (file == NULL) {
+    return -1;
+  }
+
+  size_t size = r->data.length;
+  size_t written = size > 0 ? SDL_WriteIO(file, r->data.data, size) : 0;
+  if (!SDL_CloseIO(file) || written != size) {
+    SDL_SetError(
+        "unable to write file '%s' (%s)", r->path,
+        PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode()));
+    return -1;
+  }
+  return 0;
+}
+
+// runs a request (on a worker thread, without the lock)
+static void async_run(sasync_request* r) {
+  int error = 0;
+  switch (r->op) {
+  case SASYNC_READ: error = sf_io_load(&r->data, r->path, r->map_path); break;
+  case SASYNC_WRITE: error = async_write(r); break;
+  }
+  if (error != 0) {
+    r->error = SDL_strdup(SDL_GetError());
+  }
+}
+
+// returns true if a request comes after a request on the same file which is
+// not done, and must wait for it (with the lock)
+static bool async_waits(smgf_async* const a, sasync_request* r) {
+  for (sasync_request* p = a->first; p != r; p = p->next) {
+    if (p->state != SASYNC_DONE && SDL_strcmp(p->path, r->path) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// returns the first pending request, or NULL (with the lock). Requests on
+// the same file run in queue order, so that the last write wins and a read
+// sees the writes queued before it.
+static sasync_request* async_next(smgf_async* const a) {
+  for (sasync_request* r = a->first; r != NULL; r = r->next) {
+    if (r->state == SASYNC_PENDING && !async_waits(a, r)) {
+      return r;
+    }
+  }
+  return NULL;
+}
+
+static int async_worker(void* data) {
+  smgf_async* const a = (smgf_async*) data;
+
+  SDL_LockMutex(a->lock);
+  while (!a->quit) {
+    sasync_request* r = async_next(a);
+    if (r == NULL) {
+      SDL_WaitCondition(a->wake, a->lock);
+      continue;
+    }
+
+    r->state = SASYNC_RUNNING;
+    r->started_at = SDL_GetTicksNS();
+    SDL_UnlockMutex(a->lock);
+    async_run(r);
+    SDL_LockMutex(a->lock);
+    r->done_at = SDL_GetTicksNS();
+    r->state = SASYNC_DONE;
+  }
+  SDL_UnlockMutex(a->lock);
+
+  return 0;
+}
+
+// creates the lock and starts the workers. If threads are not available,
+// requests are run by smgf_async_flush.
+static int async_start(smgf_async* const a) {
+  a->lock = SDL_CreateMutex();
+  a->wake = SDL_CreateCondition();
+  if (a->lock == NULL || a->wake == NULL) {
+    SDL_DestroyMutex(a->lock);
+    SDL_DestroyCondition(a->wake);
+    a->lock = NULL;
+    a->wake = NULL;
+    return -1;
+  }
+
+  a->quit = false;
+  a->nb_workers = 0;
+  for (int i = 0; i < ASYNC_NB_WORKERS; i++) {
+    SDL_Thread* t = SDL_CreateThread(async_worker, "smgf_async", a);
+    if (t == NULL) {
+      SDL_LogWarnC("cannot start I/O worker thread (%s)", SDL_GetError());
+      break;
+    }
+    a->workers[a->nb_workers] = t;
+    a->nb_workers += 1;
+  }
+  a->started = true;
+
+  return 0;
+}
+
+static void async_request_del(sasync_request* r) {
+  SDL_free(r->path);
+  SDL_free(r->map_path);
+  SDL_free(r->error);
+  sf_bf_del(&r->data);
+  SDL_free(r);
+}
+
+// queues a request, whose callback will be called with its result. The data
+// to write is copied. Returns the id of the request, or -1 on error.
+int smgf_async_push(
+    smgf* const c, sasync_op op, const char* path, const void* data,
+    size_t size, int callback_ref) {
+  smgf_async* const a = &c->async;
+  if (!a->started && async_start(a) != 0) {
+    return -1;
+  }
+  if (a->nb_requests >= ASYNC_QUEUE_SIZE) {
+    SDL_SetError("too many requests (%d)", ASYNC_QUEUE_SIZE);
+    return -1;
+  }
+
+  sasync_request* r = SDL_calloc(1, sizeof(sasync_request));
+  if (r == NULL) {
+    return -1;
+  }
+  r->op = op;
+  r->state = SASYNC_PENDING;
+  r->callback_ref = callback_ref;
+  r->path = SDL_strdup(path);
+  if (r->path == NULL) {
+    async_request_del(r);
+    return -1;
+  }
+  if (op == SASYNC_READ) {
+    // resolved now: the search path can change while the request is pending
+    r->map_path = sf_io_mappable_path(path);
+  } else {
+    if (sf_bf_new(&r->data, SBUFFER_U8, size) != 0) {
+      async_request_del(r);
+      return -1;
+    }
+    if (size > 0) {
+      SDL_memcpy(r->data.data, data, size);
+    }
+  }
+
+  a->next_id += 1;
+  r->id = a->next_id;
+  r->queued_at = SDL_GetTicksNS();
+
+  SDL_LockMutex(a->lock);
+  if (a->last != NULL) {
+    a->last->next = r;
+  } else {
+    a->first = r;
+  }
+  a->last = r;
+  a->nb_requests += 1;
+  SDL_SignalCondition(a->wake);
+  SDL_UnlockMutex(a->lock);
+
+  return r->id;
+}
+
+// cancels a request whose callback has not been called yet. A pending request
+// is not run, a running one completes (a write cannot be stopped). Returns
+// false if there is no such request.
+bool smgf_async_cancel(smgf* const c, int id) {
+  smgf_async* const a = &c->async;
+  if (!a->started) {
+    return false;
+  }
+
+  // a request done in the same frame as the callback cancelling it is in the
+  // delivering list, and no longer counts in the queue depth
+  for (sasync_request* r = a->delivering; r != NULL; r = r->next) {
+    if (r->id == id && !r->cancelled) {
+      r->cancelled = true;
+      luaL_unref(c->L, LUA_REGISTRYINDEX, r->callback_ref);
+      r->callback_ref = LUA_NOREF;
+      return true;
+    }
+  }
+
+  bool found = false;
+  SDL_LockMutex(a->lock);
+  for (sasync_request* r = a->first; r != NULL; r = r->next) {
+    if (r->id == id && !r->cancelled) {
+      r->cancelled = true;
+      if (r->state == SASYNC_PENDING) {
+        r->state = SASYNC_DONE; // removed by the next flush
+      }
+      luaL_unref(c->L, LUA_REGISTRYINDEX, r->callback_ref);
+      r->callback_ref = LUA_NOREF;
+      a->nb_requests -= 1;
+      found = true;
+      break;
+    }
+  }
+  SDL_UnlockMutex(a->lock);
+
+  return found;
+}
+
+// calls the callback of a request: with the buffer that was read (or true for
+// a write), or nil and an error message
+static void async_deliver(smgf* const c, sasync_request* r) {
+  lua_State* const L = c->L;
+  smgf_stats* const s = &c->stats;
+  s->nb_async += 1;
+  s->async_wait_time += r->started_at - r->queued_at;
+  s->async_io_time += r->done_at - r->started_at;
+  s->async_max_time = SDL_max(s->async_max_time, r->done_at - r->queued_at);
+
+  if (r->callback_ref == LUA_NOREF) {
+    return;
+  }
+  lua_rawgeti(L, LUA_REGISTRYINDEX, r->callback_ref);
+  luaL_unref(L, LUA_REGISTRYINDEX, r->callback_ref);
+  r->callback_ref = LUA_NOREF;
+
+  int nargs = 1;
+  if (r->error != NULL) {
+    lua_pushnil(L);
+    lua_pushstring(L, r->error);
+    nargs = 2;
+  } else if (r->op == SASYNC_READ) {
+    sbuffer* b = l_newbuffer(L);
+    *b = r->data; // the buffer now owns the data
+    r->data.storage = SBUFFER_VIEW;
+  } else {
+    lua_pushboolean(L, true);
+  }
+  smgf_pcall(L, nargs, 0);
+}
+
+// delivers the requests which are done, in queue order
+void smgf_async_flush(smgf* const c) {
+  smgf_async* const a = &c->async;
+  if (!a->started || a->first == NULL) {
+    return;
+  }
+
+  if (a->nb_workers == 0) {
+    // no threads: runs the pending requests now
+    for (sasync_request* r = a->first; r != NULL; r = r->next) {
+      if (r->state == SASYNC_PENDING) {
+        r->started_at = SDL_GetTicksNS();
+        async_run(r);
+        r->done_at = SDL_GetTicksNS();
+        r->state = SASYNC_DONE;
+      }
+    }
+  }
+
+  // the requests are removed from the queue before calling the callbacks,
+  // which can queue other requests, or cancel the requests delivered next
+  sasync_request** done_last = &a->delivering;
+  SDL_LockMutex(a->lock);
+  sasync_request** p = &a->first;
+  a->last = NULL;
+  while (*p != NULL) {
+    sasync_request* r = *p;
+    if (r->state == SASYNC_DONE) {
+      *p = r->next;
+      r->next = NULL;
+      *done_last = r;
+      done_last = &r->next;
+      if (!r->cancelled) {
+        a->nb_requests -= 1;
+      }
+    } else {
+      a->last = r;
+      p = &r->next;
+    }
+  }
+  SDL_UnlockMutex(a->lock);
+
+  while (a->delivering != NULL) {
+    sasync_request* r = a->delivering;
+    a->delivering = r->next;
+    if (!r->cancelled) {
+      async_deliver(c, r);
+    }
+    async_request_del(r);
+  }
+}
+
+// stops the workers (waiting for the running requests) and frees all the
+// requests, without calling their callbacks
+void smgf_async_clear(smgf* const c) {
+  smgf_async* const a = &c->async;
+  if (!a->started) {
+    return;
+  }
+
+  SDL_LockMutex(a->lock);
+  a->quit = true;
+  SDL_BroadcastCondition(a->wake);
+  SDL_UnlockMutex(a->lock);
+  for (int i = 0; i < a->nb_workers; i++) {
+    SDL_WaitThread(a->workers[i], NULL);
+  }
+
+  sasync_request* r = a->first;
+  while (r != NULL) {
+    sasync_request* next = r->next;
+    if (c->L != NULL) {
+      luaL_unref(c->L, LUA_REGISTRYINDEX, r->callback_ref);
+    }
+    async_request_del(r);
+    r = next;
+  }
+
+  SDL_DestroyCondition(a->wake);
+  SDL_DestroyMutex(a->lock);
+  SDL_zerop(a);
+}
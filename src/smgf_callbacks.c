@@ -34,8 +34,220 @@ static inline void l_pushkeymodtable(lua_State* L, SDL_Keymod mod) {
     l_pushtotable(L, ++i, "mode");
 }
 
+// registry key of the table read by the callback references: the callbacks
+// assigned to the watched smgf table, or the smgf table itself if it is not
+// watched (because it already had a metatable)
+#define CALLBACKS_TABLE "smgf_callbacks"
+
+static const char* const callback_names[SMGF_NB_CALLBACKS] = {
+    [SMGF_CB_INIT] = "init",
+    [SMGF_CB_UPDATE] = "update",
+    [SMGF_CB_DRAW] = "draw",
+    [SMGF_CB_FOCUS] = "focus",
+    [SMGF_CB_KEY_DOWN] = "key_down",
+    [SMGF_CB_KEY_UP] = "key_up",
+    [SMGF_CB_TEXT_INPUT] = "text_input",
+    [SMGF_CB_MOUSE_DOWN] = "mouse_down",
+    [SMGF_CB_MOUSE_UP] = "mouse_up",
+    [SMGF_CB_MOUSE_MOVED] = "mouse_moved",
+    [SMGF_CB_MOUSE_WHEEL] = "mouse_wheel",
+    [SMGF_CB_GAMEPAD_ADDED] = "gamepad_added",
+    [SMGF_CB_GAMEPAD_REMOVED] = "gamepad_removed",
+    [SMGF_CB_GAMEPAD_DOWN] = "gamepad_down",
+    [SMGF_CB_GAMEPAD_UP] = "gamepad_up",
+    [SMGF_CB_GAMEPAD_AXISMOTION] = "gamepad_axismotion",
+    [SMGF_CB_TARGETS_RESET] = "targets_reset",
+    [SMGF_CB_DEVICE_RESET] = "device_reset",
+    [SMGF_CB_EVENTS] = "events",
+};
+
+static bool is_callback_name(const char* name) {
+  for (int i = 0; i < SMGF_NB_CALLBACKS; i++) {
+    if (SDL_strcmp(name, callback_names[i]) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// __newindex of the smgf table: callbacks are stored in the callbacks table
+// (the __index of the smgf table), so that each assignment is seen
+static int l_smgf_newindex(lua_State* L) {
+  smgf* const c = lua_touserdata(L, lua_upvalueindex(1));
+  if (lua_type(L, 2) == LUA_TSTRING && is_callback_name(lua_tostring(L, 2))) {
+    lua_getfield(L, LUA_REGISTRYINDEX, CALLBACKS_TABLE);
+    lua_replace(L, 1);
+    c->callbacks.dirty = true;
+  }
+  lua_rawset(L, 1);
+  return 0;
+}
+
+// watches the smgf table on the top of the stack: its callbacks are moved to
+// a callbacks table, and its metatable is set. A table which already has a
+// metatable is not watched: its callbacks are refreshed once per frame.
+void smgf_callbacks_watch(smgf* const c) {
+  lua_State* const L = c->L;
+  smgf_callbacks* const cb = &c->callbacks;
+  int t = lua_gettop(L);
+  luaL_unref(L, LUA_REGISTRYINDEX, cb->metatable_ref);
+  cb->metatable_ref = LUA_NOREF;
+
+  cb->watched = !lua_getmetatable(L, t);
+  if (cb->watched) {
+    lua_newtable(L);
+    for (int i = 0; i < SMGF_NB_CALLBACKS; i++) {
+      lua_pushstring(L, callback_names[i]);
+      lua_pushvalue(L, -1);
+      lua_rawget(L, t);
+      lua_rawset(L, -3);
+      lua_pushstring(L, callback_names[i]);
+      lua_pushnil(L);
+      lua_rawset(L, t);
+    }
+
+    lua_newtable(L); // metatable
+    lua_pushvalue(L, -2);
+    lua_setfield(L, -2, "__index");
+    lua_pushlightuserdata(L, c);
+    lua_pushcclosure(L, l_smgf_newindex, 1);
+    lua_setfield(L, -2, "__newindex");
+    lua_pushvalue(L, -1);
+    cb->metatable_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+    lua_setmetatable(L, t);
+  } else {
+    lua_pop(L, 1); // metatable
+    lua_pushvalue(L, t);
+  }
+  lua_setfield(L, LUA_REGISTRYINDEX, CALLBACKS_TABLE);
+
+  luaL_unref(L, LUA_REGISTRYINDEX, cb->table_ref);
+  lua_pushvalue(L, t);
+  cb->table_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+  cb->dirty = true;
+}
+
+// stops watching the smgf table on the top of the stack, whose metatable was
+// replaced by the game: the callbacks are moved back to it (unless assigned
+// since), and are refreshed once per frame
+static void callbacks_unwatch(smgf* const c) {
+  lua_State* const L = c->L;
+  smgf_callbacks* const cb = &c->callbacks;
+  int t = lua_gettop(L);
+
+  lua_getfield(L, LUA_REGISTRYINDEX, CALLBACKS_TABLE);
+  for (int i = 0; i < SMGF_NB_CALLBACKS; i++) {
+    lua_pushstring(L, callback_names[i]);
+    if (lua_rawget(L, t) == LUA_TNIL) {
+      lua_pushstring(L, callback_names[i]);
+      lua_pushvalue(L, -1);
+      lua_rawget(L, -4);
+      lua_rawset(L, t);
+    }
+    lua_pop(L, 1);
+  }
+  lua_pop(L, 1);
+
+  lua_pushvalue(L, t);
+  lua_setfield(L, LUA_REGISTRYINDEX, CALLBACKS_TABLE);
+  luaL_unref(L, LUA_REGISTRYINDEX, cb->metatable_ref);
+  cb->metatable_ref = LUA_NOREF;
+  cb->watched = false;
+  cb->dirty = true;
+}
+
+// checks, once per frame, that the smgf global is still the watched table,
+// and that the game did not replace its metatable
+void smgf_callbacks_check(smgf* const c) {
+  lua_State* const L = c->L;
+  smgf_callbacks* const cb = &c->callbacks;
+
+  lua_getglobal(L, "smgf");
+  lua_rawgeti(L, LUA_REGISTRYINDEX, cb->table_ref);
+  bool same = lua_rawequal(L, -1, -2);
+  lua_pop(L, 1);
+
+  if (same && cb->watched) {
+    if (!lua_getmetatable(L, -1)) {
+      lua_pushnil(L);
+    }
+    lua_rawgeti(L, LUA_REGISTRYINDEX, cb->metatable_ref);
+    bool watched = lua_rawequal(L, -1, -2);
+    lua_pop(L, 2);
+    if (!watched) {
+      callbacks_unwatch(c);
+    }
+  }
+
+  if (same) {
+    cb->dirty = cb->dirty || !cb->watched;
+  } else if (lua_istable(L, -1)) {
+    smgf_callbacks_watch(c);
+  } else {
+    smgf_set_error(c, "%s", "smgf table does not exist");
+    lua_newtable(L);
+    lua_setfield(L, LUA_REGISTRYINDEX, CALLBACKS_TABLE);
+    luaL_unref(L, LUA_REGISTRYINDEX, cb->table_ref);
+    lua_pushvalue(L, -1);
+    cb->table_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+    cb->watched = true;
+    cb->dirty = true;
+  }
+  lua_pop(L, 1);
+}
+
+static void callbacks_refresh(smgf* const c) {
+  lua_State* const L = c->L;
+  smgf_callbacks* const cb = &c->callbacks;
+
+  lua_getfield(L, LUA_REGISTRYINDEX, CALLBACKS_TABLE);
+  for (int i = 0; i < SMGF_NB_CALLBACKS; i++) {
+    luaL_unref(L, LUA_REGISTRYINDEX, cb->refs[i]);
+    cb->refs[i] = LUA_NOREF;
+    if (lua_istable(L, -1) &&
+        lua_getfield(L, -1, callback_names[i]) == LUA_TFUNCTION) {
+      cb->refs[i] = luaL_ref(L, LUA_REGISTRYINDEX);
+    } else if (lua_istable(L, -1)) {
+      lua_pop(L, 1);
+    }
+  }
+  lua_pop(L, 1);
+  cb->dirty = false;
+
+  // events without callback are not queued by SDL (the most frequent ones)
+  bool batched = cb->refs[SMGF_CB_EVENTS] != LUA_NOREF;
+  SDL_SetEventEnabled(
+      SDL_EVENT_MOUSE_MOTION,
+      batched || cb->refs[SMGF_CB_MOUSE_MOVED] != LUA_NOREF);
+  SDL_SetEventEnabled(
+      SDL_EVENT_GAMEPAD_AXIS_MOTION,
+      batched || cb->refs[SMGF_CB_GAMEPAD_AXISMOTION] != LUA_NOREF);
+}
+
+// returns whether a callback is defined
+bool smgf_hascallback(smgf* const c, smgf_callback cb) {
+  if (c->callbacks.dirty) {
+    callbacks_refresh(c);
+  }
+  return c->callbacks.refs[cb] != LUA_NOREF;
+}
+
+// Adds a callback function on the top of the stack.
+// returns 0 if OK, 2 if the callback is not defined
+int smgf_getcallback(smgf* const c, smgf_callback cb) {
+  if (c->callbacks.dirty) {
+    callbacks_refresh(c);
+  }
+  if (c->callbacks.refs[cb] == LUA_NOREF) {
+    return 2;
+  }
+
+  lua_rawgeti(c->L, LUA_REGISTRYINDEX, c->callbacks.refs[cb]);
+  return 0;
+}
+
 int smgf_linit(smgf* const c) {
-  if (lua_getsmgffunc(c, "init") != 0) {
+  if (smgf_getcallback(c, SMGF_CB_INIT) != 0) {
     return 1;
   }
 
@@ -45,7 +257,7 @@ int smgf_linit(smgf* const c) {
 }
 
 int smgf_lupdate(smgf* const c) {
-  if (lua_getsmgffunc(c, "update") != 0) {
+  if (smgf_getcallback(c, SMGF_CB_UPDATE) != 0) {
     return 1;
   }
 
@@ -55,20 +267,21 @@ int smgf_lupdate(smgf* const c) {
   return 0;
 }
 
-int smgf_ldraw(smgf* const c) {
+int smgf_ldraw(smgf* const c, double alpha) {
   sf_gr_reset_graphics_stack(c);
 
-  if (lua_getsmgffunc(c, "draw") != 0) {
+  if (smgf_getcallback(c, SMGF_CB_DRAW) != 0) {
     return 1;
   }
 
-  smgf_pcall(c->L, 0, 0);
+  lua_pushnumber(c->L, alpha);
+  smgf_pcall(c->L, 1, 0);
 
   return 0;
 }
 
 int smgf_lfocus(smgf* const c, bool is_focused) {
-  if (lua_getsmgffunc(c, "focus") != 0) {
+  if (smgf_getcallback(c, SMGF_CB_FOCUS) != 0) {
     return 1;
   }
 
@@ -84,7 +297,14 @@ int smgf_lkey_down(smgf* const c, SDL_KeyboardEvent* ev) {
     return 1;
   }
 
-  if (lua_getsmgffunc(c, "key_down") != 0) {
+  if (smgf_hascallback(c, SMGF_CB_EVENTS)) {
+    sevent* e = smgf_events_push(c, SEVENT_KEY_DOWN);
+    e->name = key_name;
+    e->mod = ev->mod;
+    return 0;
+  }
+
+  if (smgf_getcallback(c, SMGF_CB_KEY_DOWN) != 0) {
     return 1;
   }
 
@@ -102,7 +322,14 @@ int smgf_lkey_up(smgf* const c, SDL_KeyboardEvent* ev) {
     return 1;
   }
 
-  if (lua_getsmgffunc(c, "key_up") != 0) {
+  if (smgf_hascallback(c, SMGF_CB_EVENTS)) {
+    sevent* e = smgf_events_push(c, SEVENT_KEY_UP);
+    e->name = key_name;
+    e->mod = ev->mod;
+    return 0;
+  }
+
+  if (smgf_getcallback(c, SMGF_CB_KEY_UP) != 0) {
     return 1;
   }
 
@@ -115,7 +342,12 @@ int smgf_lkey_up(smgf* const c, SDL_KeyboardEvent* ev) {
 }
 
 int smgf_ltext_input(smgf* const c, const char* text) {
-  if (lua_getsmgffunc(c, "text_input") != 0) {
+  if (smgf_hascallback(c, SMGF_CB_EVENTS)) {
+    smgf_events_push_text(c, text);
+    return 0;
+  }
+
+  if (smgf_getcallback(c, SMGF_CB_TEXT_INPUT) != 0) {
     return 1;
   }
 
@@ -131,7 +363,15 @@ int smgf_lmouse_down(smgf* const c, int x, int y, int button) {
     return 1;
   }
 
-  if (lua_getsmgffunc(c, "mouse_down") != 0) {
+  if (smgf_hascallback(c, SMGF_CB_EVENTS)) {
+    sevent* e = smgf_events_push(c, SEVENT_MOUSE_DOWN);
+    e->x = x;
+    e->y = y;
+    e->button = button;
+    return 0;
+  }
+
+  if (smgf_getcallback(c, SMGF_CB_MOUSE_DOWN) != 0) {
     return 1;
   }
 
@@ -149,7 +389,15 @@ int smgf_lmouse_up(smgf* const c, int x, int y, int button) {
     return 1;
   }
 
-  if (lua_getsmgffunc(c, "mouse_up") != 0) {
+  if (smgf_hascallback(c, SMGF_CB_EVENTS)) {
+    sevent* e = smgf_events_push(c, SEVENT_MOUSE_UP);
+    e->x = x;
+    e->y = y;
+    e->button = button;
+    return 0;
+  }
+
+  if (smgf_getcallback(c, SMGF_CB_MOUSE_UP) != 0) {
     return 1;
   }
 
@@ -167,7 +415,20 @@ int smgf_lmouse_moved(smgf* const c, int x, int y, int xrel, int yrel) {
     return 1;
   }
 
-  if (lua_getsmgffunc(c, "mouse_moved") != 0) {
+  if (smgf_hascallback(c, SMGF_CB_EVENTS)) {
+    // merged with the previous motion
+    sevent* e = smgf_events_last(c, SEVENT_MOUSE_MOVED);
+    if (e == NULL) {
+      e = smgf_events_push(c, SEVENT_MOUSE_MOVED);
+    }
+    e->x = x;
+    e->y = y;
+    e->dx += xrel;
+    e->dy += yrel;
+    return 0;
+  }
+
+  if (smgf_getcallback(c, SMGF_CB_MOUSE_MOVED) != 0) {
     return 1;
   }
 
@@ -189,7 +450,14 @@ int smgf_lmouse_wheel(smgf* const c, int x, int y, int direction) {
     y *= -1;
   }
 
-  if (lua_getsmgffunc(c, "mouse_wheel") != 0) {
+  if (smgf_hascallback(c, SMGF_CB_EVENTS)) {
+    sevent* e = smgf_events_push(c, SEVENT_MOUSE_WHEEL);
+    e->x = x;
+    e->y = y;
+    return 0;
+  }
+
+  if (smgf_getcallback(c, SMGF_CB_MOUSE_WHEEL) != 0) {
     return 1;
   }
 
@@ -238,7 +506,7 @@ int smgf_lgamepad_added(smgf* const c, int joystick_index) {
   SDL_Joystick* joy = SDL_GetGamepadJoystick(pad);
   c->controllers[player_index] = SDL_GetJoystickID(joy);
 
-  if (lua_getsmgffunc(c, "gamepad_added") != 0) {
+  if (smgf_getcallback(c, SMGF_CB_GAMEPAD_ADDED) != 0) {
     return 1;
   }
   lua_pushinteger(c->L, player_index);
@@ -269,7 +537,7 @@ int smgf_lgamepad_removed(smgf* const c, SDL_JoystickID id) {
   SDL_Log("Closed gamepad %d (%s)", player_index, SDL_GetGamepadName(pad));
   SDL_CloseGamepad(pad);
 
-  if (lua_getsmgffunc(c, "gamepad_removed") != 0) {
+  if (smgf_getcallback(c, SMGF_CB_GAMEPAD_REMOVED) != 0) {
     return 1;
   }
 
@@ -296,7 +564,14 @@ int smgf_lgamepad_down(
     return 1;
   }
 
-  if (lua_getsmgffunc(c, "gamepad_down") != 0) {
+  if (smgf_hascallback(c, SMGF_CB_EVENTS)) {
+    sevent* e = smgf_events_push(c, SEVENT_GAMEPAD_DOWN);
+    e->x = player_index;
+    e->name = button_str;
+    return 0;
+  }
+
+  if (smgf_getcallback(c, SMGF_CB_GAMEPAD_DOWN) != 0) {
     return 1;
   }
   lua_pushinteger(c->L, player_index);
@@ -323,7 +598,14 @@ int smgf_lgamepad_up(
     return 1;
   }
 
-  if (lua_getsmgffunc(c, "gamepad_up") != 0) {
+  if (smgf_hascallback(c, SMGF_CB_EVENTS)) {
+    sevent* e = smgf_events_push(c, SEVENT_GAMEPAD_UP);
+    e->x = player_index;
+    e->name = button_str;
+    return 0;
+  }
+
+  if (smgf_getcallback(c, SMGF_CB_GAMEPAD_UP) != 0) {
     return 1;
   }
   lua_pushinteger(c->L, player_index);
@@ -350,7 +632,19 @@ int smgf_lgamepad_axismotion(
     return 1;
   }
 
-  if (lua_getsmgffunc(c, "gamepad_axismotion") != 0) {
+  if (smgf_hascallback(c, SMGF_CB_EVENTS)) {
+    // merged with the previous motion of the same axis
+    sevent* e = smgf_events_last(c, SEVENT_GAMEPAD_AXISMOTION);
+    if (e == NULL || e->x != player_index || e->name != axis_str) {
+      e = smgf_events_push(c, SEVENT_GAMEPAD_AXISMOTION);
+    }
+    e->x = player_index;
+    e->name = axis_str;
+    e->value = (float) value / SDL_MAX_SINT16;
+    return 0;
+  }
+
+  if (smgf_getcallback(c, SMGF_CB_GAMEPAD_AXISMOTION) != 0) {
     return 1;
   }
 
@@ -365,7 +659,7 @@ int smgf_lgamepad_axismotion(
 }
 
 int smgf_lrender_targets_reset(smgf* const c) {
-  if (lua_getsmgffunc(c, "targets_reset") != 0) {
+  if (smgf_getcallback(c, SMGF_CB_TARGETS_RESET) != 0) {
     return 1;
   }
 
@@ -375,7 +669,7 @@ int smgf_lrender_targets_reset(smgf* const c) {
 }
 
 int smgf_ldevice_reset(smgf* const c) {
-  if (lua_getsmgffunc(c, "device_reset") != 0) {
+  if (smgf_getcallback(c, SMGF_CB_DEVICE_RESET) != 0) {
     return 1;
   }
 
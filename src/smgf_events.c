@@ -0,0 +1,196 @@
+#include "smgf.h"
+
+// input events are queued while smgf.events is defined, and delivered at the
+// start of the next frame. The list given to smgf.events and the event tables
+// are reused from one frame to the next (there is a pool of tables per event
+// type, so that the fields of a table are always the same), so delivering the
+// events does not allocate once the pools are large enough.
+
+#define EVENTS_LIST "smgf_events_list" // in registry
+#define EVENTS_POOLS "smgf_events_pools" // in registry
+
+static const char* const event_types[SEVENT_NB_TYPES] = {
+    [SEVENT_KEY_DOWN] = "key_down",
+    [SEVENT_KEY_UP] = "key_up",
+    [SEVENT_TEXT_INPUT] = "text_input",
+    [SEVENT_MOUSE_DOWN] = "mouse_down",
+    [SEVENT_MOUSE_UP] = "mouse_up",
+    [SEVENT_MOUSE_MOVED] = "mouse_moved",
+    [SEVENT_MOUSE_WHEEL] = "mouse_wheel",
+    [SEVENT_GAMEPAD_DOWN] = "gamepad_down",
+    [SEVENT_GAMEPAD_UP] = "gamepad_up",
+    [SEVENT_GAMEPAD_AXISMOTION] = "gamepad_axismotion",
+};
+
+// adds an event at the end of the queue, which is delivered first if full
+sevent* smgf_events_push(smgf* const c, sevent_type type) {
+  smgf_events* const q = &c->events;
+  if (q->count == EVENT_QUEUE_SIZE) {
+    smgf_events_flush(c);
+  }
+
+  sevent* e = &q->queue[q->count];
+  q->count += 1;
+  SDL_zerop(e);
+  e->type = type;
+  return e;
+}
+
+// adds a text_input event, whose text is copied in the text buffer of the
+// queue (and truncated if larger than the buffer)
+sevent* smgf_events_push_text(smgf* const c, const char* text) {
+  smgf_events* const q = &c->events;
+  size_t len = SDL_strlen(text) + 1;
+  if (q->count == EVENT_QUEUE_SIZE || q->text_len + len > EVENT_TEXT_SIZE) {
+    smgf_events_flush(c);
+  }
+
+  char* copy = q->text + q->text_len;
+  len = SDL_utf8strlcpy(copy, text, EVENT_TEXT_SIZE - q->text_len) + 1;
+  q->text_len += len;
+
+  sevent* e = smgf_events_push(c, SEVENT_TEXT_INPUT);
+  e->name = copy;
+  return e;
+}
+
+// returns the last event of the queue if it has the given type, else NULL
+sevent* smgf_events_last(smgf* const c, sevent_type type) {
+  smgf_events* const q = &c->events;
+  if (q->count == 0 || q->queue[q->count - 1].type != type) {
+    return NULL;
+  }
+  return &q->queue[q->count - 1];
+}
+
+// pushes a registry table, created if it does not exist
+static void events_getregistry(lua_State* L, const char* name) {
+  if (lua_getfield(L, LUA_REGISTRYINDEX, name) != LUA_TTABLE) {
+    lua_pop(L, 1);
+    lua_newtable(L);
+    lua_pushvalue(L, -1);
+    lua_setfield(L, LUA_REGISTRYINDEX, name);
+  }
+}
+
+// pushes the n-th table of the pool of an event type
+static void events_gettable(lua_State* L, int pools, sevent_type type, int n) {
+  if (lua_rawgeti(L, pools, type + 1) != LUA_TTABLE) {
+    lua_pop(L, 1);
+    lua_newtable(L);
+    lua_pushvalue(L, -1);
+    lua_rawseti(L, pools, type + 1);
+  }
+
+  if (lua_rawgeti(L, -1, n) != LUA_TTABLE) {
+    lua_pop(L, 1);
+    lua_createtable(L, 0, 5);
+    lua_pushstring(L, event_types[type]);
+    lua_setfield(L, -2, "type");
+    lua_pushvalue(L, -1);
+    lua_rawseti(L, -3, n);
+  }
+  lua_remove(L, -2); // pool
+}
+
+static inline void events_setint(lua_State* L, const char* k, int v) {
+  lua_pushinteger(L, v);
+  lua_setfield(L, -2, k);
+}
+
+static inline void events_setstr(lua_State* L, const char* k, const char* v) {
+  lua_pushstring(L, v);
+  lua_setfield(L, -2, k);
+}
+
+// sets the fields of the event table on the top of the stack. They are the
+// arguments of the callback of the same name, but the key modifiers are a
+// bitmask (see smgf.keyboard.mods).
+static void events_setfields(lua_State* L, sevent* e) {
+  switch (e->type) {
+  case SEVENT_KEY_DOWN:
+  case SEVENT_KEY_UP:
+    events_setstr(L, "key", e->name);
+    events_setint(L, "mod", e->mod);
+    break;
+
+  case SEVENT_TEXT_INPUT:
+    events_setstr(L, "text", e->name);
+    break;
+
+  case SEVENT_MOUSE_DOWN:
+  case SEVENT_MOUSE_UP:
+    events_setint(L, "x", e->x);
+    events_setint(L, "y", e->y);
+    events_setint(L, "button", e->button);
+    break;
+
+  case SEVENT_MOUSE_MOVED:
+    events_setint(L, "x", e->x);
+    events_setint(L, "y", e->y);
+    events_setint(L, "dx", e->dx);
+    events_setint(L, "dy", e->dy);
+    break;
+
+  case SEVENT_MOUSE_WHEEL:
+    events_setint(L, "x", e->x);
+    events_setint(L, "y", e->y);
+    break;
+
+  case SEVENT_GAMEPAD_DOWN:
+  case SEVENT_GAMEPAD_UP:
+    events_setint(L, "player", e->x);
+    events_setstr(L, "button", e->name);
+    break;
+
+  case SEVENT_GAMEPAD_AXISMOTION:
+    events_setint(L, "player", e->x);
+    events_setstr(L, "axis", e->name);
+    lua_pushnumber(L, e->value);
+    lua_setfield(L, -2, "value");
+    break;
+
+  default:
+    break;
+  }
+}
+
+// delivers the queued events to smgf.events, in a single call
+void smgf_events_flush(smgf* const c) {
+  smgf_events* const q = &c->events;
+  lua_State* const L = c->L;
+  int count = q->count;
+  if (count == 0) {
+    return;
+  }
+  q->count = 0;
+
+  if (smgf_getcallback(c, SMGF_CB_EVENTS) != 0) {
+    q->text_len = 0;
+    return;
+  }
+
+  events_getregistry(L, EVENTS_LIST);
+  int list = lua_gettop(L);
+  events_getregistry(L, EVENTS_POOLS);
+  int pools = lua_gettop(L);
+
+  int nb_used[SEVENT_NB_TYPES] = {0};
+  for (int i = 0; i < count; i++) {
+    sevent* e = &q->queue[i];
+    nb_used[e->type] += 1;
+    events_gettable(L, pools, e->type, nb_used[e->type]);
+    events_setfields(L, e);
+    lua_rawseti(L, list, i + 1);
+  }
+  for (int i = count + 1; i <= q->list_len; i++) {
+    lua_pushnil(L);
+    lua_rawseti(L, list, i);
+  }
+  q->list_len = count;
+  q->text_len = 0;
+
+  lua_pop(L, 1); // pools
+  c->stats.nb_events += count;
+  smgf_pcall(L, 1, 0);
+}
@@ -0,0 +1,291 @@
+#include "smgf.h"
+
+// allocator of the Lua state of the game. Small blocks (most Lua strings,
+// tables, closures and upvalues) come from pools of fixed size blocks, carved
+// in slabs; larger blocks come from SDL_malloc. Slabs are only freed when the
+// Lua state is closed: freed blocks are reused by the next allocations of the
+// same size class, which is what the Lua GC does most of the time.
+//
+// With conf.lua_allocator = "system", the allocator of luaL_newstate is used,
+// and only wrapped to count allocations.
+
+static inline void heap_count_alloc(smgf_heap* const h, size_t size) {
+  h->nb_allocs += 1;
+  h->live += size;
+  if (h->live > h->peak) {
+    h->peak = h->live;
+  }
+}
+
+static inline void heap_count_free(smgf_heap* const h, size_t size) {
+  h->nb_frees += 1;
+  h->live -= size;
+}
+
+static void* heap_pool_alloc(smgf_heap* const h, int size_class) {
+  sheap_block* b = h->free_lists[size_class];
+  if (b != NULL) {
+    h->free_lists[size_class] = b->next;
+    return b;
+  }
+
+  // new slab, whose blocks are all added to the free list
+  sheap_slab* slab = SDL_malloc(HEAP_SLAB_SIZE);
+  if (slab == NULL) {
+    return NULL;
+  }
+  slab->next = h->slabs;
+  h->slabs = slab;
+
+  size_t block_size = (size_t) (size_class + 1) * HEAP_CLASS_GRANULARITY;
+  Uint8* first = (Uint8*) slab + sizeof(sheap_slab);
+  Uint8* end = (Uint8*) slab + HEAP_SLAB_SIZE;
+  for (Uint8* p = first + block_size; p + block_size <= end;
+       p += block_size) {
+    b = (sheap_block*) p;
+    b->next = h->free_lists[size_class];
+    h->free_lists[size_class] = b;
+  }
+  return first;
+}
+
+static inline void
+heap_pool_free(smgf_heap* const h, void* ptr, int size_class) {
+  sheap_block* b = ptr;
+  b->next = h->free_lists[size_class];
+  h->free_lists[size_class] = b;
+}
+
+static inline int heap_size_class(size_t size) {
+  return size <= HEAP_MAX_POOLED ? (int) ((size - 1) / HEAP_CLASS_GRANULARITY)
+                                 : -1;
+}
+
+static void* heap_alloc(void* ud, void* ptr, size_t osize, size_t nsize) {
+  smgf_heap* const h = ud;
+  if (ptr == NULL) {
+    osize = 0; // osize is the type of the object being created
+  }
+  int oclass = ptr != NULL ? heap_size_class(osize) : -1;
+
+  if (nsize == 0) {
+    if (ptr != NULL) {
+      heap_count_free(h, osize);
+      if (oclass >= 0) {
+        heap_pool_free(h, ptr, oclass);
+      } else {
+        SDL_free(ptr);
+      }
+    }
+    return NULL;
+  }
+
+  int nclass = heap_size_class(nsize);
+  if (ptr != NULL && oclass == nclass) {
+    if (oclass >= 0) {
+      // same block
+      h->live += nsize - osize;
+      h->peak = SDL_max(h->peak, h->live);
+      return ptr;
+    }
+
+    void* block = SDL_realloc(ptr, nsize);
+    if (block != NULL) {
+      heap_count_free(h, osize);
+      heap_count_alloc(h, nsize);
+    }
+    return block;
+  }
+
+  void* block =
+      nclass >= 0 ? heap_pool_alloc(h, nclass) : SDL_malloc(nsize);
+  if (block == NULL) {
+    return NULL;
+  }
+  heap_count_alloc(h, nsize);
+
+  if (ptr != NULL) {
+    SDL_memcpy(block, ptr, SDL_min(osize, nsize));
+    heap_count_free(h, osize);
+    if (oclass >= 0) {
+      heap_pool_free(h, ptr, oclass);
+    } else {
+      SDL_free(ptr);
+    }
+  }
+  return block;
+}
+
+// allocator of luaL_newstate, with counters
+static void*
+heap_system_alloc(void* ud, void* ptr, size_t osize, size_t nsize) {
+  smgf_heap* const h = ud;
+  if (ptr == NULL) {
+    osize = 0;
+  }
+
+  void* block = h->system_alloc(h->system_ud, ptr, osize, nsize);
+  if (nsize == 0) {
+    if (ptr != NULL) {
+      heap_count_free(h, osize);
+    }
+  } else if (block != NULL) {
+    if (ptr != NULL) {
+      heap_count_free(h, osize);
+    }
+    heap_count_alloc(h, nsize);
+  }
+  return block;
+}
+
+static int heap_panic(lua_State* L) {
+  const char* msg = lua_tostring(L, -1);
+  SDL_LogErrorC(
+      "PANIC: unprotected error in call to Lua API (%s)",
+      msg != NULL ? msg : "error object is not a string");
+  return 0;
+}
+
+// warnings, as with luaL_newstate: "@on" and "@off" control messages enable
+// and disable them (enabled by default)
+static void heap_warn(void* ud, const char* msg, int tocont) {
+  smgf_heap* const h = ud;
+  if (h->warning_len == 0 && !tocont && msg[0] == '@') {
+    if (SDL_strcmp(msg, "@on") == 0) {
+      h->warnings = true;
+    } else if (SDL_strcmp(msg, "@off") == 0) {
+      h->warnings = false;
+    }
+    return;
+  }
+  if (!h->warnings) {
+    return;
+  }
+
+  size_t n = SDL_strlcpy(
+      h->warning + h->warning_len, msg,
+      sizeof(h->warning) - h->warning_len);
+  h->warning_len = SDL_min(h->warning_len + n, sizeof(h->warning) - 1);
+  if (!tocont) {
+    SDL_LogWarnC("Lua warning: %s", h->warning);
+    h->warning_len = 0;
+  }
+}
+
+static size_t heap_gc_memory(lua_State* L) {
+  return (size_t) lua_gc(L, LUA_GCCOUNT) * 1024 + lua_gc(L, LUA_GCCOUNTB);
+}
+
+// sets the memory at which smgf starts a cycle, and the one at which the
+// collector would have started it by itself (i.e. while allocating in
+// smgf.update): smgf starts halfway, and restarts the collector past the
+// latter, if the idle time was too short to complete the cycle.
+static void heap_gc_set_limits(smgf* const c, lua_State* L, size_t memory) {
+  smgf_heap* const h = &c->heap;
+  // growth (in %) before the collector runs by itself
+  int growth =
+      c->conf.gc_generational
+          ? lua_gc(L, LUA_GCPARAM, LUA_GCPMINORMUL, -1)
+          : lua_gc(L, LUA_GCPARAM, LUA_GCPPAUSE, -1) - 100;
+  growth = SDL_max(growth, 0);
+  h->gc_threshold = memory + memory * growth / 200;
+  h->gc_limit = memory + memory * growth / 100;
+}
+
+// sets the GC mode and parameters from conf.lua. With a GC budget, the
+// collector is stopped: smgf runs its steps in the idle time of frames.
+static void heap_setup_gc(smgf* const c, lua_State* L) {
+  smgf_heap* const h = &c->heap;
+  lua_gc(L, c->conf.gc_generational ? LUA_GCGEN : LUA_GCINC);
+  lua_gc(L, LUA_GCPARAM, LUA_GCPPAUSE, c->conf.gc_pause);
+  lua_gc(L, LUA_GCPARAM, LUA_GCPSTEPMUL, c->conf.gc_stepmul);
+  if (c->conf.gc_budget > 0) {
+    lua_gc(L, LUA_GCSTOP);
+    h->gc_paced = true;
+    heap_gc_set_limits(c, L, heap_gc_memory(L));
+  }
+}
+
+// runs GC steps for at most "budget" nanoseconds (called once per frame, in
+// its idle time). A cycle is started when the Lua memory reaches the
+// threshold (see heap_gc_set_limits). In generational mode, a step is a whole
+// minor collection, so only one is made.
+void smgf_heap_collect(smgf* const c, Uint64 budget) {
+  smgf_heap* const h = &c->heap;
+  lua_State* const L = c->L;
+  if (!h->gc_paced) {
+    return;
+  }
+
+  size_t memory = heap_gc_memory(L);
+  if (!h->gc_in_cycle && memory < h->gc_threshold) {
+    return;
+  }
+  h->gc_in_cycle = true;
+  if (!h->gc_restarted && memory >= h->gc_limit) {
+    // not enough idle time: Lua collects while allocating, as without smgf
+    lua_gc(L, LUA_GCRESTART);
+    h->gc_restarted = true;
+  }
+  if (budget == 0) {
+    return;
+  }
+
+  Uint64 start = SDL_GetTicksNS();
+  bool cycle_done = false;
+  do {
+    c->stats.nb_gc_steps += 1;
+    cycle_done = lua_gc(L, LUA_GCSTEP, (size_t) 0) || c->conf.gc_generational;
+  } while (!cycle_done && SDL_GetTicksNS() - start < budget);
+  c->stats.gc_time += SDL_GetTicksNS() - start;
+
+  if (cycle_done) {
+    h->gc_in_cycle = false;
+    heap_gc_set_limits(c, L, heap_gc_memory(L));
+    if (h->gc_restarted) {
+      lua_gc(L, LUA_GCSTOP);
+      h->gc_restarted = false;
+    }
+  }
+}
+
+// creates the Lua state of the game, with the allocator chosen in conf.lua
+lua_State* smgf_heap_newstate(smgf* const c) {
+  smgf_heap* const h = &c->heap;
+  SDL_zerop(h);
+  h->warnings = true;
+
+  if (!c->conf.lua_pool_allocator) {
+    lua_State* L = luaL_newstate();
+    if (L != NULL) {
+      heap_setup_gc(c, L);
+      h->system_alloc = lua_getallocf(L, &h->system_ud);
+      lua_setallocf(L, heap_system_alloc, h);
+      // blocks allocated before the allocator is wrapped
+      h->live = heap_gc_memory(L);
+      h->peak = h->live;
+    }
+    return L;
+  }
+
+  lua_State* L = lua_newstate(heap_alloc, h, luaL_makeseed(NULL));
+  if (L != NULL) {
+    heap_setup_gc(c, L);
+    lua_atpanic(L, heap_panic);
+    lua_setwarnf(L, heap_warn, h);
+  }
+  return L;
+}
+
+// frees the slabs. Must be called after the Lua state is closed.
+void smgf_heap_clear(smgf* const c) {
+  smgf_heap* const h = &c->heap;
+  sheap_slab* slab = h->slabs;
+  while (slab != NULL) {
+    sheap_slab* next = slab->next;
+    SDL_free(slab);
+    slab = next;
+  }
+  h->slabs = NULL;
+  SDL_memset(h->free_lists, 0, sizeof(h->free_lists));
+}
@@ -0,0 +1,155 @@
+#include "smgf.h"
+#include "api.h"
+
+// the frame time overlay is drawn by the engine on the screen texture, after
+// smgf.draw. Its text is only refreshed every few frames (so that it stays
+// readable and is drawn from the text cache), and its graph is drawn with a
+// single call to sf_gr_draw_rectfills.
+
+#define OVERLAY_REFRESH_FRAMES 30
+#define OVERLAY_MARGIN 4
+#define OVERLAY_PADDING 2
+#define OVERLAY_TEXT_WIDTH (20 * TEXT_GLYPH_WIDTH)
+#define OVERLAY_GRAPH_WIDTH 128 // nb of frames shown
+#define OVERLAY_GRAPH_HEIGHT 40
+#define OVERLAY_GRAPH_MAX_TIME (SDL_NS_PER_SECOND / 30) // top of the graph
+
+static const SDL_Color overlay_bg_color = {0, 0, 0, 192};
+static const SDL_Color overlay_line_color = {255, 255, 255, 96}; // at 60 FPS
+static const SDL_Color overlay_update_color = {41, 173, 255, 255};
+static const SDL_Color overlay_draw_color = {0, 228, 54, 255};
+static const SDL_Color overlay_present_color = {255, 163, 0, 255};
+
+static int compare_times(const void* a, const void* b) {
+  Uint64 x = *(const Uint64*) a;
+  Uint64 y = *(const Uint64*) b;
+  return (x > y) - (x < y);
+}
+
+// fills the text lines: average frame time, 1% and 0.1% low frame times
+// (99th and 99.9th percentiles) and Lua memory
+static void overlay_refresh(smgf* const c) {
+  smgf_overlay* const o = &c->overlay;
+  smgf_frame_times* const f = &c->frame_times;
+
+  double mean = 0, variance = 0;
+  sf_sy_get_frame_time(c, &mean, &variance);
+
+  double low_1 = 0, low_01 = 0;
+  if (f->count > 0) {
+    Uint64 sorted[NB_FRAME_TIMES];
+    SDL_memcpy(sorted, f->times, f->count * sizeof(Uint64));
+    SDL_qsort(sorted, f->count, sizeof(Uint64), compare_times);
+    low_1 = (double) sorted[(f->count - 1) * 99 / 100] / SDL_NS_PER_MS;
+    low_01 = (double) sorted[(f->count - 1) * 999 / 1000] / SDL_NS_PER_MS;
+  }
+
+  SDL_snprintf(
+      o->lines[0], sizeof(o->lines[0]), "%5.2fms %5.1f FPS", mean * 1000,
+      mean > 0 ? 1 / mean : 0);
+  SDL_snprintf(
+      o->lines[1], sizeof(o->lines[1]), "1%% %5.2f .1%% %5.2f", low_1,
+      low_01);
+  SDL_snprintf(
+      o->lines[2], sizeof(o->lines[2]), "Lua %d KiB",
+      (int) (c->last_stats.lua_memory / 1024));
+}
+
+// adds the rectangle of a bar of the graph, "time" high, above "y"
+static int overlay_add_bar(
+    SDL_FRect* rects, SDL_Color* colors, int n, float x, float* y,
+    Uint64 time, SDL_Color color) {
+  float h = (float) time * OVERLAY_GRAPH_HEIGHT / OVERLAY_GRAPH_MAX_TIME;
+  if (h <= 0) {
+    return n;
+  }
+
+  *y -= h;
+  rects[n].x = x;
+  rects[n].y = *y;
+  rects[n].w = 1;
+  rects[n].h = h;
+  colors[n] = color;
+  return n + 1;
+}
+
+void smgf_draw_overlay(smgf* const c) {
+  smgf_overlay* const o = &c->overlay;
+  smgf_frame_times* const f = &c->frame_times;
+
+  if (o->refresh_countdown <= 0) {
+    overlay_refresh(c);
+    o->refresh_countdown = OVERLAY_REFRESH_FRAMES;
+  }
+  o->refresh_countdown -= 1;
+
+  int graph_w = SDL_min(
+      OVERLAY_GRAPH_WIDTH,
+      c->width - 2 * (OVERLAY_MARGIN + OVERLAY_PADDING));
+  graph_w = SDL_max(0, graph_w);
+  int nb_frames = SDL_min(f->count, graph_w);
+  float x0 = OVERLAY_MARGIN + OVERLAY_PADDING;
+  float y0 = OVERLAY_MARGIN + OVERLAY_PADDING;
+  float graph_y = y0 + OVERLAY_NB_LINES * TEXT_GLYPH_HEIGHT;
+
+  // background + 60 FPS line + 3 bars per frame
+  int max_rects = 2 + 3 * nb_frames;
+  SDL_FRect* rects = sf_gr_scratch_reserve(
+      &c->draw_buffer, (sizeof(SDL_FRect) + sizeof(SDL_Color)) * max_rects);
+  if (rects == NULL) {
+    return;
+  }
+  SDL_Color* colors = (SDL_Color*) (rects + max_rects);
+
+  rects[0].x = OVERLAY_MARGIN;
+  rects[0].y = OVERLAY_MARGIN;
+  rects[0].w = SDL_max(graph_w, OVERLAY_TEXT_WIDTH) + 2 * OVERLAY_PADDING;
+  rects[0].h = graph_y + OVERLAY_GRAPH_HEIGHT + OVERLAY_PADDING - rects[0].y;
+  colors[0] = overlay_bg_color;
+
+  rects[1].x = x0;
+  rects[1].y = graph_y + OVERLAY_GRAPH_HEIGHT / 2;
+  rects[1].w = graph_w;
+  rects[1].h = 1;
+  colors[1] = overlay_line_color;
+
+  // bars, from the oldest frame (left) to the newest one (right)
+  int n = 2;
+  for (int i = 0; i < nb_frames; i++) {
+    int frame = (f->next - nb_frames + i + NB_FRAME_TIMES) % NB_FRAME_TIMES;
+    float x = x0 + graph_w - nb_frames + i;
+    float y = graph_y + OVERLAY_GRAPH_HEIGHT;
+    n = overlay_add_bar(
+        rects, colors, n, x, &y, f->update_times[frame],
+        overlay_update_color);
+    n = overlay_add_bar(
+        rects, colors, n, x, &y, f->draw_times[frame], overlay_draw_color);
+    n = overlay_add_bar(
+        rects, colors, n, x, &y, f->present_times[frame],
+        overlay_present_color);
+  }
+
+  // bars taller than the graph are cut
+  for (int i = 2; i < n; i++) {
+    if (rects[i].y < graph_y) {
+      rects[i].h = SDL_max(0, rects[i].h - (graph_y - rects[i].y));
+      rects[i].y = graph_y;
+    }
+  }
+
+  SDL_BlendMode blend_mode = SDL_BLENDMODE_BLEND;
+  sf_gr_get_blend_mode(c, &blend_mode);
+  sf_gr_reset_graphics_stack(c);
+  sf_gr_set_target(c, NULL);
+  sf_gr_set_blend_mode(c, SDL_BLENDMODE_BLEND);
+
+  sf_gr_draw_rectfills(c, rects, colors, n);
+
+  SDL_Color transparent = {0, 0, 0, 0};
+  for (int i = 0; i < OVERLAY_NB_LINES; i++) {
+    sf_gr_print(
+        c, x0, y0 + i * TEXT_GLYPH_HEIGHT, o->lines[i], transparent);
+  }
+
+  sf_gr_set_blend_mode(c, blend_mode);
+}
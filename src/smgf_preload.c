@@ -0,0 +1,212 @@
+#include "smgf.h"
+#include "api.h"
+
+// the game archive can be mounted from memory (conf.preload), so that its
+// entries are read without seeking in the file on disk. It is memory-mapped
+// when possible (the system then reads the pages when needed), else it is
+// read at once.
+//
+// the read-ahead thread (conf.read_ahead) reads the files of the game in
+// directory order and discards their data, so that the next loads of these
+// files are served by the system cache (or by the pages already mapped). It
+// reads the game folder (or archive) directly rather than through PhysFS,
+// whose search path is changed by the main thread (see sf_sy_set_identity).
+
+#define READ_AHEAD_CHUNK_SIZE (64 * 1024)
+#define READ_AHEAD_PATH_SIZE 1024
+
+typedef struct read_ahead_state {
+  smgf_preload* p;
+  Uint8* chunk;
+  int nb_files;
+  Uint64 nb_bytes;
+} read_ahead_state;
+
+// mounts the game archive from memory, in place of the file. Games which are
+// directories are left as they are.
+int smgf_preload_game(smgf* const c, const char* game_folder) {
+  smgf_preload* const p = &c->preload;
+  SDL_PathInfo info;
+  if (!SDL_GetPathInfo(game_folder, &info) || info.type != SDL_PATHTYPE_FILE) {
+    SDL_Log("%s is not an archive, not preloaded", game_folder);
+    return 0;
+  }
+
+  sbuffer* const b = &p->archive;
+  if (sf_bf_map(b, game_folder) != 0) {
+    size_t size = 0;
+    void* data = SDL_LoadFile(game_folder, &size);
+    if (data == NULL) {
+      smgf_set_error(
+          c, "Error preloading %s: %s", game_folder, SDL_GetError());
+      return 1;
+    }
+    b->data = data;
+    b->length = size;
+    b->type = SBUFFER_U8;
+    b->storage = SBUFFER_HEAP;
+  }
+
+  // the memory is released by smgf_preload_clear, after unmounting
+  if (PHYSFS_unmount(game_folder) == 0 ||
+      PHYSFS_mountMemory(b->data, b->length, NULL, game_folder, "/", 1) == 0) {
+    int error_code = PHYSFS_getLastErrorCode();
+    smgf_set_error(
+        c, "Error mounting %s in memory: %s (%d)", game_folder,
+        PHYSFS_getErrorByCode(error_code), error_code);
+    sf_bf_del(b);
+    return 1;
+  }
+  p->mounted_path = SDL_strdup(game_folder);
+  c->mount_generation += 1;
+
+  SDL_Log(
+      "mounted %s from memory (%s, %d KiB)", game_folder,
+      b->storage == SBUFFER_MAPPED ? "mapped" : "read",
+      (int) (b->length / 1024));
+  return 0;
+}
+
+// reads a file of the game, and discards its data
+static void read_ahead_file(read_ahead_state* ra, const char* path) {
+  SDL_IOStream* f = SDL_IOFromFile(path, "rb");
+  if (f == NULL) {
+    return;
+  }
+
+  size_t n = 0;
+  do {
+    n = SDL_ReadIO(f, ra->chunk, READ_AHEAD_CHUNK_SIZE);
+    ra->nb_bytes += n;
+  } while (n == READ_AHEAD_CHUNK_SIZE && !SDL_GetAtomicInt(&ra->p->stop));
+  SDL_CloseIO(f);
+  ra->nb_files += 1;
+}
+
+static bool read_ahead_dir(read_ahead_state* ra, const char* dir);
+
+// a pass over a directory: files first, then subdirectories
+typedef struct read_ahead_pass {
+  read_ahead_state* ra;
+  int pass;
+} read_ahead_pass;
+
+static SDL_EnumerationResult read_ahead_entry(
+    void* data, const char* dir, const char* name) {
+  read_ahead_pass* const rp = (read_ahead_pass*) data;
+  read_ahead_state* const ra = rp->ra;
+  if (SDL_GetAtomicInt(&ra->p->stop)) {
+    return SDL_ENUM_FAILURE;
+  }
+
+  // the directory ends with a separator
+  char path[READ_AHEAD_PATH_SIZE];
+  int len = SDL_snprintf(path, sizeof(path), "%s%s", dir, name);
+  SDL_PathInfo info;
+  if (len < 0 || len >= (int) sizeof(path) || !SDL_GetPathInfo(path, &info)) {
+    return SDL_ENUM_CONTINUE;
+  }
+  if (rp->pass == 0 && info.type == SDL_PATHTYPE_FILE) {
+    read_ahead_file(ra, path);
+  } else if (rp->pass == 1 && info.type == SDL_PATHTYPE_DIRECTORY) {
+    if (!read_ahead_dir(ra, path)) {
+      return SDL_ENUM_FAILURE;
+    }
+  }
+  return SDL_ENUM_CONTINUE;
+}
+
+// reads the files of a directory of the game, then its subdirectories.
+// Returns false if the thread was asked to stop.
+static bool read_ahead_dir(read_ahead_state* ra, const char* dir) {
+  for (int pass = 0; pass < 2; pass++) {
+    read_ahead_pass rp = {.ra = ra, .pass = pass};
+    SDL_EnumerateDirectory(dir, read_ahead_entry, &rp);
+    if (SDL_GetAtomicInt(&ra->p->stop)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static int read_ahead_thread(void* data) {
+  smgf_preload* const p = (smgf_preload*) data;
+  SDL_SetCurrentThreadPriority(SDL_THREAD_PRIORITY_LOW);
+
+  read_ahead_state ra = {.p = p};
+  ra.chunk = SDL_malloc(READ_AHEAD_CHUNK_SIZE);
+  if (ra.chunk == NULL) {
+    return 1;
+  }
+
+  Uint64 start = SDL_GetTicksNS();
+  bool done = true;
+  SDL_PathInfo info;
+  if (SDL_GetPathInfo(p->game_path, &info)) {
+    if (info.type == SDL_PATHTYPE_FILE) {
+      read_ahead_file(&ra, p->game_path); // archive
+      done = !SDL_GetAtomicInt(&p->stop);
+    } else {
+      done = read_ahead_dir(&ra, p->game_path);
+    }
+  }
+  SDL_free(ra.chunk);
+
+  SDL_Log(
+      "read ahead %d files (%d KiB) in %.1f ms%s", ra.nb_files,
+      (int) (ra.nb_bytes / 1024),
+      (double) (SDL_GetTicksNS() - start) / SDL_NS_PER_MS,
+      done ? "" : " (stopped)");
+  return 0;
+}
+
+// starts reading the files of the game in the background
+int smgf_read_ahead_start(smgf* const c, const char* game_folder) {
+  smgf_preload* const p = &c->preload;
+  if (p->archive.storage == SBUFFER_HEAP) {
+    return 0; // already in memory
+  }
+
+  p->game_path = SDL_strdup(game_folder);
+  if (p->game_path == NULL) {
+    return -1;
+  }
+  SDL_SetAtomicInt(&p->stop, 0);
+  p->read_ahead = SDL_CreateThread(read_ahead_thread, "smgf_read_ahead", p);
+  if (p->read_ahead == NULL) {
+    SDL_LogWarnC("cannot start read-ahead thread (%s)", SDL_GetError());
+    return -1;
+  }
+  return 0;
+}
+
+// stops the read-ahead thread, if it is running
+void smgf_read_ahead_stop(smgf* const c) {
+  smgf_preload* const p = &c->preload;
+  if (p->read_ahead != NULL) {
+    SDL_SetAtomicInt(&p->stop, 1);
+    SDL_WaitThread(p->read_ahead, NULL);
+    p->read_ahead = NULL;
+  }
+  SDL_free(p->game_path);
+  p->game_path = NULL;
+}
+
+// stops the read-ahead thread, and unmounts the game if it is in memory
+void smgf_preload_clear(smgf* const c) {
+  smgf_preload* const p = &c->preload;
+  smgf_read_ahead_stop(c);
+
+  if (p->mounted_path != NULL) {
+    if (PHYSFS_unmount(p->mounted_path) == 0) {
+      // files of the archive are still open: the memory is kept
+      SDL_LogWarnC(
+          "cannot unmount %s (%s)", p->mounted_path,
+          PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode()));
+    } else {
+      sf_bf_del(&p->archive);
+    }
+    SDL_free(p->mounted_path);
+    p->mounted_path = NULL;
+  }
+}
@@ -0,0 +1,179 @@
+#include "smgf.h"
+#include "api.h"
+
+// the profiler samples the Lua call stack at a fixed interval. An SDL timer
+// only sets a flag (from its own thread), and the call stack is read by a
+// count hook on the Lua thread, so that the Lua state is never accessed from
+// another thread. When the flag is not set, the hook only reads it.
+//
+// Time spent in C functions (drawing, loading files...) is counted in the Lua
+// function that called them, as the hook runs when this function resumes.
+
+static Uint64 SDLCALL
+profiler_timer(void* userdata, SDL_TimerID timer, Uint64 interval) {
+  smgf_profiler* const p = userdata;
+  SDL_SetAtomicInt(&p->sample_requested, 1);
+  return interval;
+}
+
+// appends the name of a function to the call stack, as "name (file:line)".
+// ';' are replaced, as they separate function names in folded stacks.
+static size_t profiler_append_frame(
+    char* stack, size_t len, size_t size, lua_Debug* ar) {
+  const char* name = ar->name != NULL ? ar->name : "?";
+  int n = 0;
+  if (*ar->what == 'C') {
+    n = SDL_snprintf(stack + len, size - len, "%s [C]", name);
+  } else if (*ar->what == 'm') {
+    n = SDL_snprintf(stack + len, size - len, "main (%s)", ar->short_src);
+  } else {
+    n = SDL_snprintf(
+        stack + len, size - len, "%s (%s:%d)", name, ar->short_src,
+        ar->linedefined);
+  }
+  if (n < 0) {
+    return len;
+  }
+
+  size_t end = SDL_min(len + n, size - 1);
+  for (size_t i = len; i < end; i++) {
+    if (stack[i] == ';') {
+      stack[i] = ',';
+    }
+  }
+  return end;
+}
+
+static void profiler_add_sample(smgf_profiler* const p, const char* stack) {
+  Uint32 hash = smgf_hash_fnv1a(SMGF_FNV1A_INIT, stack, SDL_strlen(stack));
+  sprofile_entry** bucket = &p->buckets[hash % PROFILER_NB_BUCKETS];
+
+  for (sprofile_entry* e = *bucket; e != NULL; e = e->next) {
+    if (e->hash == hash && SDL_strcmp(e->stack, stack) == 0) {
+      e->nb_samples += 1;
+      p->nb_samples += 1;
+      return;
+    }
+  }
+
+  sprofile_entry* e = SDL_malloc(sizeof(sprofile_entry));
+  if (e == NULL) {
+    return;
+  }
+  e->stack = SDL_strdup(stack);
+  if (e->stack == NULL) {
+    SDL_free(e);
+    return;
+  }
+  e->hash = hash;
+  e->nb_samples = 1;
+  e->next = *bucket;
+  *bucket = e;
+  p->nb_samples += 1;
+}
+
+static void profiler_hook(lua_State* L, lua_Debug* hook_ar) {
+  smgf* const c = get_smgf(L);
+  if (c == NULL) {
+    return;
+  }
+  smgf_profiler* const p = &c->profiler;
+  if (!SDL_CompareAndSwapAtomicInt(&p->sample_requested, 1, 0)) {
+    return;
+  }
+
+  lua_Debug ar;
+  int depth = 0;
+  while (depth < PROFILER_MAX_DEPTH && lua_getstack(L, depth, &ar)) {
+    depth += 1;
+  }
+
+  // from the outermost function to the current one
+  size_t len = 0;
+  for (int level = depth - 1; level >= 0; level--) {
+    if (!lua_getstack(L, level, &ar) || !lua_getinfo(L, "Sn", &ar)) {
+      continue;
+    }
+    if (len > 0 && len < PROFILER_STACK_SIZE - 1) {
+      p->stack[len++] = ';';
+    }
+    len = profiler_append_frame(p->stack, len, PROFILER_STACK_SIZE, &ar);
+  }
+  p->stack[len] = '\0';
+
+  if (len > 0) {
+    profiler_add_sample(p, p->stack);
+  }
+}
+
+// starts sampling the Lua code every "interval" nanoseconds
+int smgf_profiler_start(smgf* const c, Uint64 interval) {
+  smgf_profiler* const p = &c->profiler;
+  if (p->timer != 0) {
+    SDL_SetError("profiler is already running");
+    return -1;
+  }
+
+  SDL_SetAtomicInt(&p->sample_requested, 0);
+  p->timer = SDL_AddTimerNS(interval, profiler_timer, p);
+  if (p->timer == 0) {
+    return -1;
+  }
+
+  lua_sethook(c->L, profiler_hook, LUA_MASKCOUNT, PROFILER_HOOK_COUNT);
+  return 0;
+}
+
+// frees the samples, and stops sampling
+void smgf_profiler_clear(smgf* const c) {
+  smgf_profiler* const p = &c->profiler;
+  if (p->timer != 0) {
+    SDL_RemoveTimer(p->timer);
+    p->timer = 0;
+    if (c->L != NULL) {
+      lua_sethook(c->L, NULL, 0, 0);
+    }
+  }
+
+  for (int i = 0; i < PROFILER_NB_BUCKETS; i++) {
+    sprofile_entry* e = p->buckets[i];
+    while (e != NULL) {
+      sprofile_entry* next = e->next;
+      SDL_free(e->stack);
+      SDL_free(e);
+      e = next;
+    }
+    p->buckets[i] = NULL;
+  }
+  p->nb_samples = 0;
+}
+
+// stops sampling, and writes one line per call stack ("f1;f2;f3 nb_samples")
+// in a file of the write directory. Samples are freed.
+int smgf_profiler_stop(smgf* const c, const char* filename) {
+  smgf_profiler* const p = &c->profiler;
+  if (p->timer == 0) {
+    SDL_SetError("profiler is not running");
+    return -1;
+  }
+
+  SDL_RemoveTimer(p->timer);
+  p->timer = 0;
+  lua_sethook(c->L, NULL, 0, 0);
+
+  SDL_IOStream* f = PHYSFSSDL3_openWrite(filename);
+  if (f == NULL) {
+    smgf_profiler_clear(c);
+    return -1;
+  }
+
+  for (int i = 0; i < PROFILER_NB_BUCKETS; i++) {
+    for (sprofile_entry* e = p->buckets[i]; e != NULL; e = e->next) {
+      SDL_IOprintf(f, "%s %" SDL_PRIu64 "\n", e->stack, e->nb_samples);
+    }
+  }
+
+  bool result = SDL_CloseIO(f);
+  smgf_profiler_clear(c);
+  return result ? 0 : -1;
+}